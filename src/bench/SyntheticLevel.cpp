@@ -0,0 +1,96 @@
+#include "SyntheticLevel.h"
+#include <algorithm>
+#include <filesystem>
+#include <random>
+
+using namespace vle;
+
+Project vle::generateSyntheticProject(const SyntheticLevelSettings& settings, const std::string& assetDirectory)
+{
+	namespace fs = std::filesystem;
+	std::mt19937 random(settings.seed);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	fs::create_directories(assetDirectory);
+
+	Project project;
+	project.level.levelNameId = "synthetic_" + std::to_string(settings.objectCount);
+
+	List<std::string> assetIDs;
+	for (size_t i = 0; i < settings.assetCount; i++)
+	{
+		const unsigned int side = 16 + static_cast<unsigned int>(unit(random) * 112.f);
+		const sf::Color color(static_cast<std::uint8_t>(random()), static_cast<std::uint8_t>(random()), static_cast<std::uint8_t>(random()));
+		sf::Image image({ side, side }, color);
+		const std::string assetID = "asset_" + std::to_string(i);
+		const fs::path texturePath = fs::path(assetDirectory) / (assetID + ".png");
+		if (!fs::exists(texturePath))
+		{
+			(void)image.saveToFile(texturePath);
+		}
+		auto asset = std::make_unique<Asset>();
+		asset->texturePath = texturePath.string();
+		project.assets[assetID] = std::move(asset);
+		assetIDs.push_back(assetID);
+	}
+
+	project.level.gameObjects.Reserve(settings.objectCount);
+	for (size_t i = 0; i < settings.objectCount && !assetIDs.empty(); i++)
+	{
+		GameObject object;
+		object.assetID = assetIDs[random() % assetIDs.size()];
+		object.position = { unit(random) * settings.levelSize.x, unit(random) * settings.levelSize.y };
+		const float scale = 0.5f + unit(random);
+		object.scale = { scale, scale };
+		object.rotation = sf::degrees(unit(random) * 360.f);
+		project.level.gameObjects.Add(object);
+	}
+
+	project.level.hitboxMap.reserve(settings.chainCount);
+	for (size_t i = 0; i < settings.chainCount; i++)
+	{
+		sf::VertexArray chain(sf::PrimitiveType::LineStrip);
+		sf::Vector2f point{ unit(random) * settings.levelSize.x, unit(random) * settings.levelSize.y };
+		for (size_t j = 0; j < settings.chainVertexCount; j++)
+		{
+			chain.append(sf::Vertex{ point, sf::Color::White });
+			point += { (unit(random) - 0.5f) * 16.f, (unit(random) - 0.5f) * 16.f };
+		}
+		project.level.hitboxMap.push_back(std::move(chain));
+	}
+	return project;
+}
+
+sf::Image vle::generateSyntheticHitboxImage(sf::Vector2u size, size_t blobCount, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	List<std::uint8_t> pixels(static_cast<size_t>(size.x) * size.y * 4, 0);
+	for (size_t i = 3; i < pixels.size(); i += 4)
+	{
+		pixels[i] = 255;
+	}
+	const float maxRadius = static_cast<float>(std::min(size.x, size.y)) / 16.f;
+	for (size_t blob = 0; blob < blobCount; blob++)
+	{
+		const sf::Vector2f center{ unit(random) * size.x, unit(random) * size.y };
+		const float radius = 4.f + unit(random) * maxRadius;
+		const int top = std::max(0, static_cast<int>(center.y - radius));
+		const int bottom = std::min(static_cast<int>(size.y) - 1, static_cast<int>(center.y + radius));
+		const int left = std::max(0, static_cast<int>(center.x - radius));
+		const int right = std::min(static_cast<int>(size.x) - 1, static_cast<int>(center.x + radius));
+		for (int y = top; y <= bottom; y++)
+		{
+			for (int x = left; x <= right; x++)
+			{
+				const float dx = x - center.x;
+				const float dy = y - center.y;
+				if (dx * dx + dy * dy <= radius * radius)
+				{
+					std::uint8_t* pixel = &pixels[(static_cast<size_t>(y) * size.x + x) * 4];
+					pixel[0] = pixel[1] = pixel[2] = 255;
+				}
+			}
+		}
+	}
+	return sf::Image(size, pixels.data());
+}
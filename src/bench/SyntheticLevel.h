@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <SFML/Graphics.hpp>
+#include "core/Utils.h"
+#include "project/Project.h"
+
+namespace vle {
+	struct SyntheticLevelSettings
+	{
+		size_t objectCount = 1000;
+		size_t assetCount = 16;
+		size_t chainCount = 0;
+		size_t chainVertexCount = 0;
+		sf::Vector2f levelSize = { 7680.f, 4320.f };
+		unsigned int seed = 1;
+	};
+
+	// Builds a reproducible project for benchmarks: assetCount small PNGs are written to
+	// assetDirectory, objects are scattered over the level and chains are random walks.
+	// Objects are not bound to a texture; load the assets and call AssetManager::BindTexture.
+	Project generateSyntheticProject(const SyntheticLevelSettings& settings, const std::string& assetDirectory);
+	// A black hitbox image with blobCount white discs of random size, some overlapping.
+	sf::Image generateSyntheticHitboxImage(sf::Vector2u size, size_t blobCount, unsigned int seed);
+}
@@ -0,0 +1,603 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include <nlohmann/json.hpp>
+#include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
+#include "Vectorizer/Vectorizer.h"
+#include "bench/SyntheticLevel.h"
+#include "core/Utils.h"
+#include "io/ImportExport.h"
+#include "io/Serialization.h"
+#include "level/RankedChains.h"
+#include "project/AssetManager.h"
+#include "render/SpriteBatcher.h"
+
+using namespace vle;
+
+namespace
+{
+	struct BenchOptions
+	{
+		List<size_t> objectCounts = { 1000, 10000, 100000 };
+		size_t frames = 120;
+		size_t chainCount = 256;
+		size_t chainVertexCount = 64;
+		unsigned int hitboxSize = 2048;
+		size_t iterations = 5;
+		std::string assetDirectory = (std::filesystem::temp_directory_path() / "vle-bench-assets").string();
+		std::string jsonPath;
+		std::string baselinePath;
+		double threshold = 0.10;
+	};
+
+	// One measured number. Metrics are compared by name between runs.
+	struct Metric
+	{
+		std::string name;
+		double value;
+		std::string unit;
+		bool lowerIsBetter;
+	};
+
+	struct LoadProbe
+	{
+		double milliseconds;
+		double peakMegabytes;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	void PrintUsage()
+	{
+		std::cout <<
+			"Usage: VoidLevelEditorBench [options]\n"
+			"\n"
+			"Measures synthetic levels: offscreen rendering, picking and culling, project\n"
+			"save/load and level export, streaming against DOM project loading (time and peak\n"
+			"memory, each in a child process), and hitbox vectorization.\n"
+			"\n"
+			"Options:\n"
+			"      --objects <n,...>        Object counts to measure (default: 1000,10000,100000)\n"
+			"      --frames <n>             Frames rendered per measurement (default: 120)\n"
+			"      --chains <n>             Hitbox chains in each level (default: 256)\n"
+			"      --chain-vertices <n>     Vertices per hitbox chain (default: 64)\n"
+			"      --hitbox-size <px>       Side of the traced hitbox image, 0 to skip (default: 2048)\n"
+			"      --iterations <n>         Runs per save/load/export/trace measurement; the median is kept (default: 5)\n"
+			"      --assets <dir>           Directory for the generated asset textures and files\n"
+			"      --json <file>            Write the results as JSON\n"
+			"      --baseline <file>        Compare with the JSON results of an earlier run\n"
+			"      --threshold <percent>    Regression that fails the comparison (default: 10)\n"
+			"  -h, --help                   Show this message\n"
+			"\n"
+			"Exit code: 0 on success, 1 on error, 2 when a metric regressed past the threshold.\n";
+	}
+
+	List<size_t> ParseCounts(const std::string& value)
+	{
+		List<size_t> counts;
+		for (size_t start = 0; start <= value.size();)
+		{
+			size_t end = value.find(',', start);
+			if (end == std::string::npos) end = value.size();
+			counts.push_back(std::max<size_t>(std::stoul(value.substr(start, end - start)), 1));
+			start = end + 1;
+		}
+		return counts;
+	}
+
+	bool ParseArguments(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+			if (arg == "-h" || arg == "--help")
+			{
+				PrintUsage();
+				return false;
+			}
+			if (i + 1 >= argc)
+			{
+				std::cerr << "Error: " << arg << " expects a value" << std::endl;
+				return false;
+			}
+			const std::string value = argv[++i];
+			try
+			{
+				if (arg == "--objects")
+				{
+					options.objectCounts = ParseCounts(value);
+				}
+				else if (arg == "--frames")
+				{
+					options.frames = std::max<size_t>(std::stoul(value), 1);
+				}
+				else if (arg == "--chains")
+				{
+					options.chainCount = std::stoul(value);
+				}
+				else if (arg == "--chain-vertices")
+				{
+					options.chainVertexCount = std::max<size_t>(std::stoul(value), 2);
+				}
+				else if (arg == "--hitbox-size")
+				{
+					options.hitboxSize = static_cast<unsigned int>(std::stoul(value));
+				}
+				else if (arg == "--iterations")
+				{
+					options.iterations = std::max<size_t>(std::stoul(value), 1);
+				}
+				else if (arg == "--assets")
+				{
+					options.assetDirectory = value;
+				}
+				else if (arg == "--json")
+				{
+					options.jsonPath = value;
+				}
+				else if (arg == "--baseline")
+				{
+					options.baselinePath = value;
+				}
+				else if (arg == "--threshold")
+				{
+					options.threshold = std::max(std::stod(value), 0.0) / 100.0;
+				}
+				else
+				{
+					std::cerr << "Error: unknown option " << arg << std::endl;
+					return false;
+				}
+			}
+			catch (const std::exception&)
+			{
+				std::cerr << "Error: invalid value for " << arg << ": " << value << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Renders frames and returns the average milliseconds per frame. glFinish makes
+	// the measurement include the GPU work, not just the time spent submitting it.
+	template<typename DrawFrame>
+	double MeasureFrames(sf::RenderTexture& target, size_t frames, DrawFrame&& drawFrame)
+	{
+		Clock::time_point start = Clock::now();
+		for (size_t frame = 0; frame < frames; frame++)
+		{
+			target.clear(sf::Color(50, 50, 50));
+			drawFrame(frame);
+			target.display();
+			glFinish();
+		}
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+	}
+
+	// Runs the operation iterations times and returns the median milliseconds, which a
+	// single slow run (a page cache miss, another process) does not move.
+	template<typename Operation>
+	double MeasureMedian(size_t iterations, Operation&& operation)
+	{
+		List<double> times;
+		for (size_t i = 0; i < iterations; i++)
+		{
+			Clock::time_point start = Clock::now();
+			operation();
+			times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+		std::sort(times.begin(), times.end());
+		return times[times.size() / 2];
+	}
+
+	double MegabytesPerSecond(std::uintmax_t bytes, double milliseconds)
+	{
+		return milliseconds > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / (milliseconds / 1000.0) : 0.0;
+	}
+
+	// High-water mark of the process's resident memory.
+	double PeakResidentMegabytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return static_cast<double>(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+		return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+		return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#endif
+	}
+
+	// Child side of ProbeLoad: loads the project with one loader and prints the median
+	// milliseconds and how far loading raised the peak resident memory.
+	int RunLoadProbe(const std::string& loader, const std::string& path, size_t iterations)
+	{
+		const double baseline = PeakResidentMegabytes();
+		bool ok = true;
+		const double loadMs = MeasureMedian(iterations, [&]()
+			{
+				if (loader != "dom")
+				{
+					ok = ImportExport::load(path).has_value() && ok;
+					return;
+				}
+				// The loader ImportExport::load replaced: a DOM of the whole file, then converted.
+				try
+				{
+					std::ifstream file(path, std::ios::binary);
+					Project project = nlohmann::json::parse(file).get<Project>();
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << "Error: " << e.what() << std::endl;
+					ok = false;
+				}
+			});
+		if (!ok)
+		{
+			return 1;
+		}
+		std::cout << std::fixed << std::setprecision(3) << loadMs << " " << PeakResidentMegabytes() - baseline << std::endl;
+		return 0;
+	}
+
+	// Peak memory only ever grows within a process, so each loader is measured in a
+	// fresh copy of this executable.
+	std::optional<LoadProbe> ProbeLoad(const char* executable, const char* loader, const std::string& path, size_t iterations)
+	{
+		std::ostringstream command;
+		command << '"' << executable << "\" --load-probe " << loader << " \"" << path << "\" " << iterations;
+#ifdef _WIN32
+		// cmd.exe strips the outer pair of quotes.
+		FILE* pipe = _popen(("\"" + command.str() + "\"").c_str(), "r");
+#else
+		FILE* pipe = popen(command.str().c_str(), "r");
+#endif
+		if (!pipe)
+		{
+			return std::nullopt;
+		}
+		LoadProbe probe{};
+		const bool parsed = std::fscanf(pipe, "%lf %lf", &probe.milliseconds, &probe.peakMegabytes) == 2;
+#ifdef _WIN32
+		const int status = _pclose(pipe);
+#else
+		const int status = pclose(pipe);
+#endif
+		if (!parsed || status != 0)
+		{
+			return std::nullopt;
+		}
+		return probe;
+	}
+
+	std::uintmax_t FileSize(const std::string& path)
+	{
+		std::error_code error;
+		const std::uintmax_t size = std::filesystem::file_size(path, error);
+		return error ? 0 : size;
+	}
+
+	void AddMetric(List<Metric>& metrics, const std::string& name, double value, const std::string& unit, bool lowerIsBetter = true)
+	{
+		metrics.push_back(Metric{ name, value, unit, lowerIsBetter });
+	}
+
+	bool WriteResults(const List<Metric>& metrics, const BenchOptions& options, const std::string& path)
+	{
+		nlohmann::json results = nlohmann::json::object();
+		for (const Metric& metric : metrics)
+		{
+			results[metric.name] = nlohmann::json{
+				{"value", metric.value},
+				{"unit", metric.unit},
+				{"better", metric.lowerIsBetter ? "lower" : "higher"}
+			};
+		}
+		nlohmann::json document{
+			{"version", 1},
+			{"settings", {
+				{"objects", options.objectCounts},
+				{"frames", options.frames},
+				{"chains", options.chainCount},
+				{"chainVertices", options.chainVertexCount},
+				{"hitboxSize", options.hitboxSize},
+				{"iterations", options.iterations}
+			}},
+			{"metrics", std::move(results)}
+		};
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << "Error: cannot write " << path << std::endl;
+			return false;
+		}
+		file << document.dump(4) << std::endl;
+		return static_cast<bool>(file);
+	}
+
+	// Prints how every metric of the baseline changed and returns the number that got
+	// worse by more than the threshold, or -1 if the baseline cannot be read.
+	int CompareWithBaseline(const List<Metric>& metrics, const std::string& path, double threshold)
+	{
+		std::ifstream file(path);
+		nlohmann::json baseline = nlohmann::json::parse(file, nullptr, false);
+		if (baseline.is_discarded() || !baseline.contains("metrics"))
+		{
+			std::cerr << "Error: cannot read the baseline " << path << std::endl;
+			return -1;
+		}
+		const nlohmann::json& previous = baseline["metrics"];
+		int regressions = 0;
+		std::cout << "\nCompared with " << path << " (threshold " << threshold * 100.0 << "%):" << std::endl;
+		for (const Metric& metric : metrics)
+		{
+			if (!previous.contains(metric.name) || !previous[metric.name].contains("value"))
+			{
+				continue;
+			}
+			const double before = previous[metric.name]["value"].get<double>();
+			if (before <= 0.0)
+			{
+				continue;
+			}
+			// Positive when the metric got worse, whichever direction is better.
+			const double change = (metric.value - before) / before;
+			const double worse = metric.lowerIsBetter ? change : -change;
+			const bool regressed = worse > threshold;
+			regressions += regressed ? 1 : 0;
+			std::cout << "  " << std::left << std::setw(36) << metric.name << std::right
+				<< std::setw(12) << before << " -> " << std::setw(12) << metric.value << " " << std::setw(6) << metric.unit
+				<< std::showpos << std::setw(10) << change * 100.0 << "%" << std::noshowpos
+				<< (regressed ? "  REGRESSION" : "") << std::endl;
+		}
+		return regressions;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 5 && std::string(argv[1]) == "--load-probe")
+	{
+		return RunLoadProbe(argv[2], argv[3], std::stoul(argv[4]));
+	}
+
+	BenchOptions options;
+	if (!ParseArguments(argc, argv, options))
+	{
+		return 1;
+	}
+
+	sf::RenderTexture target;
+	if (!target.resize({ 1920, 1080 }))
+	{
+		std::cerr << "Error: cannot create the offscreen render target" << std::endl;
+		return 1;
+	}
+
+	List<Metric> metrics;
+	std::cout << std::fixed << std::setprecision(3)
+		<< std::setw(10) << "objects" << std::setw(16) << "per-sprite ms" << std::setw(16) << "batched ms"
+		<< std::setw(16) << "batched+drag ms" << std::setw(10) << "batches"
+		<< std::setw(12) << "pick us" << std::setw(12) << "cull us" << std::endl;
+
+	List<Project> projects;
+	for (size_t objectCount : options.objectCounts)
+	{
+		SyntheticLevelSettings settings;
+		settings.objectCount = objectCount;
+		settings.chainCount = options.chainCount;
+		settings.chainVertexCount = options.chainVertexCount;
+		Project project = generateSyntheticProject(settings, options.assetDirectory);
+
+		AssetManager::Get().Clear();
+		for (const auto& assetPair : project.assets)
+		{
+			AssetManager::Get().LoadTexture(assetPair.first, assetPair.second->texturePath);
+		}
+		GameObjectStore& objects = project.level.gameObjects;
+		for (size_t i = 0; i < objects.GetCount(); i++)
+		{
+			AssetManager::Get().BindTexture(objects, i);
+		}
+		project.level.spatialIndex.Rebuild(objects);
+		target.setView(sf::View(settings.levelSize / 2.f, settings.levelSize));
+
+		// Baseline: one sf::Sprite and one draw call per object.
+		static const sf::Texture unboundTexture;
+		List<sf::Sprite> sprites;
+		sprites.reserve(objects.GetCount());
+		for (size_t i = 0; i < objects.GetCount(); i++)
+		{
+			sf::Sprite& sprite = sprites.emplace_back(unboundTexture);
+			AssetManager::Get().BindTexture(sprite, objects.GetAssetID(i));
+			sprite.setPosition(objects.GetPositions()[i]);
+			sprite.setScale(objects.GetScales()[i]);
+			sprite.setRotation(objects.GetRotations()[i]);
+		}
+		const double perSpriteMs = MeasureFrames(target, options.frames, [&](size_t)
+			{
+				for (const sf::Sprite& sprite : sprites)
+				{
+					target.draw(sprite);
+				}
+			});
+
+		SpriteBatcher batcher;
+		batcher.Update(objects);
+		const double batchedMs = MeasureFrames(target, options.frames, [&](size_t)
+			{
+				batcher.Update(objects);
+				target.draw(batcher);
+			});
+
+		// One object moves every frame, like dragging a selection in the viewport.
+		const double dragMs = MeasureFrames(target, options.frames, [&](size_t frame)
+			{
+				const size_t dragged = frame % objects.GetCount();
+				objects.SetPosition(dragged, objects.GetPositions()[dragged] + sf::Vector2f(1.f, 0.f));
+				batcher.MarkDirty(dragged);
+				batcher.Update(objects);
+				target.draw(batcher);
+			});
+
+		// Clicks and a 1080p viewport at random places of the level, as the editor does every frame.
+		std::mt19937 random(settings.seed);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		const size_t queries = 1000;
+		size_t picked = 0;
+		Clock::time_point pickStart = Clock::now();
+		for (size_t i = 0; i < queries; i++)
+		{
+			const sf::Vector2f point{ unit(random) * settings.levelSize.x, unit(random) * settings.levelSize.y };
+			picked += !project.level.spatialIndex.Pick(point).IsNull();
+		}
+		const double pickUs = std::chrono::duration<double, std::micro>(Clock::now() - pickStart).count() / queries;
+		List<GameObjectHandle> visible;
+		Clock::time_point cullStart = Clock::now();
+		for (size_t i = 0; i < queries; i++)
+		{
+			visible.clear();
+			const sf::Vector2f corner{ unit(random) * (settings.levelSize.x - 1920.f), unit(random) * (settings.levelSize.y - 1080.f) };
+			project.level.spatialIndex.Query(sf::FloatRect(corner, { 1920.f, 1080.f }), visible);
+			batcher.Cull(objects, visible);
+		}
+		const double cullUs = std::chrono::duration<double, std::micro>(Clock::now() - cullStart).count() / queries;
+		(void)picked;
+
+		std::cout << std::setw(10) << objectCount << std::setw(16) << perSpriteMs << std::setw(16) << batchedMs
+			<< std::setw(16) << dragMs << std::setw(10) << batcher.GetBatchCount()
+			<< std::setw(12) << pickUs << std::setw(12) << cullUs << std::endl;
+
+		const std::string suffix = "@" + std::to_string(objectCount);
+		AddMetric(metrics, "render.per_sprite" + suffix, perSpriteMs, "ms");
+		AddMetric(metrics, "render.batched" + suffix, batchedMs, "ms");
+		AddMetric(metrics, "render.batched_drag" + suffix, dragMs, "ms");
+		AddMetric(metrics, "pick" + suffix, pickUs, "us");
+		AddMetric(metrics, "cull" + suffix, cullUs, "us");
+		projects.push_back(std::move(project));
+	}
+
+	std::cout << "\n" << std::setw(10) << "objects" << std::setw(12) << "save ms" << std::setw(12) << "save MB/s"
+		<< std::setw(12) << "load ms" << std::setw(12) << "load MB/s" << std::setw(12) << "export ms"
+		<< std::setw(12) << "export MB/s" << std::setw(12) << "binary ms" << std::endl;
+	for (const Project& project : projects)
+	{
+		const size_t objectCount = project.level.gameObjects.GetCount();
+		const std::string base = (std::filesystem::path(options.assetDirectory) / ("level_" + std::to_string(objectCount))).string();
+		const std::string projectPath = base + ".vle.json";
+		const std::string exportPath = base + ".json";
+		const std::string binaryPath = base + ".vlb";
+
+		bool ok = true;
+		const double saveMs = MeasureMedian(options.iterations, [&]() { ok = ImportExport::save(project, projectPath) && ok; });
+		const double loadMs = MeasureMedian(options.iterations, [&]() { ok = ImportExport::load(projectPath).has_value() && ok; });
+		const double exportMs = MeasureMedian(options.iterations, [&]() { ok = ImportExport::exportLevel(project.level, exportPath) && ok; });
+		const double binaryMs = MeasureMedian(options.iterations, [&]() { ok = ImportExport::exportLevelBinary(project.level, binaryPath) && ok; });
+		if (!ok)
+		{
+			std::cerr << "Error: writing or reading the files of level " << objectCount << " failed" << std::endl;
+			return 1;
+		}
+		const double saveRate = MegabytesPerSecond(FileSize(projectPath), saveMs);
+		const double loadRate = MegabytesPerSecond(FileSize(projectPath), loadMs);
+		const double exportRate = MegabytesPerSecond(FileSize(exportPath), exportMs);
+
+		std::cout << std::setw(10) << objectCount << std::setw(12) << saveMs << std::setw(12) << saveRate
+			<< std::setw(12) << loadMs << std::setw(12) << loadRate << std::setw(12) << exportMs
+			<< std::setw(12) << exportRate << std::setw(12) << binaryMs << std::endl;
+
+		const std::string suffix = "@" + std::to_string(objectCount);
+		AddMetric(metrics, "save" + suffix, saveMs, "ms");
+		AddMetric(metrics, "save_rate" + suffix, saveRate, "MB/s", false);
+		AddMetric(metrics, "load" + suffix, loadMs, "ms");
+		AddMetric(metrics, "load_rate" + suffix, loadRate, "MB/s", false);
+		AddMetric(metrics, "export" + suffix, exportMs, "ms");
+		AddMetric(metrics, "export_rate" + suffix, exportRate, "MB/s", false);
+		AddMetric(metrics, "export_binary" + suffix, binaryMs, "ms");
+	}
+
+	std::cout << "\n" << std::setw(10) << "objects" << std::setw(12) << "DOM ms" << std::setw(14) << "DOM peak MB"
+		<< std::setw(12) << "SAX ms" << std::setw(14) << "SAX peak MB" << std::endl;
+	for (const Project& project : projects)
+	{
+		const size_t objectCount = project.level.gameObjects.GetCount();
+		const std::string projectPath = (std::filesystem::path(options.assetDirectory) / ("level_" + std::to_string(objectCount) + ".vle.json")).string();
+		const std::optional<LoadProbe> dom = ProbeLoad(argv[0], "dom", projectPath, options.iterations);
+		const std::optional<LoadProbe> sax = ProbeLoad(argv[0], "sax", projectPath, options.iterations);
+		if (!dom || !sax)
+		{
+			std::cerr << "Error: the load probes of level " << objectCount << " failed" << std::endl;
+			return 1;
+		}
+		std::cout << std::setw(10) << objectCount << std::setw(12) << dom->milliseconds << std::setw(14) << dom->peakMegabytes
+			<< std::setw(12) << sax->milliseconds << std::setw(14) << sax->peakMegabytes << std::endl;
+
+		const std::string suffix = "@" + std::to_string(objectCount);
+		AddMetric(metrics, "load_dom" + suffix, dom->milliseconds, "ms");
+		AddMetric(metrics, "load_dom_peak_rss" + suffix, dom->peakMegabytes, "MB");
+		AddMetric(metrics, "load_sax" + suffix, sax->milliseconds, "ms");
+		AddMetric(metrics, "load_sax_peak_rss" + suffix, sax->peakMegabytes, "MB");
+	}
+
+	if (options.hitboxSize > 0)
+	{
+		// Traced directly, without the VectorizationCache, which would turn every run after the first into a hit.
+		const sf::Vector2u size{ options.hitboxSize, options.hitboxSize };
+		const std::string hitboxPath = (std::filesystem::path(options.assetDirectory) / ("hitbox_" + std::to_string(options.hitboxSize) + ".png")).string();
+		if (!std::filesystem::exists(hitboxPath) && !generateSyntheticHitboxImage(size, 64, 1).saveToFile(hitboxPath))
+		{
+			std::cerr << "Error: cannot write " << hitboxPath << std::endl;
+			return 1;
+		}
+		size_t chainCount = 0;
+		const double traceMs = MeasureMedian(std::min<size_t>(options.iterations, 3), [&]()
+			{
+				chainCount = Vectorizer::vectorizeImage(hitboxPath, RankedChains::kTraceSimplifyIndex).size();
+			});
+		const double megapixels = static_cast<double>(size.x) * size.y / 1e6;
+		std::cout << "\nvectorize " << size.x << "x" << size.y << ": " << traceMs << " ms, "
+			<< traceMs / megapixels << " ms/MP, " << chainCount << " chain(s)" << std::endl;
+		AddMetric(metrics, "vectorize_per_mp", traceMs / megapixels, "ms/MP");
+	}
+
+	if (!options.jsonPath.empty() && !WriteResults(metrics, options, options.jsonPath))
+	{
+		return 1;
+	}
+	if (!options.baselinePath.empty())
+	{
+		const int regressions = CompareWithBaseline(metrics, options.baselinePath, options.threshold);
+		if (regressions < 0)
+		{
+			return 1;
+		}
+		if (regressions > 0)
+		{
+			std::cout << regressions << " metric(s) regressed by more than " << options.threshold * 100.0 << "%" << std::endl;
+			return 2;
+		}
+	}
+	return 0;
+}
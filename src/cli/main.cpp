@@ -0,0 +1,510 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include "core/ThreadPool.h"
+#include "core/Utils.h"
+#include "io/BinaryLevel.h"
+#include "io/ImportExport.h"
+#include "io/Serialization.h"
+#include "level/VectorizationCache.h"
+
+using namespace vle;
+
+namespace
+{
+	struct CliOptions
+	{
+		List<std::string> projectPaths;
+		std::string outputDir;
+		size_t jobs = std::thread::hardware_concurrency();
+		bool validateOnly = false;
+		bool revectorize = false;
+		bool closeLoops = false;
+		bool binary = false;
+		bool verifyBinary = false;
+		HitboxEncodingOptions encoding;
+	};
+
+	struct FileReport
+	{
+		bool ok = false;
+		List<std::string> errors;
+		List<std::string> warnings;
+		double loadMs = 0.0;
+		double vectorizeMs = 0.0;
+		double exportMs = 0.0;
+		double totalMs = 0.0;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	void PrintUsage()
+	{
+		std::cout <<
+			"Usage: vle-cli [options] <project.json>...\n"
+			"\n"
+			"Loads, validates and exports VoidLevelEditor projects without opening a window.\n"
+			"\n"
+			"Options:\n"
+			"  -o, --output-dir <dir>  Directory for exported levels (default: next to each project)\n"
+			"  -j, --jobs <n>          Number of projects processed in parallel (default: all cores)\n"
+			"      --validate          Load and validate only, do not export\n"
+			"      --revectorize       Re-trace the hitbox map from the project's hitbox image\n"
+			"      --close-loops       Keep the closing vertex of every hitbox chain\n"
+			"      --binary            Also write the memory-mappable binary level (.level.vlb)\n"
+			"      --verify-binary     Write both formats, read the binary level back and compare it to the JSON\n"
+			"      --compact-hitboxes  Write hitbox chains as flat coordinate arrays\n"
+			"      --quantize <step>   Compact, delta-encoded hitboxes snapped to multiples of step\n"
+			"  -h, --help              Show this message\n";
+	}
+
+	bool ParseArguments(int argc, char** argv, CliOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+			if (arg == "-h" || arg == "--help")
+			{
+				PrintUsage();
+				return false;
+			}
+			else if (arg == "-o" || arg == "--output-dir")
+			{
+				if (++i >= argc)
+				{
+					std::cerr << "Error: " << arg << " expects a directory" << std::endl;
+					return false;
+				}
+				options.outputDir = argv[i];
+			}
+			else if (arg == "-j" || arg == "--jobs")
+			{
+				if (++i >= argc)
+				{
+					std::cerr << "Error: " << arg << " expects a number" << std::endl;
+					return false;
+				}
+				try
+				{
+					options.jobs = static_cast<size_t>(std::stoul(argv[i]));
+				}
+				catch (const std::exception&)
+				{
+					std::cerr << "Error: invalid job count:" << argv[i] << std::endl;
+					return false;
+				}
+			}
+			else if (arg == "--validate")
+			{
+				options.validateOnly = true;
+			}
+			else if (arg == "--revectorize")
+			{
+				options.revectorize = true;
+			}
+			else if (arg == "--close-loops")
+			{
+				options.closeLoops = true;
+			}
+			else if (arg == "--binary")
+			{
+				options.binary = true;
+			}
+			else if (arg == "--verify-binary")
+			{
+				options.binary = true;
+				options.verifyBinary = true;
+			}
+			else if (arg == "--compact-hitboxes")
+			{
+				options.encoding.layout = HitboxLayout::Compact;
+			}
+			else if (arg == "--quantize")
+			{
+				if (++i >= argc)
+				{
+					std::cerr << "Error: " << arg << " expects a step" << std::endl;
+					return false;
+				}
+				try
+				{
+					options.encoding.quantizationStep = std::stof(argv[i]);
+				}
+				catch (const std::exception&)
+				{
+					std::cerr << "Error: invalid quantization step:" << argv[i] << std::endl;
+					return false;
+				}
+				if (options.encoding.quantizationStep <= 0.f)
+				{
+					std::cerr << "Error: quantization step must be positive" << std::endl;
+					return false;
+				}
+				options.encoding.layout = HitboxLayout::Compact;
+				options.encoding.deltaEncode = true;
+			}
+			else if (!arg.empty() && arg[0] == '-')
+			{
+				std::cerr << "Error: unknown option " << arg << std::endl;
+				return false;
+			}
+			else
+			{
+				options.projectPaths.push_back(arg);
+			}
+		}
+		if (options.projectPaths.empty())
+		{
+			PrintUsage();
+			return false;
+		}
+		return true;
+	}
+
+	void ValidateProject(const Project& project, FileReport& report)
+	{
+		namespace fs = std::filesystem;
+		if (project.level.levelNameId.empty())
+		{
+			report.warnings.push_back("level name ID is empty");
+		}
+		if (project.backgroundTexturePath.empty())
+		{
+			report.errors.push_back("missing background texture path");
+		}
+		else if (!fs::exists(project.backgroundTexturePath))
+		{
+			report.warnings.push_back("background texture not found: " + project.backgroundTexturePath);
+		}
+		if (project.bHitboxMap && !fs::exists(project.hitboxTexturePath))
+		{
+			report.warnings.push_back("hitbox texture not found: " + project.hitboxTexturePath);
+		}
+		for (const auto& assetPair : project.assets)
+		{
+			if (!assetPair.second)
+			{
+				report.errors.push_back("asset " + assetPair.first + " has no data");
+			}
+			else if (!fs::exists(assetPair.second->texturePath))
+			{
+				report.warnings.push_back("asset " + assetPair.first + " texture not found: " + assetPair.second->texturePath);
+			}
+		}
+		NameTable& assetNames = NameTable::Assets();
+		// Every asset this level's objects use was interned while loading it.
+		List<bool> knownAssets(assetNames.GetCount(), false);
+		for (const auto& assetPair : project.assets)
+		{
+			std::optional<AssetIndex> asset = assetNames.Find(assetPair.first);
+			if (asset.has_value() && asset.value() < knownAssets.size())
+			{
+				knownAssets[asset.value()] = true;
+			}
+		}
+		const GameObjectStore& objects = project.level.gameObjects;
+		for (AssetIndex asset = 0; asset < knownAssets.size(); asset++)
+		{
+			const size_t instances = objects.GetInstanceCount(asset);
+			if (instances > 0 && !knownAssets[asset])
+			{
+				report.errors.push_back(std::to_string(instances) + " game object(s) reference unknown asset " + assetNames.GetName(asset));
+			}
+		}
+	}
+
+	std::string ExportPath(const CliOptions& options, const std::string& projectPath, const char* extension)
+	{
+		namespace fs = std::filesystem;
+		fs::path source(projectPath);
+		fs::path directory = options.outputDir.empty() ? source.parent_path() : fs::path(options.outputDir);
+		return (directory / (source.stem().string() + extension)).string();
+	}
+
+	// Projects are exported in parallel, so two that would write the same file (same name
+	// in different folders with -o, or one listed twice) must be caught up front.
+	bool CheckExportPaths(const CliOptions& options)
+	{
+		namespace fs = std::filesystem;
+		Dictionary<std::string, std::string> exporters;
+		bool distinct = true;
+		for (const std::string& projectPath : options.projectPaths)
+		{
+			const fs::path exportPath = ExportPath(options, projectPath, ".level.json");
+			std::error_code error;
+			fs::path canonical = fs::weakly_canonical(fs::absolute(exportPath), error);
+			const std::string key = error ? exportPath.lexically_normal().string() : canonical.string();
+			auto [found, inserted] = exporters.emplace(key, projectPath);
+			if (!inserted)
+			{
+				std::cerr << "Error: " << found->second << " and " << projectPath << " would both export to " << exportPath.string() << std::endl;
+				distinct = false;
+			}
+		}
+		return distinct;
+	}
+
+	// Reads the binary level back through binary::LevelReader, the way a game would, and
+	// checks that it holds the same level as the JSON export. Quantized JSON points may be
+	// off by half a step.
+	void VerifyBinaryLevel(const std::string& jsonPath, const std::string& binaryPath, float tolerance, FileReport& report)
+	{
+		Level expected;
+		try
+		{
+			std::ifstream jsonFile(jsonPath, std::ios::binary);
+			nlohmann::json::parse(jsonFile).get_to(expected);
+		}
+		catch (const std::exception& e)
+		{
+			report.errors.push_back("verify: cannot read " + jsonPath + ": " + e.what());
+			return;
+		}
+
+		std::ifstream binaryFile(binaryPath, std::ios::binary | std::ios::ate);
+		if (!binaryFile.is_open())
+		{
+			report.errors.push_back("verify: cannot read " + binaryPath);
+			return;
+		}
+		const size_t size = static_cast<size_t>(binaryFile.tellg());
+		// Held in 64 bit words so the data has the alignment LevelReader requires.
+		List<std::uint64_t> buffer((size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+		binaryFile.seekg(0);
+		binaryFile.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(size));
+		binary::LevelReader reader;
+		if (!binaryFile || !reader.Open(buffer.data(), size))
+		{
+			report.errors.push_back(std::string("verify: invalid binary level: ") + reader.GetError());
+			return;
+		}
+
+		auto fail = [&report](const std::string& what)
+			{
+				report.errors.push_back("verify: " + what + " differs between JSON and binary level");
+			};
+		auto near = [](float a, float b, float tolerance)
+			{
+				return std::abs(a - b) <= tolerance + 1e-4f * std::max(1.f, std::abs(a));
+			};
+		if (reader.GetLevelName() != expected.levelNameId)
+		{
+			fail("level name");
+		}
+
+		const List<sf::VertexArray>& chains = expected.hitboxMap;
+		if (reader.GetChainCount() != chains.size())
+		{
+			fail("hitbox chain count");
+			return;
+		}
+		for (uint32_t i = 0; i < reader.GetChainCount(); i++)
+		{
+			const binary::ChainRecord& record = reader.GetChains()[i];
+			const sf::VertexArray& chain = chains[i];
+			if (record.pointCount != chain.getVertexCount() ||
+				record.primitiveType != static_cast<binary::PrimitiveType>(chain.getPrimitiveType()))
+			{
+				fail("hitbox chain " + std::to_string(i));
+				continue;
+			}
+			if (record.pointCount > 0 && record.color != chain[0].color.toInteger())
+			{
+				fail("color of hitbox chain " + std::to_string(i));
+			}
+			const binary::Point* points = reader.GetChainPoints(record);
+			for (uint32_t p = 0; p < record.pointCount; p++)
+			{
+				if (!near(points[p].x, chain[p].position.x, tolerance) || !near(points[p].y, chain[p].position.y, tolerance))
+				{
+					fail("point " + std::to_string(p) + " of hitbox chain " + std::to_string(i));
+					break;
+				}
+			}
+		}
+
+		const GameObjectStore& objects = expected.gameObjects;
+		if (reader.GetGameObjectCount() != objects.GetCount())
+		{
+			fail("game object count");
+			return;
+		}
+		for (uint32_t i = 0; i < reader.GetGameObjectCount(); i++)
+		{
+			const binary::GameObjectRecord& record = reader.GetGameObjects()[i];
+			const GameObject object = objects.Get(i);
+			if (reader.GetAssetID(record) != object.assetID)
+			{
+				fail("asset ID of game object " + std::to_string(i));
+			}
+			if (!near(record.position.x, object.position.x, 0.f) || !near(record.position.y, object.position.y, 0.f) ||
+				!near(record.scale.x, object.scale.x, 0.f) || !near(record.scale.y, object.scale.y, 0.f) ||
+				!near(record.origin.x, object.origin.x, 0.f) || !near(record.origin.y, object.origin.y, 0.f) ||
+				!near(record.rotationDegrees, object.rotation.asDegrees(), 0.f))
+			{
+				fail("transform of game object " + std::to_string(i));
+			}
+		}
+	}
+
+	FileReport ProcessProject(const CliOptions& options, const std::string& projectPath)
+	{
+		FileReport report;
+		Clock::time_point totalStart = Clock::now();
+
+		Clock::time_point stepStart = Clock::now();
+		std::optional<Project> loaded = ImportExport::load(projectPath);
+		report.loadMs = ElapsedMs(stepStart);
+		if (!loaded.has_value())
+		{
+			report.errors.push_back("could not load project");
+			report.totalMs = ElapsedMs(totalStart);
+			return report;
+		}
+		Project& project = loaded.value();
+
+		ValidateProject(project, report);
+
+		if (options.revectorize && project.bHitboxMap && report.errors.empty())
+		{
+			stepStart = Clock::now();
+			// Same pipeline as the editor: trace once unsimplified, then filter by vertex rank.
+			const int traceIndex = RankedChains::kTraceSimplifyIndex;
+			VectorizationCache& cache = VectorizationCache::Get();
+			std::optional<List<Vectorizer::Math::Chain>> chains = cache.Load(project.hitboxTexturePath, traceIndex);
+			if (!chains.has_value())
+			{
+				chains = Vectorizer::vectorizeImage(project.hitboxTexturePath, traceIndex);
+				cache.Store(project.hitboxTexturePath, traceIndex, chains.value());
+			}
+			project.level.setTracedHitboxes(chains.value(), project.simplifyIndex);
+			report.vectorizeMs = ElapsedMs(stepStart);
+		}
+
+		if (!options.validateOnly && report.errors.empty())
+		{
+			stepStart = Clock::now();
+			if (!options.closeLoops)
+			{
+				for (sf::VertexArray& chain : project.level.hitboxMap)
+				{
+					if (chain.getVertexCount() > 0)
+					{
+						chain.resize(chain.getVertexCount() - 1);
+					}
+				}
+			}
+			if (!ImportExport::exportLevel(project.level, ExportPath(options, projectPath, ".level.json"), options.encoding))
+			{
+				report.errors.push_back("could not write exported level");
+			}
+			if (options.binary && !ImportExport::exportLevelBinary(project.level, ExportPath(options, projectPath, ".level.vlb")))
+			{
+				report.errors.push_back("could not write binary level");
+			}
+			report.exportMs = ElapsedMs(stepStart);
+			if (options.verifyBinary && report.errors.empty())
+			{
+				VerifyBinaryLevel(ExportPath(options, projectPath, ".level.json"), ExportPath(options, projectPath, ".level.vlb"),
+					options.encoding.quantizationStep * 0.5f, report);
+			}
+		}
+
+		report.ok = report.errors.empty();
+		report.totalMs = ElapsedMs(totalStart);
+		return report;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CliOptions options;
+	if (!ParseArguments(argc, argv, options))
+	{
+		return 1;
+	}
+	if (!options.validateOnly && !CheckExportPaths(options))
+	{
+		return 1;
+	}
+	if (!options.outputDir.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(options.outputDir, error);
+		if (error)
+		{
+			std::cerr << "Error: cannot create output directory " << options.outputDir << ": " << error.message() << std::endl;
+			return 1;
+		}
+	}
+
+	const size_t jobs = std::min(std::max<size_t>(options.jobs, 1), options.projectPaths.size());
+	std::mutex outputMutex;
+	std::atomic<size_t> failedCount{ 0 };
+	Clock::time_point batchStart = Clock::now();
+	{
+		ThreadPool pool(jobs);
+		List<std::future<void>> results;
+		results.reserve(options.projectPaths.size());
+		for (const std::string& projectPath : options.projectPaths)
+		{
+			results.push_back(pool.Enqueue([&options, &outputMutex, &failedCount, projectPath]()
+				{
+					FileReport report = ProcessProject(options, projectPath);
+					if (!report.ok)
+					{
+						failedCount++;
+					}
+					std::ostringstream line;
+					line.setf(std::ios::fixed);
+					line.precision(1);
+					line << (report.ok ? "[ OK ] " : "[FAIL] ") << projectPath
+						<< "  load " << report.loadMs << " ms";
+					if (options.revectorize)
+					{
+						line << "  vectorize " << report.vectorizeMs << " ms";
+					}
+					if (!options.validateOnly)
+					{
+						line << "  export " << report.exportMs << " ms";
+					}
+					line << "  total " << report.totalMs << " ms\n";
+					for (const std::string& warning : report.warnings)
+					{
+						line << "       warning: " << warning << "\n";
+					}
+					for (const std::string& error : report.errors)
+					{
+						line << "       error: " << error << "\n";
+					}
+					std::lock_guard<std::mutex> lock(outputMutex);
+					std::cout << line.str() << std::flush;
+				}));
+		}
+		for (std::future<void>& result : results)
+		{
+			result.get();
+		}
+	}
+
+	std::cout << options.projectPaths.size() << " project(s), " << failedCount << " failed, "
+		<< jobs << " job(s), " << static_cast<long long>(ElapsedMs(batchStart)) << " ms" << std::endl;
+	if (options.revectorize)
+	{
+		const VectorizationCacheStats cacheStats = VectorizationCache::Get().GetStats();
+		std::cout << "trace cache: " << cacheStats.hits << " hit(s), " << cacheStats.misses << " miss(es), "
+			<< cacheStats.evictions << " eviction(s)" << std::endl;
+	}
+	return failedCount == 0 ? 0 : 1;
+}
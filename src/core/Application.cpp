@@ -1,3 +1,4 @@
+#include <filesystem>
 #include <imgui_internal.h>
 #include "misc/cpp/imgui_stdlib.h"
 #include <ImGuiFileDialog.h>
@@ -5,9 +6,23 @@
 #include "core/Utils.h"
 #include "project/AssetManager.h"
 #include "io/ImportExport.h"
+#include "level/VectorizationCache.h"
 
 using namespace vle;
 
+namespace
+{
+	const sf::Time kTextureUploadBudget = sf::milliseconds(4);
+	// While idle the loop still wakes up this often, so blinking carets and dialogs stay alive.
+	const sf::Time kIdleWaitTimeout = sf::milliseconds(250);
+	// Frames run after the last input so ImGui widgets can settle (hover, popups, layout).
+	const int kFramesAfterInput = 3;
+	// How long a successful save or export stays mentioned in the menu bar.
+	const sf::Time kWriteStatusDuration = sf::seconds(4);
+	// How often edits are handed to the autosave log.
+	const sf::Time kAutosaveInterval = sf::seconds(2);
+}
+
 Application::Application()
 	: mWindow{ sf::VideoMode({1000, 680}), "Level Editor", sf::Style::Default },
 	mDraggingObject{ false },
@@ -21,11 +36,23 @@ Application::Application()
 	mProjectInitialized{ false },
 	mWizardState{ ProjectWizardState::Idle },
 	mTempSetupProject{},
-	mBackgroundTextureID{"VoidBGID"},
-	mSelectedGameObject{nullptr},
+	mSelectedGameObject{},
 	mMissingBackgroundPath{false},
 	mMissingHitboxPath{false},
-	mShowHitboxes{false}
+	mShowHitboxes{false},
+	mShowFrameStats{false},
+	mShowTextureMemory{false},
+	mShowProfiler{false},
+	mObjectFilterInView{false},
+	mObjectFilterSelectedOnly{false},
+	mActiveFramesLeft{kFramesAfterInput},
+	mLastSceneState{},
+	mFrameStats{},
+	mEditJournal{},
+	mEditHistoryLimitMB{ static_cast<int>(EditJournal::kDefaultMemoryLimit / (1024 * 1024)) },
+	mTextureBudgetMB{ static_cast<int>(AssetManager::kDefaultMemoryBudget / (1024 * 1024)) },
+	mWriteFailed{ false },
+	mSavingChangeCount{ 0 }
 {
 	mWindow.setVerticalSyncEnabled(true);
 	ImGui::SFML::Init(mWindow);
@@ -35,65 +62,155 @@ Application::Application()
 
 Application::~Application()
 {
+	FlushAutosave();
 	ImGui::SFML::Shutdown();
 }
 
 void Application::Run()
 {
+	Profiler::SetThreadName("Main");
 	mTickClock.restart();
 	while (mWindow.isOpen())
 	{
-		while (const std::optional event = mWindow.pollEvent())
+		bool receivedInput = false;
+		if (IsIdle())
 		{
-			if (event->is<sf::Event::Closed>()) {
-				mWindow.close();
+			if (const std::optional event = mWindow.waitEvent(kIdleWaitTimeout))
+			{
+				HandleEvent(*event);
+				receivedInput = true;
 			}
-			ImGui::SFML::ProcessEvent(mWindow, *event);
 		}
-		sf::Time deltaTime = mTickClock.restart();
-		Tick(deltaTime);
-		Render();
+		while (const std::optional event = mWindow.pollEvent())
+		{
+			HandleEvent(*event);
+			receivedInput = true;
+		}
+		if (receivedInput)
+		{
+			mActiveFramesLeft = kFramesAfterInput;
+		}
+		else if (mActiveFramesLeft > 0)
+		{
+			mActiveFramesLeft--;
+		}
+		Profiler::Get().BeginFrame();
+		{
+			PROFILE_ZONE("Frame");
+			sf::Time deltaTime = mTickClock.restart();
+			Tick(deltaTime);
+			Render();
+			UpdateFrameStats();
+		}
+		Profiler::Get().EndFrame();
+	}
+}
+
+void Application::HandleEvent(const sf::Event& event)
+{
+	if (event.is<sf::Event::Closed>()) {
+		mWindow.close();
+	}
+	ImGui::SFML::ProcessEvent(mWindow, event);
+}
+
+bool Application::IsIdle() const
+{
+	return mActiveFramesLeft == 0 && !mIsFirstFrame && !mDraggingObject && !mVectorizationJob && !AssetManager::Get().HasPendingTextures() && !mThumbnails.HasPendingThumbnails() &&
+		!mBackground.IsStreaming() && !mBackgroundWriter.IsBusy();
+}
+
+bool Application::SceneNeedsRedraw() const
+{
+	const SceneState& last = mLastSceneState;
+	return mSpriteBatcher.IsDirty() || mBackground.IsDirty() || (mShowHitboxes && mHitboxRenderer.IsDirty()) ||
+		last.viewCenter != mLevelView.getCenter() || last.viewSize != mLevelView.getSize() ||
+		last.viewport.position != mLevelView.getViewport().position || last.viewport.size != mLevelView.getViewport().size ||
+		last.canvasSize != mLevelCanvas.getSize() || last.selectedGameObject != mSelectedGameObject ||
+		last.showHitboxes != mShowHitboxes || !last.valid;
+}
+
+void Application::UpdateFrameStats()
+{
+	mFrameStats.frameCount++;
+	mFrameStats.framesInWindow++;
+	const sf::Time window = mFrameStats.windowClock.getElapsedTime();
+	if (window < sf::seconds(1.f))
+	{
+		return;
 	}
+	// std::clock measures CPU time used by the whole process, worker threads included.
+	const std::clock_t cpuNow = std::clock();
+	const double cpuSeconds = static_cast<double>(cpuNow - mFrameStats.windowCpuStart) / CLOCKS_PER_SEC;
+	mFrameStats.cpuPercent = static_cast<float>(100.0 * cpuSeconds / window.asSeconds());
+	mFrameStats.framesPerSecond = mFrameStats.framesInWindow / window.asSeconds();
+	mFrameStats.scenesPerSecond = mFrameStats.scenesInWindow / window.asSeconds();
+	mFrameStats.framesInWindow = 0;
+	mFrameStats.scenesInWindow = 0;
+	mFrameStats.windowCpuStart = cpuNow;
+	mFrameStats.windowClock.restart();
 }
 
 void Application::Tick(sf::Time deltaTime)
 {
+	PROFILE_ZONE("Tick");
+	UploadPendingTextures();
 	RenderUI(deltaTime);
+	if (mAutosaveClock.getElapsedTime() >= kAutosaveInterval)
+	{
+		FlushAutosave();
+		mAutosaveClock.restart();
+	}
 
 	if (mIsFirstFrame) mIsFirstFrame = false;
 }
 
 void Application::Render()
 {
+	PROFILE_ZONE("Render");
 	mLevelCanvas.setView(mLevelView);
 
-	RenderScene();
+	if (SceneNeedsRedraw())
+	{
+		RenderScene();
+		mLastSceneState = SceneState{ mLevelView.getCenter(), mLevelView.getSize(), mLevelView.getViewport(),
+			mLevelCanvas.getSize(), mSelectedGameObject, mShowHitboxes, true };
+		mFrameStats.sceneRenderCount++;
+		mFrameStats.scenesInWindow++;
+	}
 
 	mWindow.clear(sf::Color(30, 30, 30));
-	ImGui::SFML::Render(mWindow);
-	mWindow.display();
+	{
+		PROFILE_ZONE("ImGui::SFML::Render");
+		ImGui::SFML::Render(mWindow);
+	}
+	{
+		PROFILE_ZONE("display");
+		mWindow.display();
+	}
 }
 
 void Application::RenderScene()
 {
+	PROFILE_FUNCTION();
 	mLevelCanvas.clear(sf::Color(50, 50, 50));
-	const sf::Texture* backgroundTexture = AssetManager::Get().GetTexture(mBackgroundTextureID);
-	if (backgroundTexture)
-	{
-		sf::Sprite backgroundSprite(*backgroundTexture);
-		mLevelCanvas.draw(backgroundSprite);
-	}
-	for (const unique<GameObject>& gameObject : mProject.level.gameObjects)
-	{
-		if (gameObject->sprite.has_value())
-		{
-			mLevelCanvas.draw(*gameObject->sprite);
-		}
-	}
-	if (mSelectedGameObject != nullptr)
+	sf::FloatRect viewArea(mLevelView.getCenter() - mLevelView.getSize() / 2.f, mLevelView.getSize());
+	const float viewportWidth = static_cast<float>(std::max(1, mLevelCanvas.getViewport(mLevelView).size.x));
+	const float worldUnitsPerPixel = mLevelView.getSize().x / viewportWidth;
+	mBackground.Update(viewArea, worldUnitsPerPixel);
+	mLevelCanvas.draw(mBackground);
+	const GameObjectStore& objects = mProject.level.gameObjects;
+	mSpriteBatcher.Update(objects);
+	mVisibleObjects.clear();
+	mProject.level.spatialIndex.Query(viewArea, mVisibleObjects);
+	mSpriteBatcher.Cull(objects, mVisibleObjects);
+	PinSceneTextures();
+	mLevelCanvas.draw(mSpriteBatcher);
+	const size_t selectedIndex = objects.IndexOf(mSelectedGameObject);
+	if (selectedIndex != GameObjectStore::kInvalidIndex)
 	{
-		sf::Transform  transform = mSelectedGameObject->sprite->getTransform();
-		sf::FloatRect bounds = mSelectedGameObject->sprite->getLocalBounds();
+		sf::Transform  transform = objects.GetTransform(selectedIndex);
+		sf::FloatRect bounds({ 0.f, 0.f }, objects.GetSizes()[selectedIndex]);
 		sf::Vector2f topL = bounds.position;
 		sf::Vector2f topR = { topL.x + bounds.size.x, topL.y };
 		sf::Vector2f botL = { topL.x, topL.y + bounds.size.y };
@@ -108,18 +225,14 @@ void Application::RenderScene()
 	}
 	if (mShowHitboxes)
 	{
-		const sf::Texture* backgroundTexture = AssetManager::Get().GetTexture(mBackgroundTextureID);
-		if (backgroundTexture)
+		if (mBackground.IsOpen())
 		{
-			sf::Vector2f backgroundSize = sf::Vector2f(backgroundTexture->getSize());
 			sf::RectangleShape hitboxBackground;
-			hitboxBackground.setSize(backgroundSize);
+			hitboxBackground.setSize(sf::Vector2f(mBackground.GetSize()));
 			hitboxBackground.setFillColor(sf::Color(10, 10, 10, 200));
 			mLevelCanvas.draw(hitboxBackground);
-			for (sf::VertexArray chain : mProject.level.hitboxMap)
-			{
-				mLevelCanvas.draw(chain);
-			}
+			mHitboxRenderer.Update(mProject.level.hitboxMap, viewArea, worldUnitsPerPixel);
+			mLevelCanvas.draw(mHitboxRenderer);
 		}
 	}
 
@@ -128,8 +241,11 @@ void Application::RenderScene()
 
 void Application::RenderUI(sf::Time deltaTime)
 {
+	PROFILE_FUNCTION();
 	ImGui::SFML::Update(mWindow, deltaTime);
 
+	HandleEditShortcuts();
+
 	if (!mProjectInitialized)
 	{
 		RenderWizardUI();
@@ -141,7 +257,7 @@ void Application::RenderUI(sf::Time deltaTime)
 	{
 		if (ImGuiFileDialog::Instance()->IsOk())
 		{
-			ImportExport::save(mProject, ImGuiFileDialog::Instance()->GetFilePathName());
+			SaveProject(ImGuiFileDialog::Instance()->GetFilePathName());
 		}
 		ImGuiFileDialog::Instance()->Close();
 	}
@@ -157,23 +273,44 @@ void Application::RenderUI(sf::Time deltaTime)
 	{
 		if (ImGuiFileDialog::Instance()->IsOk())
 		{
-			List<sf::VertexArray> hitboxMap = mProject.level.hitboxMap;
-			if (!mProject.bHitboxCreateLoop)
-			{
-				for (sf::VertexArray& chain : hitboxMap)
-				{
-					if (chain.getVertexCount() > 0)
-					{
-						chain.resize(chain.getVertexCount() - 1);
-					}
-				}
-				mProject.level.hitboxMap = hitboxMap;
-			}
-			ImportExport::exportLevel(mProject.level, ImGuiFileDialog::Instance()->GetFilePathName());
+			ExportLevel(ImGuiFileDialog::Instance()->GetFilePathName(), false);
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+	if (ImGuiFileDialog::Instance()->Display("ExportLevelBinaryFile", ImGuiCond_Always, { 500.f, 300.f }))
+	{
+		if (ImGuiFileDialog::Instance()->IsOk())
+		{
+			ExportLevel(ImGuiFileDialog::Instance()->GetFilePathName(), true);
 		}
 		ImGuiFileDialog::Instance()->Close();
 	}
 
+	if (ImGuiFileDialog::Instance()->Display("ExportAtlasFile", ImGuiCond_Always, { 500.f, 300.f }))
+	{
+		if (ImGuiFileDialog::Instance()->IsOk())
+		{
+			// Evicted textures have no region to export.
+			AssetManager::Get().LoadAllTextures();
+			mSpriteBatcher.MarkStructureDirty();
+			ImportExport::exportAtlas(AssetManager::Get().GetAtlas(), AssetManager::Get().GetAtlasRegionNames(), ImGuiFileDialog::Instance()->GetFilePathName());
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+	if (ImGuiFileDialog::Instance()->Display("SaveTraceFile", ImGuiCond_Always, { 500.f, 300.f }))
+	{
+		if (ImGuiFileDialog::Instance()->IsOk())
+		{
+			Profiler::Get().WriteChromeTrace(ImGuiFileDialog::Instance()->GetFilePathName());
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	if (mProjectInitialized)
+	{
+		RenderRecoveryUI();
+	}
+
 }
 
 void Application::RenderEditorUI()
@@ -229,6 +366,24 @@ void Application::RenderEditorUI()
 	RenderGameObjectsUI();
 
 	ImGui::End();
+
+	if (mShowTextureMemory)
+	{
+		if (ImGui::Begin("Texture Memory", &mShowTextureMemory))
+		{
+			RenderTextureMemoryUI();
+		}
+		ImGui::End();
+	}
+
+	if (mShowProfiler)
+	{
+		if (ImGui::Begin("Profiler", &mShowProfiler))
+		{
+			RenderProfilerUI();
+		}
+		ImGui::End();
+	}
 }
 
 void Application::SetupDefaultDockingLayout(ImGuiID nodeID)
@@ -260,10 +415,12 @@ void Application::RenderMainMenuBarUI()
 	{
 		if (ImGui::MenuItem("New Project"))
 		{
+			FlushAutosave();
+			mAutosave.Stop();
 			mTempSetupProject = Project();
 			mTempAssetList.clear();
 			mSelectedAssetID.reset();
-			mSelectedGameObject = nullptr;
+			mSelectedGameObject = {};
 			mWizardState = ProjectWizardState::CreateProject;
 			mProjectInitialized = false;
 		}
@@ -275,10 +432,11 @@ void Application::RenderMainMenuBarUI()
 		if (ImGui::MenuItem("Edit Project"))
 		{
 			mSelectedAssetID.reset();
-			mSelectedGameObject = nullptr;
+			mSelectedGameObject = {};
 			mTempAssetList.clear();
 			mTempSetupProject = std::move(mProject);
 			mTempSetupProject.level.hitboxMap.clear();
+			HitboxMapChanged();
 			for (const auto& pair : mTempSetupProject.assets) {
 				if (pair.second) {
 					const Asset& asset = *pair.second;
@@ -304,15 +462,272 @@ void Application::RenderMainMenuBarUI()
 			config.flags = ImGuiFileDialogFlags_Modal | ImGuiFileDialogFlags_ConfirmOverwrite;
 			ImGuiFileDialog::Instance()->OpenDialog("ExportLevelFile", "Export Level File", ".json{.json, .JSON, .Json}", config);
 		}
+
+		if (ImGui::MenuItem("Export Level (Binary)"))
+		{
+			IGFD::FileDialogConfig config;
+			config.path = ".";
+			config.flags = ImGuiFileDialogFlags_Modal | ImGuiFileDialogFlags_ConfirmOverwrite;
+			ImGuiFileDialog::Instance()->OpenDialog("ExportLevelBinaryFile", "Export Binary Level File", ".vlb{.vlb, .VLB}", config);
+		}
+
+		if (ImGui::MenuItem("Export Texture Atlas"))
+		{
+			IGFD::FileDialogConfig config;
+			config.path = ".";
+			config.flags = ImGuiFileDialogFlags_Modal | ImGuiFileDialogFlags_ConfirmOverwrite;
+			ImGuiFileDialog::Instance()->OpenDialog("ExportAtlasFile", "Export Texture Atlas", ".json{.json, .JSON, .Json}", config);
+		}
+		ImGui::EndMenu();
+	}
+
+	if (ImGui::BeginMenu("Edit"))
+	{
+		if (ImGui::MenuItem("Undo", "Ctrl+Z", false, mProjectInitialized && mEditJournal.CanUndo()))
+		{
+			UndoEdit();
+		}
+		if (ImGui::MenuItem("Redo", "Ctrl+Y", false, mProjectInitialized && mEditJournal.CanRedo()))
+		{
+			RedoEdit();
+		}
+		ImGui::Separator();
+		if (ImGui::SliderInt("History Limit (MB)", &mEditHistoryLimitMB, 1, 1024))
+		{
+			mEditJournal.SetMemoryLimit(static_cast<size_t>(mEditHistoryLimitMB) * 1024 * 1024);
+		}
+		ImGui::Text("%zu undo step(s), %.2f MB", mEditJournal.GetUndoCount(),
+			static_cast<float>(mEditJournal.GetMemoryUsage()) / (1024.f * 1024.f));
 		ImGui::EndMenu();
 	}
 
 	if (ImGui::BeginMenu("View"))
 	{
 		ImGui::MenuItem("View Hitboxes", 0, &mShowHitboxes);
+		ImGui::BeginDisabled(mProject.level.tracedHitboxes.IsEmpty());
+		if (ImGui::SliderInt("Hitbox Simplification", &mProject.simplifyIndex, 0, 30))
+		{
+			mProject.level.tracedHitboxes.Simplify(mProject.simplifyIndex, mProject.level.hitboxMap);
+			HitboxMapChanged();
+			mShowHitboxes = true;
+		}
+		ImGui::EndDisabled();
+		if (mProject.level.tracedHitboxes.IsEmpty() && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+		{
+			ImGui::SetTooltip("Use Edit Project to trace the hitbox image again");
+		}
+		ImGui::MenuItem("Frame Stats", 0, &mShowFrameStats);
+		ImGui::MenuItem("Texture Memory", 0, &mShowTextureMemory);
+		ImGui::MenuItem("Profiler", 0, &mShowProfiler);
 
 		ImGui::EndMenu();
 	}
+
+	RenderWriteStatusUI();
+
+	if (mShowFrameStats)
+	{
+		ImGui::Separator();
+		ImGui::Text("Frames %llu | %.1f fps | Scene %.1f/s | CPU %.1f%%", mFrameStats.frameCount,
+			mFrameStats.framesPerSecond, mFrameStats.scenesPerSecond, mFrameStats.cpuPercent);
+		const VectorizationCacheStats cacheStats = VectorizationCache::Get().GetStats();
+		ImGui::Separator();
+		ImGui::Text("Trace cache %llu hit / %llu miss | %.1f MB", cacheStats.hits, cacheStats.misses,
+			static_cast<float>(cacheStats.diskBytes) / (1024.f * 1024.f));
+	}
+}
+
+void Application::RenderTextureMemoryUI()
+{
+	const TextureMemoryStats stats = AssetManager::Get().GetMemoryStats();
+	const float megabyte = 1024.f * 1024.f;
+	if (ImGui::SliderInt("Budget (MB)", &mTextureBudgetMB, 16, 8192))
+	{
+		AssetManager::Get().SetMemoryBudget(static_cast<std::uint64_t>(mTextureBudgetMB) * 1024 * 1024);
+	}
+	ImGui::Text("Resident %.1f MB", static_cast<float>(stats.textureBytes + stats.atlasBytes) / megabyte);
+	ImGui::Text("  Standalone textures %.1f MB (%zu, %zu pinned)", static_cast<float>(stats.textureBytes) / megabyte,
+		stats.residentTextures, stats.pinnedTextures);
+	ImGui::Text("  Atlas %.1f MB (%zu page(s))", static_cast<float>(stats.atlasBytes) / megabyte,
+		AssetManager::Get().GetAtlas().GetPageCount());
+	ImGui::Separator();
+	ImGui::Text("Hits %llu | Misses %llu | Evictions %llu", stats.hits, stats.misses, stats.evictions);
+	if (stats.textureBytes + stats.atlasBytes > stats.budget)
+	{
+		ImGui::TextColored(ImVec4(1.f, 0.8f, 0.3f, 1.f), "Over budget: the textures in use do not fit");
+	}
+	const TextureDedupStats dedup = AssetManager::Get().GetDedupStats();
+	ImGui::Separator();
+	ImGui::Text("Deduplication: %zu asset(s) on %zu texture(s)", dedup.names, dedup.textures);
+	ImGui::Text("Same file %zu | Same content %zu", dedup.sharedByPath, dedup.sharedByContent);
+	ImGui::Text("Saved %.1f MB", static_cast<float>(dedup.savedBytes) / megabyte);
+}
+
+void Application::RenderProfilerUI()
+{
+	Profiler& profiler = Profiler::Get();
+	bool recording = profiler.IsEnabled();
+	if (ImGui::Checkbox("Record", &recording))
+	{
+		profiler.SetEnabled(recording);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Save Chrome Trace"))
+	{
+		IGFD::FileDialogConfig config;
+		config.path = ".";
+		config.flags = ImGuiFileDialogFlags_Modal | ImGuiFileDialogFlags_ConfirmOverwrite;
+		ImGuiFileDialog::Instance()->OpenDialog("SaveTraceFile", "Save Chrome Trace", ".json{.json, .JSON, .Json}", config);
+	}
+
+	// Busy time only: frames spent waiting for input while idle do not count.
+	const List<float> frameTimes = profiler.GetFrameTimes();
+	if (!frameTimes.empty())
+	{
+		float total = 0.f;
+		float slowest = 0.f;
+		for (float time : frameTimes)
+		{
+			total += time;
+			slowest = std::max(slowest, time);
+		}
+		char overlay[64];
+		std::snprintf(overlay, sizeof(overlay), "avg %.2f ms | max %.2f ms", total / frameTimes.size(), slowest);
+		ImGui::PlotLines("##FrameTimes", frameTimes.data(), static_cast<int>(frameTimes.size()), 0, overlay,
+			0.f, std::max(slowest * 1.1f, 1000.f / 60.f), ImVec2(-1.f, 80.f));
+	}
+
+	ImGui::Text("Slowest zones, last second");
+	if (ImGui::BeginTable("Zones", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+	{
+		ImGui::TableSetupColumn("Zone");
+		ImGui::TableSetupColumn("Calls");
+		ImGui::TableSetupColumn("Total ms");
+		ImGui::TableSetupColumn("Max ms");
+		ImGui::TableHeadersRow();
+		for (const ProfileZoneStats& zone : profiler.GetSlowestZones(1000000000ull, 12))
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(zone.name);
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", zone.calls);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.2f", zone.totalMs);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.2f", zone.maxMs);
+		}
+		ImGui::EndTable();
+	}
+}
+
+void Application::SaveProject(const std::string& path)
+{
+	auto snapshot = std::make_shared<const ProjectSnapshot>(snapshotProject(mProject, GetHitboxSnapshot()));
+	mSavingProjectPath = path;
+	mSavingChangeCount = mAutosave.GetChangeCount();
+	const std::string name = std::filesystem::path(path).filename().string();
+	mBackgroundWriter.Submit("Saving " + name, path, [snapshot, path]()
+		{
+			return ImportExport::save(*snapshot, path);
+		});
+}
+
+void Application::ExportLevel(const std::string& path, bool binary)
+{
+	LevelSnapshot snapshot = snapshotLevel(mProject.level, GetHitboxSnapshot());
+	const bool closeLoops = mProject.bHitboxCreateLoop;
+	const std::string name = std::filesystem::path(path).filename().string();
+	mBackgroundWriter.Submit("Exporting " + name, path, [snapshot, closeLoops, binary, path]() mutable
+		{
+			if (!closeLoops)
+			{
+				List<sf::VertexArray> hitboxMap = *snapshot.hitboxMap;
+				for (sf::VertexArray& chain : hitboxMap)
+				{
+					if (chain.getVertexCount() > 0)
+					{
+						chain.resize(chain.getVertexCount() - 1);
+					}
+				}
+				snapshot.hitboxMap = std::make_shared<const List<sf::VertexArray>>(std::move(hitboxMap));
+			}
+			return binary ? ImportExport::exportLevelBinary(snapshot, path) : ImportExport::exportLevel(snapshot, path);
+		});
+}
+
+void Application::RenderWriteStatusUI()
+{
+	for (const WriteResult& result : mBackgroundWriter.TakeResults())
+	{
+		const std::string name = std::filesystem::path(result.path).filename().string();
+		mWriteFailed = !result.ok;
+		mWriteStatus = result.ok ? "Wrote " + name : "Could not write " + name + ", the previous file was kept";
+		mWriteStatusClock.restart();
+		if (result.ok && result.path == mSavingProjectPath)
+		{
+			// The file now holds what the log recorded up to the save.
+			FlushAutosave();
+			mAutosave.Start(result.path);
+			if (mAutosave.GetChangeCount() != mSavingChangeCount)
+			{
+				mAutosave.SnapshotNeeded();
+			}
+			mSavingProjectPath.clear();
+		}
+	}
+
+	const std::string current = mBackgroundWriter.GetCurrentDescription();
+	if (!current.empty())
+	{
+		ImGui::Separator();
+		ImGui::TextDisabled("%s...", current.c_str());
+	}
+	else if (mWriteFailed)
+	{
+		ImGui::Separator();
+		ImGui::TextColored(ImVec4(1.f, 0.35f, 0.3f, 1.f), "%s", mWriteStatus.c_str());
+		if (ImGui::IsItemHovered())
+		{
+			ImGui::SetTooltip("See the console for details. Click to dismiss.");
+		}
+		if (ImGui::IsItemClicked())
+		{
+			mWriteFailed = false;
+			mWriteStatus.clear();
+		}
+	}
+	else if (!mWriteStatus.empty() && mWriteStatusClock.getElapsedTime() < kWriteStatusDuration)
+	{
+		ImGui::Separator();
+		ImGui::TextDisabled("%s", mWriteStatus.c_str());
+	}
+}
+
+void Application::HitboxMapChanged()
+{
+	mHitboxRenderer.MarkDirty();
+	mHitboxSnapshot.reset();
+	mAutosave.SnapshotNeeded();
+}
+
+const shared<const List<sf::VertexArray>>& Application::GetHitboxSnapshot()
+{
+	if (!mHitboxSnapshot)
+	{
+		mHitboxSnapshot = std::make_shared<const List<sf::VertexArray>>(mProject.level.hitboxMap);
+	}
+	return mHitboxSnapshot;
+}
+
+void Application::FlushAutosave()
+{
+	PROFILE_FUNCTION();
+	// While the wizard is open mProject is being rebuilt and not worth recovering.
+	if (mProjectInitialized)
+	{
+		mAutosave.Flush(mProject, GetHitboxSnapshot());
+	}
 }
 
 void Application::LoadProjectDialog()
@@ -325,21 +740,85 @@ void Application::LoadProjectDialog()
 
 void Application::LoadProject()
 {
-	mProject = ImportExport::load(ImGuiFileDialog::Instance()->GetFilePathName()).value();
+	const std::string path = ImGuiFileDialog::Instance()->GetFilePathName();
+	if (AutosaveLog::HasRecovery(path))
+	{
+		mRecoveryPath = path;
+		return;
+	}
+	OpenProject(path, false);
+}
+
+void Application::OpenProject(const std::string& path, bool recover)
+{
+	std::optional<Project> project = recover ? AutosaveLog::Recover(path) : ImportExport::load(path);
+	if (!project.has_value())
+	{
+		return;
+	}
+	// Whatever the closing project had not handed to its log yet.
+	FlushAutosave();
+	mProject = std::move(project.value());
 	mSelectedAssetID.reset();
-	mSelectedGameObject = nullptr;
+	mSelectedGameObject = {};
 	LoadProjectTextures();
-	AssignProjectTextures();
-	const sf::Texture* backgroundTexture = AssetManager::Get().GetTexture(mBackgroundTextureID);
-	if (backgroundTexture)
+	mProject.level.spatialIndex.Rebuild(mProject.level.gameObjects);
+	if (mProject.bHitboxMap)
 	{
-		sf::Vector2f backgroundSize = sf::Vector2f(backgroundTexture->getSize());
-		mLevelView.setSize(backgroundSize);
-		mLevelView.setCenter(backgroundSize / 2.f);
+		// Only the simplified hitboxes are saved; the trace behind the live slider
+		// comes back from the cache when the map has not changed since.
+		std::optional<List<Vectorizer::Math::Chain>> chains = VectorizationCache::Get().Load(mProject.hitboxTexturePath,
+			RankedChains::kTraceSimplifyIndex);
+		if (chains.has_value())
+		{
+			mProject.level.tracedHitboxes.Build(chains.value());
+		}
+	}
+	mEditJournal.Clear();
+	HitboxMapChanged();
+	if (recover)
+	{
+		mAutosave.Resume(path);
+	}
+	else
+	{
+		mAutosave.Start(path);
 	}
 	mProjectInitialized = true;
 }
 
+void Application::RenderRecoveryUI()
+{
+	if (mRecoveryPath.empty())
+	{
+		return;
+	}
+	if (!ImGui::IsPopupOpen("Recover Unsaved Changes"))
+	{
+		ImGui::OpenPopup("Recover Unsaved Changes");
+	}
+	ImGui::SetNextWindowPos(ImGui::GetMainViewport()->GetCenter(), ImGuiCond_Always, { 0.5f, 0.5f });
+	if (ImGui::BeginPopupModal("Recover Unsaved Changes", NULL, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		ImGui::Text("%s has changes that were never saved.", std::filesystem::path(mRecoveryPath).filename().string().c_str());
+		ImGui::Text("Recover them from the autosave, or open the project as last saved?");
+		if (ImGui::Button("Recover", { 160, 0 }))
+		{
+			OpenProject(mRecoveryPath, true);
+			mRecoveryPath.clear();
+			ImGui::CloseCurrentPopup();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Discard Changes", { 160, 0 }))
+		{
+			OpenProject(mRecoveryPath, false);
+			mRecoveryPath.clear();
+			ImGui::CloseCurrentPopup();
+		}
+		ImGui::EndPopup();
+	}
+}
+
 void Application::RenderWizardUI()
 {
 
@@ -354,6 +833,9 @@ void Application::RenderWizardUI()
 	case ProjectWizardState::CreateProject:
 		ImGui::SetNextWindowSize(ImVec2(800, 480), ImGuiCond_Always);
 		break;
+	case ProjectWizardState::Vectorizing:
+		ImGui::SetNextWindowSize(ImVec2(400, 120), ImGuiCond_Always);
+		break;
 	}
 	ImGui::SetNextWindowPos(ImGui::GetMainViewport()->GetCenter(), ImGuiCond_Always, { 0.5f, 0.5f });
 	ImGui::OpenPopup("Create or Load Project");
@@ -374,6 +856,10 @@ void Application::RenderWizardUI()
 		case ProjectWizardState::CreateProject:
 			RenderCreateProject();
 			break;
+
+		case ProjectWizardState::Vectorizing:
+			RenderVectorizationUI();
+			break;
 		}
 		if (ImGuiFileDialog::Instance()->Display("OpenPrjFile", ImGuiCond_Always, { 500.f, 300.f }))
 		{
@@ -383,6 +869,7 @@ void Application::RenderWizardUI()
 			}
 			ImGuiFileDialog::Instance()->Close();
 		}
+		RenderRecoveryUI();
 
 		ImGui::EndPopup();
 	}
@@ -563,48 +1050,78 @@ bool Application::ProjectInitialization()
 			return false;
 		}
 		mMissingHitboxPath = false;
-		List<Vectorizer::Math::Chain> chains = Vectorizer::vectorizeImage(mTempSetupProject.hitboxTexturePath, mTempSetupProject.simplifyIndex);
-		mTempSetupProject.level.hitboxMap.clear();
-		for (Vectorizer::Math::Chain chain : chains)
-		{
-			sf::VertexArray newChain(sf::PrimitiveType::LineStrip);
-			for (Vectorizer::Math::Point point : chain)
-			{
-				sf::Vertex newPoint{ { point.x, point.y } };
-				newChain.append(newPoint);
-			}
-			mTempSetupProject.level.hitboxMap.push_back(newChain);
-		}
+		mVectorizationJob = std::make_unique<VectorizationJob>(mTempSetupProject.hitboxTexturePath, RankedChains::kTraceSimplifyIndex);
+		mWizardState = ProjectWizardState::Vectorizing;
+		return false;
 	}
+	CompleteProjectInitialization();
+	return true;
+}
+
+void Application::CompleteProjectInitialization()
+{
 	mProjectInitialized = true;
 	mProject = std::move(mTempSetupProject);
 	LoadProjectTextures();
-	for (auto it = mProject.level.gameObjects.begin(); it != mProject.level.gameObjects.end(); )
+	List<bool> knownAssets;
+	for (const auto& assetPair : mProject.assets)
 	{
-		GameObject* object = it->get();
-		if (mProject.assets.count(object->assetID) == 0)
+		const AssetIndex asset = NameTable::Assets().Intern(assetPair.first);
+		if (asset >= knownAssets.size())
 		{
-			it = mProject.level.gameObjects.erase(it);
+			knownAssets.resize(asset + 1, false);
 		}
-		else
+		knownAssets[asset] = true;
+	}
+	const List<AssetIndex>& assets = mProject.level.gameObjects.GetAssets();
+	mProject.level.gameObjects.RemoveIf([&assets, &knownAssets](size_t index)
 		{
-			const sf::Texture* texture = AssetManager::Get().GetTexture(object->assetID);
-			if (texture)
-			{
-				object->sprite->setTexture(*texture, true);
-				object->sprite->setOrigin(sf::Vector2f{ texture->getSize().x / 2.f, texture->getSize().y / 2.f });
-			}
-			it++;
+			return assets[index] >= knownAssets.size() || !knownAssets[assets[index]];
+		});
+	mProject.level.spatialIndex.Rebuild(mProject.level.gameObjects);
+	mEditJournal.Clear();
+	HitboxMapChanged();
+}
+
+void Application::RenderVectorizationUI()
+{
+	if (!mVectorizationJob)
+	{
+		mWizardState = ProjectWizardState::CreateProject;
+		return;
+	}
+	if (mVectorizationJob->IsFinished())
+	{
+		std::optional<List<Vectorizer::Math::Chain>> chains = mVectorizationJob->TakeResult();
+		const bool cancelled = mVectorizationJob->IsCancelled();
+		const std::string error = mVectorizationJob->GetError();
+		mVectorizationJob.reset();
+		if (chains.has_value())
+		{
+			mTempSetupProject.level.setTracedHitboxes(chains.value(), mTempSetupProject.simplifyIndex);
+			CompleteProjectInitialization();
+			mWizardState = ProjectWizardState::Idle;
+			ImGui::CloseCurrentPopup();
+			return;
 		}
+		if (!cancelled)
+		{
+			std::cerr << "Error: hitbox vectorization failed: " << error << std::endl;
+		}
+		mWizardState = ProjectWizardState::CreateProject;
+		return;
+	}
+
+	ImGui::Text("Tracing hitboxes from %s", std::filesystem::path(mTempSetupProject.hitboxTexturePath).filename().string().c_str());
+	ImGui::ProgressBar(mVectorizationJob->GetProgress(), ImVec2(-1.f, 0.f));
+	if (mVectorizationJob->IsCancelled())
+	{
+		ImGui::TextDisabled("Cancelling...");
 	}
-	const sf::Texture* backgroundTexture = AssetManager::Get().GetTexture(mBackgroundTextureID);
-	if (backgroundTexture)
+	else if (ImGui::Button("Cancel"))
 	{
-		sf::Vector2f backgroundSize = sf::Vector2f(backgroundTexture->getSize());
-		mLevelView.setSize(backgroundSize);
-		mLevelView.setCenter(backgroundSize / 2.f);
+		mVectorizationJob->Cancel();
 	}
-	return true;
 }
 
 void Application::RenderLevelCanvasUI()
@@ -655,17 +1172,16 @@ void Application::RenderLevelCanvasUI()
 
 			const Asset* asset = mProject.assets.at(nameID).get();
 
-			const sf::Texture* gameObjectTexture = AssetManager::Get().GetTexture(nameID);
-			if (gameObjectTexture)
+			// The texture may still be loading or evicted; the object shows a placeholder until it arrives.
+			if (AssetManager::Get().GetTextureStatus(NameTable::Assets().Intern(nameID)) != TextureStatus::Failed)
 			{
-				sf::Sprite gameObjectSprite(*gameObjectTexture);
-				GameObject newObject{ nameID, gameObjectSprite };
-				newObject.sprite->setPosition(levelMousePos);
-				newObject.sprite->setScale(asset->defaultScale);
-				newObject.sprite->setRotation(asset->defaultRotation);
-				newObject.sprite->setOrigin(sf::Vector2f{ gameObjectTexture->getSize().x / 2.f, gameObjectTexture->getSize().y / 2.f });
-				mProject.level.gameObjects.push_back(std::make_unique<GameObject>(newObject));
-				mSelectedGameObject = mProject.level.gameObjects.back().get();
+				GameObjectStore& objects = mProject.level.gameObjects;
+				mSelectedGameObject = mProject.level.addGameObject(GameObject{ nameID, levelMousePos, asset->defaultScale, asset->defaultRotation, {} });
+				AssetManager::Get().BindTexture(objects, objects.GetCount() - 1);
+				ObjectTransformChanged(objects.GetCount() - 1);
+				mEditJournal.RecordAdd(mProject.level, mSelectedGameObject);
+				mAutosave.ObjectAdded(objects, objects.GetCount() - 1);
+				mSpriteBatcher.MarkStructureDirty();
 			}
 		}
 
@@ -675,24 +1191,19 @@ void Application::RenderLevelCanvasUI()
 	{
 		if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
 		{
-			List<unique<GameObject>>& gameObjects = mProject.level.gameObjects;
-			for (auto object = gameObjects.rbegin(); object != gameObjects.rend(); ++object)
+			mSelectedGameObject = mProject.level.spatialIndex.Pick(levelMousePos);
+			if (!mSelectedGameObject.IsNull())
 			{
-				if (object->get()->sprite->getGlobalBounds().contains(levelMousePos))
-				{
-					mSelectedGameObject = object->get();
-					mSelectedAssetID.reset();
-					mDraggingObject = true;
-					break;
-				}
-				mSelectedGameObject = nullptr;
+				mSelectedAssetID.reset();
+				mDraggingObject = true;
 			}
 		}
 		if (ImGui::IsMouseReleased(ImGuiMouseButton_Left))
 		{
 			mDraggingObject = false;
 		}
-		if (ImGui::IsMouseDragging(ImGuiMouseButton_Left) && mDraggingObject)
+		const size_t draggedIndex = mProject.level.gameObjects.IndexOf(mSelectedGameObject);
+		if (ImGui::IsMouseDragging(ImGuiMouseButton_Left) && mDraggingObject && draggedIndex != GameObjectStore::kInvalidIndex)
 		{
 			ImVec2 mouseDeltaPixels = ImGui::GetIO().MouseDelta;
 			sf::Vector2i currentMousePosPixel = sf::Vector2i(ImGui::GetMousePos()) - sf::Vector2i(ImGui::GetItemRectMin());
@@ -700,7 +1211,12 @@ void Application::RenderLevelCanvasUI()
 			sf::Vector2f currentMousePosWorld = mLevelCanvas.mapPixelToCoords(currentMousePosPixel, mLevelView);
 			sf::Vector2f prevMousePosWorld = mLevelCanvas.mapPixelToCoords(prevMousePosPixel, mLevelView);
 			sf::Vector2f worldDelta = currentMousePosWorld - prevMousePosWorld;
-			mSelectedGameObject->sprite->move(worldDelta);
+			GameObjectStore& objects = mProject.level.gameObjects;
+			const ObjectTransform before = ObjectTransform::Of(objects, draggedIndex);
+			objects.SetPosition(draggedIndex, before.position + worldDelta);
+			ObjectTransformChanged(draggedIndex);
+			mEditJournal.RecordTransform(mSelectedGameObject, before, ObjectTransform::Of(objects, draggedIndex));
+			mAutosave.ObjectChanged(objects, draggedIndex);
 		}
 	}
 
@@ -708,7 +1224,7 @@ void Application::RenderLevelCanvasUI()
 
 void Application::RenderPropertiesUI()
 {
-	if (mSelectedGameObject)
+	if (mProject.level.gameObjects.IsValid(mSelectedGameObject))
 	{
 		RenderGameObjectPropertiesUI();
 	}
@@ -721,14 +1237,18 @@ void Application::RenderPropertiesUI()
 void Application::RenderGameObjectPropertiesUI()
 {
 	const float PI = 3.1415926535f;
+	GameObjectStore& objects = mProject.level.gameObjects;
+	const size_t index = objects.IndexOf(mSelectedGameObject);
+	const ObjectTransform before = ObjectTransform::Of(objects, index);
 	{
 		ImGui::Text("Position");
 		ImGui::Text("x:");
 		ImGui::SameLine();
-		sf::Vector2f position = mSelectedGameObject->sprite->getPosition();
+		sf::Vector2f position = objects.GetPositions()[index];
 		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x / 2 - ImGui::GetStyle().ItemSpacing.x);
 		if (ImGui::InputFloat("##pos_x_input", &position.x)) {
-			mSelectedGameObject->sprite->setPosition(position);
+			objects.SetPosition(index, position);
+			ObjectTransformChanged(index);
 		}
 
 		ImGui::SameLine();
@@ -737,7 +1257,8 @@ void Application::RenderGameObjectPropertiesUI()
 		ImGui::SameLine();
 		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x - ImGui::GetStyle().ItemSpacing.x);
 		if (ImGui::InputFloat("##pos_y_input", &position.y)) {
-			mSelectedGameObject->sprite->setPosition(position);
+			objects.SetPosition(index, position);
+			ObjectTransformChanged(index);
 		}
 		ImGui::PopItemWidth();
 	}
@@ -747,15 +1268,17 @@ void Application::RenderGameObjectPropertiesUI()
 	{
 		ImGui::Text("Scale");
 		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x / 2 - ImGui::GetStyle().ItemSpacing.x);
-		sf::Vector2f scale = mSelectedGameObject->sprite->getScale();
+		sf::Vector2f scale = objects.GetScales()[index];
 		if (ImGui::InputFloat("##scale_input", &scale.x)) {
-			mSelectedGameObject->sprite->setScale({ scale.x,scale.x });
+			objects.SetScale(index, { scale.x,scale.x });
+			ObjectTransformChanged(index);
 		}
 		ImGui::PopItemWidth();
 		ImGui::SameLine();
 		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x - ImGui::GetStyle().ItemSpacing.x);
 		if (ImGui::SliderFloat("##scale_slider", &scale.x, 0.f, 10.f)) {
-			mSelectedGameObject->sprite->setScale({ scale.x,scale.x });
+			objects.SetScale(index, { scale.x,scale.x });
+			ObjectTransformChanged(index);
 		}
 	}
 
@@ -763,39 +1286,46 @@ void Application::RenderGameObjectPropertiesUI()
 
 	{
 		ImGui::Text("Rotation");
-		float rotation = mSelectedGameObject->sprite->getRotation().asDegrees();
+		float rotation = objects.GetRotations()[index].asDegrees();
 		if (rotation > 180.f)
 		{
 			rotation -= 360.f;
 		}
 		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x / 2 - ImGui::GetStyle().ItemSpacing.x);
 		if (ImGui::InputFloat("##rot_input", &rotation)) {
-			mSelectedGameObject->sprite->setRotation(sf::degrees(rotation));
+			objects.SetRotation(index, sf::degrees(rotation));
+			ObjectTransformChanged(index);
 		}
 		ImGui::PopItemWidth();
 		ImGui::SameLine();
-		float rotationRad = mSelectedGameObject->sprite->getRotation().asRadians();
+		float rotationRad = objects.GetRotations()[index].asRadians();
 		if (rotationRad > PI)
 		{
 			rotationRad -= 2 * PI;
 		}
 		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x - ImGui::GetStyle().ItemSpacing.x);
 		if (ImGui::SliderAngle("##rot_slider", &rotationRad, -180.f, 180.f)) {
-			mSelectedGameObject->sprite->setRotation(sf::radians(rotationRad));
+			objects.SetRotation(index, sf::radians(rotationRad));
+			ObjectTransformChanged(index);
 		}
 		ImGui::PopItemWidth();
 	}
 
+	const ObjectTransform after = ObjectTransform::Of(objects, index);
+	if (after != before)
+	{
+		mEditJournal.RecordTransform(mSelectedGameObject, before, after);
+		mAutosave.ObjectChanged(objects, index);
+	}
+
 	ImGui::Separator();
 
 	{
-		auto it = std::find_if(mProject.level.gameObjects.begin(), mProject.level.gameObjects.end(),
-			[this](const std::unique_ptr<GameObject>& ptr) {
-				return ptr.get() == mSelectedGameObject;
-			});
 		if (ImGui::Button("Put in Front", { ImGui::GetContentRegionAvail().x , 0 }))
 		{
-			std::rotate(it, it+1, mProject.level.gameObjects.end());
+			mEditJournal.BringToFront(mProject.level, mSelectedGameObject);
+			mAutosave.ObjectMoved(index, objects.GetCount() - 1);
+			mSpriteBatcher.MarkStructureDirty();
 		}
 	}
 }
@@ -804,6 +1334,8 @@ void Application::RenderAssetPropertiesUI()
 {
 	const float PI = 3.1415926535f;
 	Asset* asset = mProject.assets.at(mSelectedAssetID.value()).get();
+	const sf::Vector2f scaleBefore = asset->defaultScale;
+	const sf::Angle rotationBefore = asset->defaultRotation;
 	{
 		ImGui::Text("Scale");
 		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x / 2 - ImGui::GetStyle().ItemSpacing.x);
@@ -819,14 +1351,19 @@ void Application::RenderAssetPropertiesUI()
 		ImGui::PopItemWidth();
 		if (ImGui::Button("Apply Scale to Instances", { ImGui::GetContentRegionAvail().x , 0 }))
 		{
-			for (unique<GameObject>& gameObjectUnique : mProject.level.gameObjects)
+			GameObjectStore& objects = mProject.level.gameObjects;
+			objects.GetInstances(NameTable::Assets().Intern(mSelectedAssetID.value()), mAssetInstances);
+			List<EditJournal::TransformChange> changes;
+			changes.reserve(mAssetInstances.size());
+			for (size_t i : mAssetInstances)
 			{
-				GameObject* gameObject = gameObjectUnique.get();
-				if (gameObject->assetID == mSelectedAssetID)
-				{
-					gameObject->sprite->setScale(asset->defaultScale);
-				}
+				const ObjectTransform before = ObjectTransform::Of(objects, i);
+				objects.SetScale(i, asset->defaultScale);
+				ObjectTransformChanged(i);
+				changes.push_back({ objects.HandleAt(i), before, ObjectTransform::Of(objects, i) });
+				mAutosave.ObjectChanged(objects, i);
 			}
+			mEditJournal.RecordTransforms(std::move(changes));
 			
 		}
 	}
@@ -859,18 +1396,28 @@ void Application::RenderAssetPropertiesUI()
 		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x);
 		if (ImGui::Button("Apply Rotation to Instances", { ImGui::GetContentRegionAvail().x , 0 }))
 		{
-			for (unique<GameObject>& gameObjectUnique : mProject.level.gameObjects)
+			GameObjectStore& objects = mProject.level.gameObjects;
+			objects.GetInstances(NameTable::Assets().Intern(mSelectedAssetID.value()), mAssetInstances);
+			List<EditJournal::TransformChange> changes;
+			changes.reserve(mAssetInstances.size());
+			for (size_t i : mAssetInstances)
 			{
-				GameObject* gameObject = gameObjectUnique.get();
-				if (gameObject->assetID == mSelectedAssetID)
-				{
-					gameObject->sprite->setRotation(asset->defaultRotation);
-				}
+				const ObjectTransform before = ObjectTransform::Of(objects, i);
+				objects.SetRotation(i, asset->defaultRotation);
+				ObjectTransformChanged(i);
+				changes.push_back({ objects.HandleAt(i), before, ObjectTransform::Of(objects, i) });
+				mAutosave.ObjectChanged(objects, i);
 			}
+			mEditJournal.RecordTransforms(std::move(changes));
 
 		}
 		ImGui::PopItemWidth();
 	}
+
+	if (asset->defaultScale != scaleBefore || asset->defaultRotation != rotationBefore)
+	{
+		mAutosave.AssetChanged(mSelectedAssetID.value(), *asset);
+	}
 }
 
 void Application::RenderAssetLibraryUI()
@@ -884,26 +1431,31 @@ void Application::RenderAssetLibraryUI()
 
 	for (const auto& pair : assets)
 	{
-		const sf::Texture* texture = AssetManager::Get().GetTexture(pair.first);
-		if (!texture)
+		const sf::Sprite* thumbnail = mThumbnails.GetSprite(pair.first);
+		if (!thumbnail)
 		{
+			RenderAssetPlaceholderUI(pair.first, mThumbnails.GetStatus(pair.first) == TextureStatus::Failed);
+			float lastItem_x2 = ImGui::GetItemRectMax().x;
+			if (lastItem_x2 + padding + thumbnailSize.x < windowVisible_x2)
+			{
+				ImGui::SameLine();
+			}
 			continue;
 		}
-		sf::Sprite sprite(*texture);
 		ImGui::PushID(pair.first.c_str());
 		ImGui::BeginGroup();
 		{
-			std::string assetName = pair.first;
+			const std::string& assetName = pair.first;
 			ImVec2 thumbnailSize = { 80.0f, 80.0f };
 			ImVec2 cursorPos = ImGui::GetCursorScreenPos();
 
 			if (ImGui::Button("##assetButton", thumbnailSize))
 			{
 				mSelectedAssetID = assetName;
-				mSelectedGameObject = nullptr;
+				mSelectedGameObject = {};
 			}
 
-			sf::Vector2f textureSize = sf::Vector2f(texture->getSize());
+			sf::Vector2f textureSize = sf::Vector2f(thumbnail->getTextureRect().size);
 			ImVec2 imageSize = thumbnailSize;
 			ImVec2 imagePos = cursorPos;
 
@@ -922,13 +1474,13 @@ void Application::RenderAssetLibraryUI()
 			if (ImGui::BeginDragDropSource())
 			{
 				ImGui::SetDragDropPayload("ASSET_PAYLOAD", assetName.c_str(), assetName.length() + 1);
-				ImGui::Image(*texture, imageSize);
+				ImGui::Image(*thumbnail, imageSize);
 				ImGui::Text("%s", assetName.c_str());
 				ImGui::EndDragDropSource();
 			}
 
 			ImGui::SetCursorScreenPos({ imagePos.x + 0.1f * thumbnailSize.x, imagePos.y + 0.1f * thumbnailSize.y });
-			ImGui::Image(*texture, { imageSize.x * 0.8f, imageSize.y * 0.8f });
+			ImGui::Image(*thumbnail, { imageSize.x * 0.8f, imageSize.y * 0.8f });
 
 			ImGui::SetCursorScreenPos({ cursorPos.x, cursorPos.y + thumbnailSize.y });
 			ImGui::TextWrapped("%s", assetName.c_str());
@@ -944,37 +1496,170 @@ void Application::RenderAssetLibraryUI()
 	}
 }
 
-void Application::RenderGameObjectsUI()
+void Application::RenderAssetPlaceholderUI(const std::string& assetName, bool failed)
 {
-	int index = 0;
-	for (auto it = mProject.level.gameObjects.begin(); it != mProject.level.gameObjects.end(); )
+	ImGui::PushID(assetName.c_str());
+	ImGui::BeginGroup();
 	{
-		ImGui::PushID(index);
-		GameObject* gameObject = it->get();
-		float buttonWidth = ImGui::GetContentRegionAvail().x - 20.f;
-		bool isSelected = false;
-		if (gameObject == mSelectedGameObject)
+		ImVec2 thumbnailSize = { 80.0f, 80.0f };
+		if (ImGui::Button(failed ? "Missing##assetButton" : "Loading...##assetButton", thumbnailSize))
 		{
-			isSelected = true;
+			mSelectedAssetID = assetName;
+			mSelectedGameObject = {};
 		}
-		std::string label = (gameObject->assetID + "##game_object_list_item");
-		if (ImGui::Selectable(label.c_str(), isSelected, 0, { buttonWidth, 0 }))
+		ImGui::TextWrapped("%s", assetName.c_str());
+	}
+	ImGui::EndGroup();
+	ImGui::PopID();
+}
+
+void Application::RenderGameObjectsUI()
+{
+	GameObjectStore& objects = mProject.level.gameObjects;
+	ImGui::SetNextItemWidth(-1.f);
+	ImGui::InputTextWithHint("##game_object_filter", "Filter by Asset ID", &mObjectFilterText);
+	ImGui::Checkbox("In View", &mObjectFilterInView);
+	ImGui::SameLine();
+	ImGui::Checkbox("Selected Only", &mObjectFilterSelectedOnly);
+
+	mObjectFilter.SetText(mObjectFilterText);
+	std::optional<sf::FloatRect> region;
+	if (mObjectFilterInView)
+	{
+		region = sf::FloatRect(mLevelView.getCenter() - mLevelView.getSize() / 2.f, mLevelView.getSize());
+	}
+	mObjectFilter.SetRegion(region);
+	mObjectFilter.SetSelectedOnly(mObjectFilterSelectedOnly, mSelectedGameObject);
+	mObjectFilter.Update(objects, mProject.level.spatialIndex);
+	const size_t rowCount = mObjectFilter.GetRowCount();
+	ImGui::SameLine();
+	ImGui::TextDisabled("%zu / %zu", rowCount, objects.GetCount());
+
+	// Only the rows in sight are submitted; removal waits until the list is drawn
+	// so the rows keep their indices while it is.
+	GameObjectHandle removed;
+	size_t removedIndex = 0;
+	if (ImGui::BeginChild("##game_object_list"))
+	{
+		const float buttonWidth = ImGui::GetContentRegionAvail().x - 20.f;
+		ImGuiListClipper clipper;
+		clipper.Begin(static_cast<int>(rowCount));
+		while (clipper.Step())
 		{
-			mSelectedGameObject = gameObject;
-			mSelectedAssetID.reset();
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+			{
+				const size_t i = mObjectFilter.GetIndex(static_cast<size_t>(row));
+				const GameObjectHandle handle = objects.HandleAt(i);
+				ImGui::PushID(static_cast<int>(handle.slot));
+				// Asset IDs are interned, so the label needs no string built per row.
+				if (ImGui::Selectable(objects.GetAssetID(i).c_str(), handle == mSelectedGameObject, 0, { buttonWidth, 0 }))
+				{
+					mSelectedGameObject = handle;
+					mSelectedAssetID.reset();
+				}
+				ImGui::SameLine();
+				if (ImGui::Button("X"))
+				{
+					removed = handle;
+					removedIndex = i;
+				}
+				ImGui::PopID();
+			}
 		}
-		ImGui::SameLine();
-		if (ImGui::Button("X"))
+	}
+	ImGui::EndChild();
+
+	if (!removed.IsNull())
+	{
+		mEditJournal.RecordRemove(mProject.level, removed);
+		mAutosave.ObjectRemoved(removedIndex);
+		mProject.level.removeGameObject(removed);
+		if (removed == mSelectedGameObject) mSelectedGameObject = {};
+		mSpriteBatcher.MarkStructureDirty();
+	}
+}
+
+void Application::ObjectTransformChanged(size_t index)
+{
+	const GameObjectStore& objects = mProject.level.gameObjects;
+	mSpriteBatcher.MarkDirty(index);
+	mProject.level.spatialIndex.Update(objects.HandleAt(index), objects.GetBounds(index));
+}
+
+void Application::HandleEditShortcuts()
+{
+	// A gesture ends once the mouse and every widget are released; until then
+	// consecutive changes to one object undo as a single step.
+	if (!ImGui::IsAnyItemActive() && !ImGui::IsMouseDown(ImGuiMouseButton_Left))
+	{
+		mEditJournal.Seal();
+	}
+	const ImGuiIO& io = ImGui::GetIO();
+	if (!mProjectInitialized || io.WantTextInput || !io.KeyCtrl)
+	{
+		return;
+	}
+	if (ImGui::IsKeyPressed(ImGuiKey_Z))
+	{
+		io.KeyShift ? RedoEdit() : UndoEdit();
+	}
+	else if (ImGui::IsKeyPressed(ImGuiKey_Y))
+	{
+		RedoEdit();
+	}
+}
+
+void Application::UndoEdit()
+{
+	EditJournal::Change change;
+	if (mEditJournal.Undo(mProject.level, change))
+	{
+		EditChanged(change);
+	}
+}
+
+void Application::RedoEdit()
+{
+	EditJournal::Change change;
+	if (mEditJournal.Redo(mProject.level, change))
+	{
+		EditChanged(change);
+	}
+}
+
+void Application::EditChanged(const EditJournal::Change& change)
+{
+	const GameObjectStore& objects = mProject.level.gameObjects;
+	switch (change.structure)
+	{
+	case EditJournal::Change::Structure::Added:
+		mAutosave.ObjectAdded(objects, change.index);
+		break;
+	case EditJournal::Change::Structure::Removed:
+		mAutosave.ObjectRemoved(change.index);
+		break;
+	case EditJournal::Change::Structure::Moved:
+		mAutosave.ObjectMoved(change.index, change.toIndex);
+		break;
+	case EditJournal::Change::Structure::None:
+		break;
+	}
+	if (change.IsStructural())
+	{
+		mSpriteBatcher.MarkStructureDirty();
+	}
+	for (GameObjectHandle object : change.transformed)
+	{
+		const size_t index = objects.IndexOf(object);
+		if (index != GameObjectStore::kInvalidIndex)
 		{
-			it = mProject.level.gameObjects.erase(it);
-			if (gameObject == mSelectedGameObject) mSelectedGameObject = nullptr;
-			++index;
+			mSpriteBatcher.MarkDirty(index);
+			mAutosave.ObjectChanged(objects, index);
 		}
-		else {
-			++it;
-			++index;
-		}
-		ImGui::PopID();
+	}
+	if (!objects.IsValid(mSelectedGameObject))
+	{
+		mSelectedGameObject = {};
 	}
 }
 
@@ -983,16 +1668,93 @@ void Application::LoadProjectTextures()
 	AssetManager::Get().Clear();
 	for (const auto& assetPair : mProject.assets)
 	{
-		AssetManager::Get().LoadTexture(assetPair.first, assetPair.second.get()->texturePath);
+		AssetManager::Get().LoadTextureAsync(assetPair.first, assetPair.second.get()->texturePath);
+	}
+	mThumbnails.Clear();
+	for (const auto& assetPair : mProject.assets)
+	{
+		mThumbnails.Request(assetPair.first, assetPair.second->texturePath);
+	}
+	mBackground.Load(mProject.backgroundTexturePath);
+	mSpriteBatcher.MarkStructureDirty();
+}
+
+void Application::UploadPendingTextures()
+{
+	PROFILE_FUNCTION();
+	mBackground.ProcessPendingUploads(kTextureUploadBudget);
+	if (mThumbnails.HasPendingThumbnails())
+	{
+		mThumbnails.ProcessPendingUploads(kTextureUploadBudget);
+	}
+	if (mBackground.TakeOpened())
+	{
+		sf::Vector2f backgroundSize = sf::Vector2f(mBackground.GetSize());
+		mLevelView.setSize(backgroundSize);
+		mLevelView.setCenter(backgroundSize / 2.f);
+	}
+	if (!AssetManager::Get().Trim().empty())
+	{
+		mSpriteBatcher.MarkStructureDirty();
+	}
+	if (!AssetManager::Get().HasPendingTextures())
+	{
+		return;
+	}
+	List<std::string> finished = AssetManager::Get().ProcessPendingUploads(kTextureUploadBudget);
+	if (!finished.empty())
+	{
+		mSpriteBatcher.MarkStructureDirty();
+	}
+	for (const std::string& name : finished)
+	{
+		if (AssetManager::Get().GetTextureStatus(name) != TextureStatus::Ready)
+		{
+			std::cerr << "Failed to load texture: " << name << std::endl;
+			continue;
+		}
+		AssignProjectTextures(NameTable::Assets().Intern(name));
+	}
+}
+
+void Application::PinSceneTextures()
+{
+	// The new handles are taken before the old ones go, so a texture that stays in view
+	// is never unpinned in between.
+	const GameObjectStore& objects = mProject.level.gameObjects;
+	List<TextureHandle> pinned;
+	for (GameObjectHandle object : mVisibleObjects)
+	{
+		const size_t index = objects.IndexOf(object);
+		if (index == GameObjectStore::kInvalidIndex)
+		{
+			continue;
+		}
+		const AssetIndex asset = objects.GetAssets()[index];
+		if (asset >= mSceneAssetSeen.size())
+		{
+			mSceneAssetSeen.resize(asset + 1, false);
+		}
+		if (!mSceneAssetSeen[asset])
+		{
+			mSceneAssetSeen[asset] = true;
+			pinned.push_back(AssetManager::Get().Acquire(asset));
+		}
+	}
+	for (const TextureHandle& texture : pinned)
+	{
+		mSceneAssetSeen[texture.GetAsset()] = false;
 	}
-	AssetManager::Get().LoadTexture(mBackgroundTextureID, mProject.backgroundTexturePath);
+	mSceneTextures.swap(pinned);
 }
 
-void Application::AssignProjectTextures()
+void Application::AssignProjectTextures(AssetIndex asset)
 {
-	for (unique<GameObject>& objectPtr : mProject.level.gameObjects)
+	GameObjectStore& objects = mProject.level.gameObjects;
+	objects.GetInstances(asset, mAssetInstances);
+	for (size_t i : mAssetInstances)
 	{
-		const sf::Texture* texture = AssetManager::Get().GetTexture(objectPtr->assetID);
-		objectPtr->sprite.value().setTexture(*texture, true);
+		AssetManager::Get().BindTexture(objects, i);
+		mProject.level.spatialIndex.Update(objects.HandleAt(i), objects.GetBounds(i));
 	}
 }
\ No newline at end of file
@@ -1,11 +1,24 @@
 #pragma once
 
+#include <cstdint>
+#include <ctime>
 #include <imgui.h>
 #include <imgui-SFML.h>
 #include <SFML/Graphics.hpp>
+#include "io/AutosaveLog.h"
+#include "io/BackgroundWriter.h"
+#include "level/EditJournal.h"
+#include "level/GameObjectFilter.h"
 #include "level/Level.h"
+#include "level/VectorizationJob.h"
+#include "project/AssetManager.h"
+#include "core/Profiler.h"
 #include "core/Utils.h"
 #include "project/Project.h"
+#include "render/HitboxRenderer.h"
+#include "render/SpriteBatcher.h"
+#include "render/ThumbnailCache.h"
+#include "render/TiledBackground.h"
 
 namespace vle
 {
@@ -13,7 +26,8 @@ namespace vle
 		Idle, // Nessuna azione
 		Selection,  // Mostra "Nuovo/Carica"
 		LoadProject,
-		CreateProject   // Mostra la configurazione del nuovo progetto
+		CreateProject,   // Mostra la configurazione del nuovo progetto
+		Vectorizing // Traccia le hitbox in background
 	};
 
 	struct AssetCreationInfo {
@@ -21,6 +35,29 @@ namespace vle
 		std::string texturePath;
 	};
 
+	// What the level canvas was last rendered with; the scene is redrawn only when it differs.
+	struct SceneState {
+		sf::Vector2f viewCenter;
+		sf::Vector2f viewSize;
+		sf::FloatRect viewport;
+		sf::Vector2u canvasSize;
+		GameObjectHandle selectedGameObject;
+		bool showHitboxes = false;
+		bool valid = false;
+	};
+
+	struct FrameStats {
+		unsigned long long frameCount = 0;
+		unsigned long long sceneRenderCount = 0;
+		unsigned int framesInWindow = 0;
+		unsigned int scenesInWindow = 0;
+		float framesPerSecond = 0.f;
+		float scenesPerSecond = 0.f;
+		float cpuPercent = 0.f;
+		std::clock_t windowCpuStart = std::clock();
+		sf::Clock windowClock;
+	};
+
 	class Application
 	{
 	public:
@@ -33,6 +70,10 @@ namespace vle
 		Application& operator=(Application&&) = delete;
 
 	private:
+		void HandleEvent(const sf::Event& event);
+		bool IsIdle() const;
+		bool SceneNeedsRedraw() const;
+		void UpdateFrameStats();
 		virtual void Tick(sf::Time deltaTime);
 		virtual void Render();
 		virtual void RenderUI(sf::Time deltaTime);
@@ -40,19 +81,40 @@ namespace vle
 		void RenderScene();
 		void RenderEditorUI();
 		void RenderMainMenuBarUI();
+		void SaveProject(const std::string& path);
+		void ExportLevel(const std::string& path, bool binary);
+		void RenderWriteStatusUI();
+		void RenderTextureMemoryUI();
+		void RenderProfilerUI();
+		void HitboxMapChanged();
+		const shared<const List<sf::VertexArray>>& GetHitboxSnapshot();
+		void FlushAutosave();
 		void LoadProjectDialog();
 		void LoadProject();
+		void OpenProject(const std::string& path, bool recover);
+		void RenderRecoveryUI();
 		void RenderLevelCanvasUI();
 		void RenderPropertiesUI();
 		void RenderGameObjectPropertiesUI();
 		void RenderAssetPropertiesUI();
 		void RenderAssetLibraryUI();
+		void RenderAssetPlaceholderUI(const std::string& assetName, bool failed);
 		void RenderGameObjectsUI();
 		void RenderWizardUI();
 		void RenderCreateProject();
 		bool ProjectInitialization();
+		void CompleteProjectInitialization();
+		void RenderVectorizationUI();
 		void LoadProjectTextures();
-		void AssignProjectTextures();
+		void UploadPendingTextures();
+		void AssignProjectTextures(AssetIndex asset);
+		// Keeps the textures of the objects in view resident.
+		void PinSceneTextures();
+		void ObjectTransformChanged(size_t index);
+		void HandleEditShortcuts();
+		void UndoEdit();
+		void RedoEdit();
+		void EditChanged(const EditJournal::Change& change);
 
 		sf::RenderWindow mWindow;
 		sf::Clock mTickClock;
@@ -60,6 +122,30 @@ namespace vle
 
 		sf::RenderTexture mLevelCanvas;
 		sf::View mLevelView;
+		SpriteBatcher mSpriteBatcher;
+		List<GameObjectHandle> mVisibleObjects;
+		List<TextureHandle> mSceneTextures;
+		// Scratch flags by asset index while mSceneTextures is rebuilt.
+		List<bool> mSceneAssetSeen;
+		int mTextureBudgetMB;
+		HitboxRenderer mHitboxRenderer;
+		TiledBackground mBackground;
+		ThumbnailCache mThumbnails;
+		EditJournal mEditJournal;
+		int mEditHistoryLimitMB;
+		BackgroundWriter mBackgroundWriter;
+		// Copy of the hitbox map shared by every snapshot until the map is replaced.
+		shared<const List<sf::VertexArray>> mHitboxSnapshot;
+		std::string mWriteStatus;
+		bool mWriteFailed;
+		sf::Clock mWriteStatusClock;
+		AutosaveLog mAutosave;
+		sf::Clock mAutosaveClock;
+		// The project save in flight and the autosave change count it was taken at.
+		std::string mSavingProjectPath;
+		std::uint64_t mSavingChangeCount;
+		// A project whose autosave log the user is asked to recover or discard.
+		std::string mRecoveryPath;
 
 
 		float mCleanCycleInterval;
@@ -70,14 +156,25 @@ namespace vle
 		bool mMissingBackgroundPath;
 		bool mMissingHitboxPath;
 		bool mShowHitboxes;
+		bool mShowFrameStats;
+		bool mShowTextureMemory;
+		bool mShowProfiler;
+		GameObjectFilter mObjectFilter;
+		std::string mObjectFilterText;
+		bool mObjectFilterInView;
+		bool mObjectFilterSelectedOnly;
+		int mActiveFramesLeft;
+		SceneState mLastSceneState;
+		FrameStats mFrameStats;
 		ProjectWizardState mWizardState;
 		Project mTempSetupProject;
 		List<AssetData> mTempAssetList;
+		unique<VectorizationJob> mVectorizationJob;
 		Project mProject;
-		std::string mBackgroundTextureID;
 		sf::Vector2f mTempObjectPos;
 
-		GameObject* mSelectedGameObject;
+		GameObjectHandle mSelectedGameObject;
 		std::optional<std::string> mSelectedAssetID;
+		List<size_t> mAssetInstances;
 	};
 }
\ No newline at end of file
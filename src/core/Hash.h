@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vle {
+	// The editor's caches live in this directory next to the files they were made from,
+	// each entry named after a hash of its source.
+	inline constexpr char kCacheDirectory[] = ".vle_cache";
+
+	inline constexpr std::uint64_t kFnvOffset = 14695981039346656037ull;
+	inline constexpr std::uint64_t kFnvPrime = 1099511628211ull;
+
+	// 64-bit FNV-1a. Pass a previous result as the hash to continue over more data.
+	inline std::uint64_t Fnv1a(const void* data, size_t size, std::uint64_t hash = kFnvOffset)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= kFnvPrime;
+		}
+		return hash;
+	}
+
+	inline std::uint64_t Fnv1a(const std::string& text, std::uint64_t hash = kFnvOffset)
+	{
+		return Fnv1a(text.data(), text.size(), hash);
+	}
+}
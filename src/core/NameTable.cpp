@@ -0,0 +1,87 @@
+#include "NameTable.h"
+
+using namespace vle;
+
+NameTable& NameTable::Assets()
+{
+	static NameTable assetNames;
+	return assetNames;
+}
+
+NameTable::NameTable()
+	: mCount{ 0 }
+{
+	for (std::atomic<std::string*>& bucket : mBuckets)
+	{
+		bucket.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+NameTable::~NameTable()
+{
+	for (std::atomic<std::string*>& bucket : mBuckets)
+	{
+		delete[] bucket.load(std::memory_order_relaxed);
+	}
+}
+
+NameTable::Index NameTable::Intern(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto found = mIndices.find(name);
+	if (found != mIndices.end())
+	{
+		return found->second;
+	}
+	const size_t count = mCount.load(std::memory_order_relaxed);
+	size_t bucket = 0;
+	size_t offset = 0;
+	Locate(count, bucket, offset);
+	std::string* names = mBuckets[bucket].load(std::memory_order_relaxed);
+	if (!names)
+	{
+		names = new std::string[size_t(1) << (bucket + kFirstBucketBits)];
+		mBuckets[bucket].store(names, std::memory_order_release);
+	}
+	names[offset] = name;
+	const Index index = static_cast<Index>(count);
+	mIndices.emplace(names[offset], index);
+	mCount.store(count + 1, std::memory_order_release);
+	return index;
+}
+
+std::optional<NameTable::Index> NameTable::Find(const std::string& name) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto found = mIndices.find(name);
+	if (found != mIndices.end())
+	{
+		return found->second;
+	}
+	return std::nullopt;
+}
+
+const std::string& NameTable::GetName(Index index) const
+{
+	size_t bucket = 0;
+	size_t offset = 0;
+	Locate(index, bucket, offset);
+	return mBuckets[bucket].load(std::memory_order_acquire)[offset];
+}
+
+size_t NameTable::GetCount() const
+{
+	return mCount.load(std::memory_order_acquire);
+}
+
+void NameTable::Locate(size_t index, size_t& bucket, size_t& offset)
+{
+	// Shifted so bucket b starts at 2^(b + kFirstBucketBits) - 2^kFirstBucketBits.
+	const size_t slot = index + (size_t(1) << kFirstBucketBits);
+	bucket = 0;
+	while (slot >> (bucket + kFirstBucketBits + 1))
+	{
+		bucket++;
+	}
+	offset = slot - (size_t(1) << (bucket + kFirstBucketBits));
+}
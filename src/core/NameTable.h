@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "core/Utils.h"
+
+namespace vle {
+	// Maps names to dense indices, so hot paths compare and look up integers instead
+	// of hashing strings. Names are never removed: an index stays valid for the whole
+	// run and can address flat per-name arrays. Safe to use from several threads;
+	// GetName and GetCount never lock, so UI code can call them for every row.
+	class NameTable
+	{
+	public:
+		using Index = std::uint32_t;
+
+		// Asset names, shared by game objects and the asset manager.
+		static NameTable& Assets();
+
+		NameTable();
+		~NameTable();
+		NameTable(const NameTable&) = delete;
+		NameTable& operator=(const NameTable&) = delete;
+
+		Index Intern(const std::string& name);
+		std::optional<Index> Find(const std::string& name) const;
+		// The reference stays valid while other names are interned.
+		const std::string& GetName(Index index) const;
+		size_t GetCount() const;
+
+	private:
+		// Names are stored in buckets that double in size and are never reallocated, so
+		// a name can be read without the lock while another thread appends. Bucket b
+		// holds 2^(b + kFirstBucketBits) names; together they cover every Index.
+		static constexpr size_t kFirstBucketBits = 6;
+		static constexpr size_t kBucketCount = 33 - kFirstBucketBits;
+		static void Locate(size_t index, size_t& bucket, size_t& offset);
+
+		// Only taken by Intern and Find.
+		mutable std::mutex mMutex;
+		std::array<std::atomic<std::string*>, kBucketCount> mBuckets;
+		// Published after the name it counts is stored.
+		std::atomic<size_t> mCount;
+		// Keys view the strings in mBuckets, which never move.
+		Dictionary<std::string_view, Index> mIndices;
+	};
+
+	using AssetIndex = NameTable::Index;
+}
@@ -0,0 +1,235 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+using namespace vle;
+
+namespace
+{
+	const std::chrono::steady_clock::time_point kEpoch = std::chrono::steady_clock::now();
+
+	void WriteEscaped(std::ostream& stream, const std::string& text)
+	{
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				stream << '\\';
+			}
+			stream << (static_cast<unsigned char>(c) < 0x20 ? ' ' : c);
+		}
+	}
+}
+
+Profiler& Profiler::Get()
+{
+	// Never destroyed: worker threads of other singletons may still record zones while
+	// static objects are torn down at exit.
+	static Profiler* profiler = new Profiler;
+	return *profiler;
+}
+
+Profiler::Profiler()
+	: mEnabled{ true },
+	mNextThreadId{ 1 },
+	mFrameStart{ 0 },
+	mFrameTimes{},
+	mFrameCount{ 0 }
+{
+}
+
+std::uint64_t Profiler::Now()
+{
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - kEpoch).count());
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	Profiler& self = Get();
+	ThreadBuffer& buffer = self.GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(self.mThreadsMutex);
+	buffer.name = name;
+}
+
+void Profiler::BeginFrame()
+{
+	mFrameStart = Now();
+}
+
+void Profiler::EndFrame()
+{
+	mFrameTimes[mFrameCount % kFrameHistory] = static_cast<float>(Now() - mFrameStart) / 1e6f;
+	mFrameCount++;
+}
+
+List<float> Profiler::GetFrameTimes() const
+{
+	List<float> times;
+	const size_t count = std::min(mFrameCount, kFrameHistory);
+	times.reserve(count);
+	for (size_t i = mFrameCount - count; i < mFrameCount; i++)
+	{
+		times.push_back(mFrameTimes[i % kFrameHistory]);
+	}
+	return times;
+}
+
+List<ProfileEvent> Profiler::CollectEvents(std::uint64_t since) const
+{
+	List<ProfileEvent> events;
+	std::lock_guard<std::mutex> lock(mThreadsMutex);
+	for (const unique<ThreadBuffer>& buffer : mThreads)
+	{
+		const std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+		const std::uint64_t first = written > kEventsPerThread ? written - kEventsPerThread : 0;
+		const size_t copiedFrom = events.size();
+		for (std::uint64_t i = first; i < written; i++)
+		{
+			events.push_back(buffer->events[i % kEventsPerThread]);
+		}
+		// The thread kept writing while this copied; the oldest slots may hold newer zones now.
+		const std::uint64_t after = buffer->written.load(std::memory_order_acquire);
+		const std::uint64_t overwritten = after > kEventsPerThread ? after - kEventsPerThread : 0;
+		const size_t stale = static_cast<size_t>(std::max(first, overwritten) - first);
+		events.erase(events.begin() + copiedFrom, events.begin() + copiedFrom + std::min(stale, events.size() - copiedFrom));
+	}
+	events.erase(std::remove_if(events.begin(), events.end(), [since](const ProfileEvent& event) { return event.end < since; }), events.end());
+	std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b) { return a.start < b.start; });
+	return events;
+}
+
+List<ProfileZoneStats> Profiler::GetSlowestZones(std::uint64_t window, size_t count) const
+{
+	const std::uint64_t now = Now();
+	Dictionary<std::string, ProfileZoneStats> byName;
+	for (const ProfileEvent& event : CollectEvents(now > window ? now - window : 0))
+	{
+		ProfileZoneStats& stats = byName[event.name];
+		const double ms = static_cast<double>(event.end - event.start) / 1e6;
+		stats.name = event.name;
+		stats.calls++;
+		stats.totalMs += ms;
+		stats.maxMs = std::max(stats.maxMs, ms);
+	}
+	List<ProfileZoneStats> zones;
+	zones.reserve(byName.size());
+	for (auto& pair : byName)
+	{
+		zones.push_back(pair.second);
+	}
+	std::sort(zones.begin(), zones.end(), [](const ProfileZoneStats& a, const ProfileZoneStats& b) { return a.totalMs > b.totalMs; });
+	if (zones.size() > count)
+	{
+		zones.resize(count);
+	}
+	return zones;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const
+{
+	const List<ProfileEvent> events = CollectEvents();
+	std::ofstream file(path, std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "Error: cannot write trace " << path << std::endl;
+		return false;
+	}
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	{
+		std::lock_guard<std::mutex> lock(mThreadsMutex);
+		for (const unique<ThreadBuffer>& buffer : mThreads)
+		{
+			file << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":\"";
+			WriteEscaped(file, buffer->name.empty() ? "Thread " + std::to_string(buffer->id) : buffer->name);
+			file << "\"}}";
+			first = false;
+		}
+	}
+	file.setf(std::ios::fixed);
+	file.precision(3);
+	for (const ProfileEvent& event : events)
+	{
+		// Complete events, in microseconds.
+		file << (first ? "" : ",") << "\n{\"ph\":\"X\",\"name\":\"";
+		WriteEscaped(file, event.name);
+		file << "\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start / 1000.0
+			<< ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+		first = false;
+	}
+	file << "\n]}\n";
+	if (!file)
+	{
+		std::cerr << "Error: cannot write trace " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+	struct Lease
+	{
+		ThreadBuffer* buffer = nullptr;
+		~Lease()
+		{
+			if (buffer)
+			{
+				buffer->inUse.store(false, std::memory_order_release);
+			}
+		}
+	};
+	thread_local Lease lease;
+	if (!lease.buffer)
+	{
+		std::lock_guard<std::mutex> lock(mThreadsMutex);
+		for (const unique<ThreadBuffer>& buffer : mThreads)
+		{
+			if (!buffer->inUse.load(std::memory_order_acquire))
+			{
+				lease.buffer = buffer.get();
+				break;
+			}
+		}
+		if (!lease.buffer)
+		{
+			mThreads.push_back(std::make_unique<ThreadBuffer>());
+			lease.buffer = mThreads.back().get();
+		}
+		// A new id keeps the zones of the previous owner apart in traces.
+		lease.buffer->inUse.store(true, std::memory_order_relaxed);
+		lease.buffer->id = mNextThreadId++;
+		lease.buffer->depth = 0;
+		lease.buffer->name.clear();
+	}
+	return *lease.buffer;
+}
+
+ProfileZone::ProfileZone(const char* name)
+	: mName{ nullptr },
+	mStart{ 0 }
+{
+	Profiler& profiler = Profiler::Get();
+	if (profiler.IsEnabled())
+	{
+		mName = name;
+		profiler.GetThreadBuffer().depth++;
+		mStart = Profiler::Now();
+	}
+}
+
+ProfileZone::~ProfileZone()
+{
+	if (!mName)
+	{
+		return;
+	}
+	const std::uint64_t end = Profiler::Now();
+	Profiler::ThreadBuffer& buffer = Profiler::Get().GetThreadBuffer();
+	buffer.depth--;
+	const std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+	buffer.events[index % Profiler::kEventsPerThread] = ProfileEvent{ mName, mStart, end, buffer.id, buffer.depth };
+	buffer.written.store(index + 1, std::memory_order_release);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "core/Utils.h"
+
+namespace vle {
+	// A zone that finished, in nanoseconds since the profiler started.
+	struct ProfileEvent
+	{
+		const char* name;
+		std::uint64_t start;
+		std::uint64_t end;
+		std::uint32_t thread;
+		std::uint32_t depth;
+	};
+
+	struct ProfileZoneStats
+	{
+		const char* name;
+		unsigned int calls = 0;
+		double totalMs = 0.0;
+		double maxMs = 0.0;
+	};
+
+	// Collects timed zones from every thread. Each thread writes to a ring buffer of its
+	// own without locking; readers copy the buffers and drop whatever was overwritten
+	// while they copied. Only the last kEventsPerThread zones of a thread are kept.
+	class Profiler
+	{
+	public:
+		static constexpr size_t kEventsPerThread = 1 << 14;
+		static constexpr size_t kFrameHistory = 240;
+
+		static Profiler& Get();
+
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		static std::uint64_t Now();
+		// Names the calling thread in traces.
+		static void SetThreadName(const std::string& name);
+
+		void SetEnabled(bool enabled) { mEnabled.store(enabled, std::memory_order_relaxed); }
+		bool IsEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+		// Brackets the busy part of a frame on the main thread; idle waits stay outside.
+		void BeginFrame();
+		void EndFrame();
+		// Milliseconds of the last kFrameHistory frames, oldest first.
+		List<float> GetFrameTimes() const;
+
+		// Zones of every thread that ended at or after since, by start time.
+		List<ProfileEvent> CollectEvents(std::uint64_t since = 0) const;
+		// Per-name totals of the zones that ended in the last window nanoseconds, slowest first.
+		List<ProfileZoneStats> GetSlowestZones(std::uint64_t window, size_t count) const;
+		// Writes every zone still buffered in the Chrome trace_event format, which
+		// chrome://tracing and Perfetto open.
+		bool WriteChromeTrace(const std::string& path) const;
+
+	private:
+		friend class ProfileZone;
+
+		struct ThreadBuffer
+		{
+			std::array<ProfileEvent, kEventsPerThread> events;
+			std::atomic<std::uint64_t> written{ 0 };
+			// Cleared when the thread exits, so the next new thread takes the buffer over.
+			std::atomic<bool> inUse{ true };
+			std::uint32_t id = 0;
+			std::uint32_t depth = 0;
+			std::string name;
+		};
+
+		Profiler();
+		ThreadBuffer& GetThreadBuffer();
+
+		std::atomic<bool> mEnabled;
+		mutable std::mutex mThreadsMutex;
+		List<unique<ThreadBuffer>> mThreads;
+		std::uint32_t mNextThreadId;
+		std::uint64_t mFrameStart;
+		std::array<float, kFrameHistory> mFrameTimes;
+		size_t mFrameCount;
+	};
+
+	// Times the enclosing scope; use PROFILE_ZONE rather than naming one.
+	class ProfileZone
+	{
+	public:
+		// name must outlive the profiler, which string literals do.
+		explicit ProfileZone(const char* name);
+		~ProfileZone();
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		const char* mName;
+		std::uint64_t mStart;
+	};
+}
+
+#define VLE_PROFILE_CONCAT_INNER(a, b) a##b
+#define VLE_PROFILE_CONCAT(a, b) VLE_PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ::vle::ProfileZone VLE_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
@@ -0,0 +1,51 @@
+#include "ThreadPool.h"
+#include "core/Profiler.h"
+
+using namespace vle;
+
+ThreadPool::ThreadPool(size_t threadCount)
+	: mStopping{ false }
+{
+	if (threadCount == 0)
+	{
+		threadCount = 1;
+	}
+	mWorkers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mCondition.notify_all();
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	Profiler::SetThreadName("Worker");
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+			if (mStopping && mTasks.empty())
+			{
+				return;
+			}
+			task = std::move(mTasks.front());
+			mTasks.pop();
+		}
+		task();
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include "core/Utils.h"
+
+namespace vle {
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		template<typename Func>
+		auto Enqueue(Func&& func) -> std::future<std::invoke_result_t<Func>>
+		{
+			using ResultType = std::invoke_result_t<Func>;
+			auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+			std::future<ResultType> result = task->get_future();
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mTasks.emplace([task]() { (*task)(); });
+			}
+			mCondition.notify_one();
+			return result;
+		}
+
+		size_t GetThreadCount() const { return mWorkers.size(); }
+
+	private:
+		void WorkerLoop();
+
+		List<std::thread> mWorkers;
+		std::queue<std::function<void()>> mTasks;
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		bool mStopping;
+	};
+}
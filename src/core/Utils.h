@@ -1,6 +1,5 @@
 #pragma once
 
-#include <stdio.h>
 #include <memory>
 #include <vector>
 #include <map>
@@ -29,5 +28,3 @@ namespace vle {
 	template<typename T>
 	using Set = std::unordered_set<T>;
 }
-//a macro
-#define LOG(M, ...) printf(M "\n", ##__VA_ARGS__)
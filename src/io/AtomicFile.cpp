@@ -0,0 +1,84 @@
+#include "AtomicFile.h"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace vle;
+
+std::string vle::TemporaryPathFor(const std::string& path)
+{
+	static const std::uint64_t process = std::random_device{}();
+	static std::atomic<std::uint64_t> counter{ 0 };
+	std::ostringstream name;
+	name << path << '.' << std::hex << process << '-' << std::hash<std::thread::id>()(std::this_thread::get_id())
+		<< '-' << counter++ << ".tmp";
+	return name.str();
+}
+
+bool vle::SyncFile(const std::string& path)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	const bool flushed = FlushFileBuffers(file) != 0;
+	CloseHandle(file);
+	return flushed;
+#else
+	const int file = ::open(path.c_str(), O_WRONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	const bool flushed = ::fsync(file) == 0;
+	::close(file);
+	return flushed;
+#endif
+}
+
+bool vle::WriteAtomically(const std::string& path, std::ios::openmode mode, const std::function<void(std::ostream&)>& write)
+{
+	namespace fs = std::filesystem;
+	const std::string temporaryPath = TemporaryPathFor(path);
+	{
+		std::ofstream fileStream(temporaryPath, mode | std::ios::trunc);
+		if (!fileStream.is_open())
+		{
+			std::cerr << "Error: output file invalid" << path << std::endl;
+			return false;
+		}
+		write(fileStream);
+		fileStream.close();
+		if (!fileStream || !SyncFile(temporaryPath))
+		{
+			std::cerr << "Error: could not write " << path << std::endl;
+			std::error_code error;
+			fs::remove(temporaryPath, error);
+			return false;
+		}
+	}
+	std::error_code error;
+	fs::rename(temporaryPath, path, error);
+	if (error)
+	{
+		std::cerr << "Error: could not replace " << path << ": " << error.message() << std::endl;
+		fs::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
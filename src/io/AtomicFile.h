@@ -0,0 +1,21 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+
+namespace vle {
+	// A temporary file name next to path, unique per process, thread and call, so writers
+	// of the same destination never share one.
+	std::string TemporaryPathFor(const std::string& path);
+
+	// Makes the OS write a file's data through to the disk rather than leave it in its cache.
+	bool SyncFile(const std::string& path);
+
+	// Writes to a temporary file in the destination directory, syncs it to disk and only
+	// then renames it over path. Path always holds either the complete old file or the
+	// complete new one, even after a crash or power loss right after the rename: without
+	// the sync the rename could reach the disk before the data, leaving an empty or
+	// partial file in place of the old one.
+	bool WriteAtomically(const std::string& path, std::ios::openmode mode, const std::function<void(std::ostream&)>& write);
+}
@@ -0,0 +1,468 @@
+#include "AutosaveLog.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "core/Profiler.h"
+#include "io/AtomicFile.h"
+#include "io/BinaryIO.h"
+#include "io/ImportExport.h"
+#include "io/ProjectSnapshot.h"
+
+using namespace vle;
+
+namespace
+{
+	const char kLogExtension[] = ".autosave";
+	const char kMagic[4] = { 'V', 'L', 'E', 'A' };
+	const uint32_t kVersion = 1;
+	// Type and payload size.
+	const size_t kRecordHeaderSize = sizeof(uint8_t) + sizeof(uint32_t);
+	const size_t kNoRecord = static_cast<size_t>(-1);
+
+	// Reads one record's payload; every Get fails once the payload runs out.
+	class RecordReader
+	{
+	public:
+		explicit RecordReader(const List<char>& payload)
+			: mPayload{ payload },
+			mOffset{ 0 },
+			mValid{ true }
+		{
+		}
+
+		template<typename T>
+		T Get()
+		{
+			T value{};
+			if (mValid && mOffset + sizeof(T) <= mPayload.size())
+			{
+				std::memcpy(&value, mPayload.data() + mOffset, sizeof(T));
+				mOffset += sizeof(T);
+			}
+			else
+			{
+				mValid = false;
+			}
+			return value;
+		}
+
+		std::string GetString()
+		{
+			const uint32_t size = Get<uint32_t>();
+			if (!mValid || mOffset + size > mPayload.size())
+			{
+				mValid = false;
+				return {};
+			}
+			std::string value(mPayload.data() + mOffset, size);
+			mOffset += size;
+			return value;
+		}
+
+		bool IsValid() const { return mValid; }
+
+	private:
+		const List<char>& mPayload;
+		size_t mOffset;
+		bool mValid;
+	};
+}
+
+AutosaveLog::AutosaveLog()
+	: mRecordStart{ 0 },
+	mLastTransformRecord{ kNoRecord },
+	mLastTransformIndex{ 0 },
+	mRecordBytes{ 0 },
+	mChangeCount{ 0 },
+	mHasSnapshot{ false },
+	mNeedsSnapshot{ false }
+{
+}
+
+std::string AutosaveLog::PathFor(const std::string& projectPath)
+{
+	return projectPath + kLogExtension;
+}
+
+bool AutosaveLog::HasRecovery(const std::string& projectPath)
+{
+	namespace fs = std::filesystem;
+	const std::string logPath = PathFor(projectPath);
+	std::error_code error;
+	if (fs::file_size(logPath, error) <= sizeof(kMagic) + sizeof(kVersion) || error)
+	{
+		return false;
+	}
+	const fs::file_time_type logTime = fs::last_write_time(logPath, error);
+	if (error)
+	{
+		return false;
+	}
+	const fs::file_time_type projectTime = fs::last_write_time(projectPath, error);
+	return error || logTime > projectTime;
+}
+
+std::optional<Project> AutosaveLog::Recover(const std::string& projectPath)
+{
+	const std::string logPath = PathFor(projectPath);
+	std::ifstream file(logPath, std::ios::binary);
+	char magic[sizeof(kMagic)];
+	uint32_t version = 0;
+	if (!file.is_open() || !file.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(magic)) != 0 ||
+		!Read(file, version) || version != kVersion)
+	{
+		std::cerr << "Error: invalid autosave log " << logPath << std::endl;
+		return std::nullopt;
+	}
+
+	std::optional<Project> project;
+	size_t replayed = 0;
+	List<char> payload;
+	while (true)
+	{
+		uint8_t type = 0;
+		uint32_t size = 0;
+		if (!Read(file, type) || !Read(file, size))
+		{
+			break;
+		}
+		payload.resize(size);
+		// A record cut short was being written when the editor stopped; everything
+		// before it is intact.
+		if (!file.read(payload.data(), size))
+		{
+			break;
+		}
+		if (type == static_cast<uint8_t>(RecordType::Snapshot))
+		{
+			project = ImportExport::loadFromString(std::string(payload.data(), payload.size()));
+			if (!project.has_value())
+			{
+				break;
+			}
+			replayed = 0;
+		}
+		else if (!project.has_value() || !ApplyRecord(static_cast<RecordType>(type), payload, project.value()))
+		{
+			std::cerr << "Warning: autosave log " << logPath << " has an invalid record, recovered up to it" << std::endl;
+			break;
+		}
+		else
+		{
+			replayed++;
+		}
+	}
+	if (!project.has_value())
+	{
+		std::cerr << "Error: autosave log " << logPath << " holds no snapshot" << std::endl;
+		return std::nullopt;
+	}
+	std::cout << "Recovered " << projectPath << " with " << replayed << " logged edit(s)" << std::endl;
+	return project;
+}
+
+void AutosaveLog::Start(const std::string& projectPath)
+{
+	Resume(projectPath);
+	mHasSnapshot = false;
+	mNeedsSnapshot = false;
+	const std::string logPath = mLogPath;
+	mWriter.Submit("Discarding autosave", logPath, [logPath]()
+		{
+			std::error_code error;
+			std::filesystem::remove(logPath, error);
+			return !error;
+		});
+}
+
+void AutosaveLog::Resume(const std::string& projectPath)
+{
+	mProjectPath = projectPath;
+	mLogPath = PathFor(projectPath);
+	mPending.clear();
+	mLastTransformRecord = kNoRecord;
+	mRecordBytes = 0;
+	mHasSnapshot = true;
+	// Replaying may have stopped at a damaged record; appending after it would be lost.
+	mNeedsSnapshot = true;
+}
+
+void AutosaveLog::Stop()
+{
+	mProjectPath.clear();
+	mLogPath.clear();
+	mPending.clear();
+	mLastTransformRecord = kNoRecord;
+}
+
+void AutosaveLog::ObjectChanged(const GameObjectStore& objects, size_t index)
+{
+	if (!IsActive())
+	{
+		return;
+	}
+	mChangeCount++;
+	if (mLastTransformRecord != kNoRecord && mLastTransformIndex == index)
+	{
+		mPending.resize(mLastTransformRecord);
+	}
+	const size_t recordStart = mPending.size();
+	BeginRecord(RecordType::Transform);
+	Put(static_cast<uint32_t>(index));
+	PutTransform(objects, index);
+	EndRecord();
+	mLastTransformRecord = recordStart;
+	mLastTransformIndex = static_cast<uint32_t>(index);
+}
+
+void AutosaveLog::ObjectAdded(const GameObjectStore& objects, size_t index)
+{
+	if (!IsActive())
+	{
+		return;
+	}
+	mChangeCount++;
+	BeginRecord(RecordType::Add);
+	Put(static_cast<uint32_t>(index));
+	PutString(objects.GetAssetID(index));
+	PutTransform(objects, index);
+	Put(objects.GetOrigins()[index].x);
+	Put(objects.GetOrigins()[index].y);
+	EndRecord();
+}
+
+void AutosaveLog::ObjectRemoved(size_t index)
+{
+	if (!IsActive())
+	{
+		return;
+	}
+	mChangeCount++;
+	BeginRecord(RecordType::Remove);
+	Put(static_cast<uint32_t>(index));
+	EndRecord();
+}
+
+void AutosaveLog::ObjectMoved(size_t from, size_t to)
+{
+	if (!IsActive())
+	{
+		return;
+	}
+	mChangeCount++;
+	BeginRecord(RecordType::Move);
+	Put(static_cast<uint32_t>(from));
+	Put(static_cast<uint32_t>(to));
+	EndRecord();
+}
+
+void AutosaveLog::AssetChanged(const std::string& name, const Asset& asset)
+{
+	if (!IsActive())
+	{
+		return;
+	}
+	mChangeCount++;
+	BeginRecord(RecordType::Asset);
+	PutString(name);
+	Put(asset.defaultScale.x);
+	Put(asset.defaultScale.y);
+	Put(asset.defaultRotation.asDegrees());
+	EndRecord();
+}
+
+void AutosaveLog::SnapshotNeeded()
+{
+	mChangeCount++;
+	mNeedsSnapshot = true;
+}
+
+void AutosaveLog::Flush(const Project& project, const shared<const List<sf::VertexArray>>& hitboxMap)
+{
+	PROFILE_FUNCTION();
+	for (const WriteResult& result : mWriter.TakeResults())
+	{
+		// A lost append leaves a gap the records after it cannot be replayed across.
+		if (!result.ok && result.path == mLogPath)
+		{
+			mNeedsSnapshot = true;
+		}
+	}
+	if (!IsActive() || (mPending.empty() && !mNeedsSnapshot))
+	{
+		return;
+	}
+
+	const std::string logPath = mLogPath;
+	if (!mHasSnapshot || mNeedsSnapshot || mRecordBytes + mPending.size() > kCompactThreshold)
+	{
+		// Replaces the whole log, so appends still queued for it are dropped with it.
+		auto snapshot = std::make_shared<const ProjectSnapshot>(snapshotProject(project, hitboxMap));
+		mWriter.Submit("Compacting autosave", logPath, [snapshot, logPath]()
+			{
+				return WriteSnapshot(logPath, ImportExport::saveToString(*snapshot));
+			});
+		mRecordBytes = 0;
+		mHasSnapshot = true;
+		mNeedsSnapshot = false;
+	}
+	else
+	{
+		auto records = std::make_shared<const List<char>>(std::move(mPending));
+		mRecordBytes += records->size();
+		mWriter.Submit("Autosave", logPath, [records, logPath]()
+			{
+				return AppendRecords(logPath, *records);
+			}, false);
+	}
+	mPending.clear();
+	mLastTransformRecord = kNoRecord;
+}
+
+bool AutosaveLog::ApplyRecord(RecordType type, const List<char>& payload, Project& project)
+{
+	GameObjectStore& objects = project.level.gameObjects;
+	RecordReader reader(payload);
+	switch (type)
+	{
+	case RecordType::Transform:
+	{
+		const uint32_t index = reader.Get<uint32_t>();
+		const sf::Vector2f position{ reader.Get<float>(), reader.Get<float>() };
+		const sf::Vector2f scale{ reader.Get<float>(), reader.Get<float>() };
+		const sf::Angle rotation = sf::degrees(reader.Get<float>());
+		if (!reader.IsValid() || index >= objects.GetCount())
+		{
+			return false;
+		}
+		objects.SetPosition(index, position);
+		objects.SetScale(index, scale);
+		objects.SetRotation(index, rotation);
+		return true;
+	}
+	case RecordType::Add:
+	{
+		const uint32_t index = reader.Get<uint32_t>();
+		GameObject object;
+		object.assetID = reader.GetString();
+		object.position = { reader.Get<float>(), reader.Get<float>() };
+		object.scale = { reader.Get<float>(), reader.Get<float>() };
+		object.rotation = sf::degrees(reader.Get<float>());
+		object.origin = { reader.Get<float>(), reader.Get<float>() };
+		if (!reader.IsValid() || index > objects.GetCount())
+		{
+			return false;
+		}
+		objects.Add(object);
+		objects.Move(objects.GetCount() - 1, index);
+		return true;
+	}
+	case RecordType::Remove:
+	{
+		const uint32_t index = reader.Get<uint32_t>();
+		if (!reader.IsValid() || index >= objects.GetCount())
+		{
+			return false;
+		}
+		objects.Remove(objects.HandleAt(index));
+		return true;
+	}
+	case RecordType::Move:
+	{
+		const uint32_t from = reader.Get<uint32_t>();
+		const uint32_t to = reader.Get<uint32_t>();
+		if (!reader.IsValid() || from >= objects.GetCount() || to >= objects.GetCount())
+		{
+			return false;
+		}
+		objects.Move(from, to);
+		return true;
+	}
+	case RecordType::Asset:
+	{
+		const std::string name = reader.GetString();
+		const sf::Vector2f scale{ reader.Get<float>(), reader.Get<float>() };
+		const sf::Angle rotation = sf::degrees(reader.Get<float>());
+		auto found = project.assets.find(name);
+		if (!reader.IsValid() || found == project.assets.end() || !found->second)
+		{
+			return false;
+		}
+		found->second->defaultScale = scale;
+		found->second->defaultRotation = rotation;
+		return true;
+	}
+	case RecordType::Snapshot:
+		break;
+	}
+	return false;
+}
+
+void AutosaveLog::BeginRecord(RecordType type)
+{
+	mLastTransformRecord = kNoRecord;
+	mRecordStart = mPending.size();
+	Put(static_cast<uint8_t>(type));
+	Put(static_cast<uint32_t>(0));
+}
+
+void AutosaveLog::EndRecord()
+{
+	const uint32_t size = static_cast<uint32_t>(mPending.size() - mRecordStart - kRecordHeaderSize);
+	std::memcpy(mPending.data() + mRecordStart + sizeof(uint8_t), &size, sizeof(size));
+}
+
+void AutosaveLog::PutTransform(const GameObjectStore& objects, size_t index)
+{
+	Put(objects.GetPositions()[index].x);
+	Put(objects.GetPositions()[index].y);
+	Put(objects.GetScales()[index].x);
+	Put(objects.GetScales()[index].y);
+	Put(objects.GetRotations()[index].asDegrees());
+}
+
+template<typename T>
+void AutosaveLog::Put(const T& value)
+{
+	const char* bytes = reinterpret_cast<const char*>(&value);
+	mPending.insert(mPending.end(), bytes, bytes + sizeof(T));
+}
+
+void AutosaveLog::PutString(const std::string& value)
+{
+	Put(static_cast<uint32_t>(value.size()));
+	mPending.insert(mPending.end(), value.begin(), value.end());
+}
+
+bool AutosaveLog::WriteSnapshot(const std::string& path, const std::string& document)
+{
+	// Replaces the log atomically and durably, so a crash or power loss mid-write leaves the
+	// previous log intact.
+	return WriteAtomically(path, std::ios::binary, [&document](std::ostream& file)
+		{
+			file.write(kMagic, sizeof(kMagic));
+			Write(file, kVersion);
+			Write(file, static_cast<uint8_t>(RecordType::Snapshot));
+			Write(file, static_cast<uint32_t>(document.size()));
+			file.write(document.data(), static_cast<std::streamsize>(document.size()));
+		});
+}
+
+bool AutosaveLog::AppendRecords(const std::string& path, const List<char>& records)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::app);
+	if (!file.is_open())
+	{
+		std::cerr << "Error: cannot append to autosave log " << path << std::endl;
+		return false;
+	}
+	file.write(records.data(), static_cast<std::streamsize>(records.size()));
+	file.flush();
+	if (!file)
+	{
+		std::cerr << "Error: cannot append to autosave log " << path << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <SFML/Graphics.hpp>
+#include "core/Utils.h"
+#include "io/BackgroundWriter.h"
+#include "level/GameObjectStore.h"
+#include "project/Project.h"
+
+namespace vle {
+	// Crash recovery for a project that has a file. Edits are appended to a log next to
+	// the project as small binary records, so keeping the log current costs as much as
+	// the edits did, not as much as the project. The log starts with a full snapshot of
+	// the project and is rewritten as a fresh snapshot once the records outgrow
+	// kCompactThreshold. Records refer to objects by draw index, which replaying them
+	// in order reproduces.
+	class AutosaveLog
+	{
+	public:
+		static constexpr std::uint64_t kCompactThreshold = 4 * 1024 * 1024;
+
+		AutosaveLog();
+
+		static std::string PathFor(const std::string& projectPath);
+		// A log newer than the project file holds edits the file does not.
+		static bool HasRecovery(const std::string& projectPath);
+		// The log's snapshot with every complete record after it replayed.
+		static std::optional<Project> Recover(const std::string& projectPath);
+
+		// Logs edits to a project the file at projectPath holds as it is, so the
+		// project's old log is discarded. The snapshot is written with the first edit.
+		void Start(const std::string& projectPath);
+		// Logs edits to a project recovered from its log, which is kept until the next
+		// Flush replaces it with a snapshot.
+		void Resume(const std::string& projectPath);
+		// Stops logging; whatever was flushed stays for the next time the project is opened.
+		void Stop();
+		bool IsActive() const { return !mProjectPath.empty(); }
+
+		void ObjectChanged(const GameObjectStore& objects, size_t index);
+		// Call after the object was added.
+		void ObjectAdded(const GameObjectStore& objects, size_t index);
+		// index is where the object was before it was removed.
+		void ObjectRemoved(size_t index);
+		void ObjectMoved(size_t from, size_t to);
+		void AssetChanged(const std::string& name, const Asset& asset);
+		// For changes no record describes, such as the hitbox map: the next Flush writes a snapshot.
+		void SnapshotNeeded();
+		// Grows with every change reported, so callers can tell whether anything changed since.
+		std::uint64_t GetChangeCount() const { return mChangeCount; }
+
+		// Hands what changed since the last call to the I/O thread.
+		void Flush(const Project& project, const shared<const List<sf::VertexArray>>& hitboxMap);
+
+	private:
+		enum class RecordType : std::uint8_t
+		{
+			Snapshot,
+			Transform,
+			Add,
+			Remove,
+			Move,
+			Asset
+		};
+
+		void BeginRecord(RecordType type);
+		void EndRecord();
+		void PutTransform(const GameObjectStore& objects, size_t index);
+		template<typename T>
+		void Put(const T& value);
+		void PutString(const std::string& value);
+
+		static bool ApplyRecord(RecordType type, const List<char>& payload, Project& project);
+		static bool WriteSnapshot(const std::string& path, const std::string& document);
+		static bool AppendRecords(const std::string& path, const List<char>& records);
+
+		std::string mProjectPath;
+		std::string mLogPath;
+		// Records not handed to the I/O thread yet.
+		List<char> mPending;
+		size_t mRecordStart;
+		// The last pending record when it is a transform, which the next transform of the
+		// same object overwrites so a drag costs one record per flush.
+		size_t mLastTransformRecord;
+		std::uint32_t mLastTransformIndex;
+		// Bytes of records written after the log's snapshot.
+		std::uint64_t mRecordBytes;
+		std::uint64_t mChangeCount;
+		bool mHasSnapshot;
+		bool mNeedsSnapshot;
+		BackgroundWriter mWriter;
+	};
+}
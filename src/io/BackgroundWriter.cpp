@@ -0,0 +1,95 @@
+#include "BackgroundWriter.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include "core/Profiler.h"
+
+using namespace vle;
+
+BackgroundWriter::BackgroundWriter()
+	: mStopping{ false }
+{
+	mThread = std::thread(&BackgroundWriter::Run, this);
+}
+
+BackgroundWriter::~BackgroundWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mWakeUp.notify_one();
+	mThread.join();
+}
+
+void BackgroundWriter::Submit(const std::string& description, const std::string& path, std::function<bool()> write, bool replacePending)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (replacePending)
+		{
+			mJobs.erase(std::remove_if(mJobs.begin(), mJobs.end(), [&path](const Job& job) { return job.path == path; }), mJobs.end());
+		}
+		mJobs.push_back(Job{ description, path, std::move(write) });
+	}
+	mWakeUp.notify_one();
+}
+
+bool BackgroundWriter::IsBusy() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return !mJobs.empty() || !mCurrentDescription.empty();
+}
+
+std::string BackgroundWriter::GetCurrentDescription() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mCurrentDescription.empty())
+	{
+		return mCurrentDescription;
+	}
+	return mJobs.empty() ? std::string() : mJobs.front().description;
+}
+
+List<WriteResult> BackgroundWriter::TakeResults()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	List<WriteResult> results;
+	results.swap(mResults);
+	return results;
+}
+
+void BackgroundWriter::Run()
+{
+	Profiler::SetThreadName("Writer");
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWakeUp.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+			if (mJobs.empty())
+			{
+				return;
+			}
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+			mCurrentDescription = job.description;
+		}
+
+		bool ok = false;
+		try
+		{
+			PROFILE_ZONE("BackgroundWriter job");
+			ok = job.write();
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Error: " << job.description << " failed: " << e.what() << std::endl;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mCurrentDescription.clear();
+		mResults.push_back(WriteResult{ job.description, job.path, ok });
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "core/Utils.h"
+
+namespace vle {
+	struct WriteResult
+	{
+		std::string description;
+		std::string path;
+		bool ok;
+	};
+
+	// Runs file writes one at a time, in submission order, on a dedicated I/O thread so
+	// serializing and writing never stall the UI. Writes should work on snapshots,
+	// not on state the editor keeps changing.
+	class BackgroundWriter
+	{
+	public:
+		BackgroundWriter();
+		// Finishes every queued write before returning, so nothing is lost on exit.
+		~BackgroundWriter();
+
+		BackgroundWriter(const BackgroundWriter&) = delete;
+		BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+
+		// Unless replacePending is false, a write to the same path that has not started
+		// yet is dropped in favour of this one.
+		void Submit(const std::string& description, const std::string& path, std::function<bool()> write, bool replacePending = true);
+		bool IsBusy() const;
+		// Description of the write in progress or next in line, empty when idle.
+		std::string GetCurrentDescription() const;
+		// Writes finished since the last call, oldest first.
+		List<WriteResult> TakeResults();
+
+	private:
+		struct Job
+		{
+			std::string description;
+			std::string path;
+			std::function<bool()> write;
+		};
+
+		void Run();
+
+		mutable std::mutex mMutex;
+		std::condition_variable mWakeUp;
+		std::deque<Job> mJobs;
+		std::string mCurrentDescription;
+		List<WriteResult> mResults;
+		bool mStopping;
+		std::thread mThread;
+	};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+
+namespace vle {
+	// Raw native-endian values, for the editor's own cache and log files that never leave
+	// the machine that wrote them.
+	template<typename T>
+	void Write(std::ostream& stream, const T& value)
+	{
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	bool Read(std::istream& stream, T& value)
+	{
+		return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+}
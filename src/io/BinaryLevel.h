@@ -0,0 +1,255 @@
+#pragma once
+
+// Binary level format written by ImportExport::exportLevelBinary.
+// This header has no dependency on SFML or the editor, so a game can copy it,
+// map an exported file into memory and read it in place without parsing.
+//
+// Layout (little-endian, every section starts on a 16 byte boundary):
+//   FileHeader
+//   SectionEntry[header.sectionCount]
+//   section payloads
+//
+// Sections:
+//   Strings      null-terminated UTF-8 strings, referenced by byte offset
+//   LevelInfo    one LevelInfo record
+//   Chains       ChainRecord[count], one per hitbox chain
+//   ChainPoints  Point[count], the vertices of all chains back to back
+//   GameObjects  GameObjectRecord[count], in draw order
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace vle {
+	namespace binary
+	{
+		constexpr char kMagic[4] = { 'V', 'L', 'E', 'B' };
+		constexpr uint16_t kVersionMajor = 1;
+		constexpr uint16_t kVersionMinor = 0;
+		constexpr uint32_t kSectionAlignment = 16;
+
+		enum class SectionType : uint32_t
+		{
+			Strings = 1,
+			LevelInfo = 2,
+			Chains = 3,
+			ChainPoints = 4,
+			GameObjects = 5
+		};
+
+		// Same order as sf::PrimitiveType.
+		enum class PrimitiveType : uint32_t
+		{
+			Points = 0,
+			Lines,
+			LineStrip,
+			Triangles,
+			TriangleStrip,
+			TriangleFan
+		};
+
+		struct FileHeader
+		{
+			char magic[4];
+			uint16_t versionMajor;
+			uint16_t versionMinor;
+			uint32_t sectionCount;
+			uint32_t flags;
+			uint64_t fileSize;
+		};
+
+		struct SectionEntry
+		{
+			SectionType type;
+			uint32_t count;
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		struct LevelInfo
+		{
+			uint32_t levelNameOffset;
+			uint32_t chainCount;
+			uint32_t pointCount;
+			uint32_t gameObjectCount;
+		};
+
+		struct Point
+		{
+			float x;
+			float y;
+		};
+
+		// color is packed as 0xRRGGBBAA, the color of the first vertex of the chain.
+		struct ChainRecord
+		{
+			uint32_t firstPoint;
+			uint32_t pointCount;
+			PrimitiveType primitiveType;
+			uint32_t color;
+		};
+
+		struct GameObjectRecord
+		{
+			Point position;
+			Point scale;
+			Point origin;
+			float rotationDegrees;
+			uint32_t assetIdOffset;
+		};
+
+		static_assert(sizeof(FileHeader) == 24, "FileHeader layout changed");
+		static_assert(alignof(FileHeader) == alignof(uint64_t) && alignof(SectionEntry) <= alignof(FileHeader), "LevelReader checks the wrong alignment");
+		static_assert(sizeof(SectionEntry) == 24, "SectionEntry layout changed");
+		static_assert(sizeof(LevelInfo) == 16, "LevelInfo layout changed");
+		static_assert(sizeof(Point) == 8, "Point layout changed");
+		static_assert(sizeof(ChainRecord) == 16, "ChainRecord layout changed");
+		static_assert(sizeof(GameObjectRecord) == 32, "GameObjectRecord layout changed");
+
+		// Read-only view over a binary level that lives in memory (a mapped file or a buffer).
+		// The view never copies: every accessor points into the original data, which must
+		// outlive the reader and be aligned to at least 8 bytes, since header and section
+		// fields are 64 bit. Mapped files and allocations from new or malloc always are.
+		class LevelReader
+		{
+		public:
+			bool Open(const void* data, size_t size)
+			{
+				*this = LevelReader{};
+				mData = static_cast<const uint8_t*>(data);
+				mSize = size;
+				if (!mData || mSize < sizeof(FileHeader))
+				{
+					return Fail("file too small");
+				}
+				if (reinterpret_cast<uintptr_t>(mData) % alignof(FileHeader) != 0)
+				{
+					return Fail("data is not aligned");
+				}
+				const FileHeader* header = reinterpret_cast<const FileHeader*>(mData);
+				if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0)
+				{
+					return Fail("not a binary level file");
+				}
+				if (header->versionMajor != kVersionMajor)
+				{
+					return Fail("unsupported version");
+				}
+				if (header->fileSize != mSize)
+				{
+					return Fail("file size mismatch");
+				}
+				const uint64_t tableEnd = sizeof(FileHeader) + uint64_t(header->sectionCount) * sizeof(SectionEntry);
+				if (tableEnd > mSize)
+				{
+					return Fail("section table out of bounds");
+				}
+				const SectionEntry* sections = reinterpret_cast<const SectionEntry*>(mData + sizeof(FileHeader));
+				for (uint32_t i = 0; i < header->sectionCount; i++)
+				{
+					const SectionEntry& section = sections[i];
+					if (section.offset % kSectionAlignment != 0 || section.offset < tableEnd ||
+						section.offset > mSize || section.size > mSize - section.offset)
+					{
+						return Fail("section out of bounds");
+					}
+					switch (section.type)
+					{
+					case SectionType::Strings:		mStrings = &section;		break;
+					case SectionType::LevelInfo:	mLevelInfo = &section;		break;
+					case SectionType::Chains:		mChains = &section;			break;
+					case SectionType::ChainPoints:	mChainPoints = &section;	break;
+					case SectionType::GameObjects:	mGameObjects = &section;	break;
+					default: break; // unknown sections from newer minor versions are skipped
+					}
+				}
+				if (!mStrings || !mLevelInfo || !mChains || !mChainPoints || !mGameObjects)
+				{
+					return Fail("missing section");
+				}
+				if (mLevelInfo->size < sizeof(LevelInfo) ||
+					mChains->size < uint64_t(mChains->count) * sizeof(ChainRecord) ||
+					mChainPoints->size < uint64_t(mChainPoints->count) * sizeof(Point) ||
+					mGameObjects->size < uint64_t(mGameObjects->count) * sizeof(GameObjectRecord))
+				{
+					return Fail("section too small");
+				}
+				if (mStrings->size == 0 || mData[mStrings->offset + mStrings->size - 1] != '\0')
+				{
+					return Fail("string table not terminated");
+				}
+				if (!ValidString(GetInfo().levelNameOffset))
+				{
+					return Fail("invalid level name");
+				}
+				const ChainRecord* chains = GetChains();
+				for (uint32_t i = 0; i < GetChainCount(); i++)
+				{
+					if (chains[i].firstPoint > mChainPoints->count || chains[i].pointCount > mChainPoints->count - chains[i].firstPoint)
+					{
+						return Fail("chain points out of bounds");
+					}
+				}
+				const GameObjectRecord* objects = GetGameObjects();
+				for (uint32_t i = 0; i < GetGameObjectCount(); i++)
+				{
+					if (!ValidString(objects[i].assetIdOffset))
+					{
+						return Fail("invalid asset ID");
+					}
+				}
+				mValid = true;
+				return true;
+			}
+
+			bool IsValid() const { return mValid; }
+			const char* GetError() const { return mError; }
+
+			const LevelInfo& GetInfo() const { return *Section<LevelInfo>(mLevelInfo); }
+			std::string_view GetLevelName() const { return GetString(GetInfo().levelNameOffset); }
+
+			uint32_t GetChainCount() const { return mChains->count; }
+			const ChainRecord* GetChains() const { return Section<ChainRecord>(mChains); }
+			const Point* GetChainPoints(const ChainRecord& chain) const { return Section<Point>(mChainPoints) + chain.firstPoint; }
+
+			uint32_t GetGameObjectCount() const { return mGameObjects->count; }
+			const GameObjectRecord* GetGameObjects() const { return Section<GameObjectRecord>(mGameObjects); }
+			std::string_view GetAssetID(const GameObjectRecord& object) const { return GetString(object.assetIdOffset); }
+
+			std::string_view GetString(uint32_t offset) const
+			{
+				return std::string_view(reinterpret_cast<const char*>(mData + mStrings->offset + offset));
+			}
+
+		private:
+			template<typename T>
+			const T* Section(const SectionEntry* section) const
+			{
+				return reinterpret_cast<const T*>(mData + section->offset);
+			}
+
+			bool ValidString(uint32_t offset) const
+			{
+				return offset < mStrings->size;
+			}
+
+			bool Fail(const char* error)
+			{
+				mError = error;
+				mValid = false;
+				return false;
+			}
+
+			const uint8_t* mData = nullptr;
+			size_t mSize = 0;
+			const SectionEntry* mStrings = nullptr;
+			const SectionEntry* mLevelInfo = nullptr;
+			const SectionEntry* mChains = nullptr;
+			const SectionEntry* mChainPoints = nullptr;
+			const SectionEntry* mGameObjects = nullptr;
+			const char* mError = "";
+			bool mValid = false;
+		};
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+namespace vle {
+	enum class HitboxLayout
+	{
+		Verbose,	// one {"color", "position"} object per vertex, the layout VoidLevelLoader reads
+		Compact		// flat [x0, y0, x1, y1, ...] coordinate arrays, color written once when uniform
+	};
+
+	struct HitboxEncodingOptions
+	{
+		HitboxLayout layout = HitboxLayout::Verbose;
+		// Compact layout only: snap coordinates to multiples of this step and write them as
+		// integers. 0 keeps full floats.
+		float quantizationStep = 0.f;
+		// Compact layout with quantization only: write each point as the offset from the previous one.
+		bool deltaEncode = false;
+	};
+}
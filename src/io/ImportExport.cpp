@@ -1,65 +1,306 @@
 #include "ImportExport.h"
+#include "core/Profiler.h"
+#include "io/AtomicFile.h"
 #include "io/Serialization.h"
+#include "io/BinaryLevel.h"
+#include "io/ProjectSaxHandler.h"
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <cstring>
 
 using namespace vle;
 
 using json = nlohmann::json;
 
-bool ImportExport::save(const Project& project, const std::string& path)
+namespace
 {
-	std::ofstream fileStream(path);
-    if (!fileStream.is_open())
+    // Pretty printing puts every compact coordinate on its own indented line, which would
+    // undo most of the size saving, so compact files are written on a single line.
+    int IndentFor(const HitboxEncodingOptions& options)
     {
-        std::cerr << "Error: output file invalid" << path << std::endl;
-        return false;
+        return options.layout == HitboxLayout::Compact ? -1 : 4;
     }
-    json projectJson = project;
-    fileStream << projectJson.dump(4);
-    fileStream.close();
-    return true;
-}
 
-std::optional<Project> ImportExport::load(const std::string& path)
-{
-    std::ifstream fileStream(path);
-    if (!fileStream.is_open())
+    // Feeds the parser from the file in large chunks and reports how much has been read.
+    class ProgressStreamBuffer : public std::streambuf
     {
-        std::cerr << "Error: input file invalid:" << path << std::endl;
-        return std::nullopt;
-    }
-    json projectJson;
-    try
+    public:
+        ProgressStreamBuffer(std::istream& source, std::uintmax_t totalSize, const ImportExport::ProgressCallback& onProgress)
+            : mSource{ source },
+            mBuffer(1 << 16),
+            mTotalSize{ totalSize },
+            mBytesRead{ 0 },
+            mOnProgress{ onProgress }
+        {
+        }
+
+    protected:
+        int_type underflow() override
+        {
+            if (gptr() < egptr())
+            {
+                return traits_type::to_int_type(*gptr());
+            }
+            mSource.read(mBuffer.data(), static_cast<std::streamsize>(mBuffer.size()));
+            std::streamsize count = mSource.gcount();
+            if (count <= 0)
+            {
+                return traits_type::eof();
+            }
+            mBytesRead += static_cast<std::uintmax_t>(count);
+            if (mOnProgress && mTotalSize > 0)
+            {
+                mOnProgress(std::min(1.f, static_cast<float>(mBytesRead) / static_cast<float>(mTotalSize)));
+            }
+            setg(mBuffer.data(), mBuffer.data(), mBuffer.data() + count);
+            return traits_type::to_int_type(*gptr());
+        }
+
+    private:
+        std::istream& mSource;
+        List<char> mBuffer;
+        std::uintmax_t mTotalSize;
+        std::uintmax_t mBytesRead;
+        const ImportExport::ProgressCallback& mOnProgress;
+    };
+
+    json snapshotToJson(const ProjectSnapshot& snapshot, const HitboxEncodingOptions& options)
     {
-        fileStream >> projectJson;
+        const LevelSnapshot& level = snapshot.level;
+        json levelJson = levelToJson(level.levelNameId, *level.hitboxMap, *level.gameObjects, options);
+        return projectToJson(snapshot.settings, std::move(levelJson));
     }
-    catch (json::parse_error& e)
+
+    std::optional<Project> parseProject(std::istream& input)
     {
-        std::cerr << "JSON Parsing Error:" << e.what() << std::endl;
-        return std::nullopt;
+        Project project;
+        ProjectSaxHandler handler(project);
+        try
+        {
+            if (!json::sax_parse(input, &handler) || !handler.IsComplete())
+            {
+                std::cerr << "JSON Parsing Error:" << handler.GetError() << std::endl;
+                return std::nullopt;
+            }
+        }
+        catch (json::exception& e)
+        {
+            std::cerr << "JSON Parsing Error:" << e.what() << std::endl;
+            return std::nullopt;
+        }
+        return project;
     }
-    try
+
+    bool writeJson(const std::string& path, const json& document, int indent)
     {
-        return projectJson.get<Project>();
+        return WriteAtomically(path, std::ios::out, [&document, indent](std::ostream& stream)
+            {
+                stream << document.dump(indent);
+            });
     }
-    catch (json::exception& e)
+}
+
+bool ImportExport::save(const Project& project, const std::string& path, const HitboxEncodingOptions& options)
+{
+    PROFILE_ZONE("Save project");
+    return writeJson(path, projectToJson(project, options), IndentFor(options));
+}
+
+bool ImportExport::save(const ProjectSnapshot& snapshot, const std::string& path, const HitboxEncodingOptions& options)
+{
+    PROFILE_ZONE("Save project");
+    return writeJson(path, snapshotToJson(snapshot, options), IndentFor(options));
+}
+
+std::optional<Project> ImportExport::load(const std::string& path, const ProgressCallback& onProgress)
+{
+    PROFILE_ZONE("Load project");
+    std::ifstream fileStream(path, std::ios::binary);
+    if (!fileStream.is_open())
     {
-        std::cerr << "JSON Conversion Error:" << e.what() << std::endl;
+        std::cerr << "Error: input file invalid:" << path << std::endl;
         return std::nullopt;
     }
+    std::error_code sizeError;
+    std::uintmax_t fileSize = std::filesystem::file_size(path, sizeError);
+    ProgressStreamBuffer streamBuffer(fileStream, sizeError ? 0 : fileSize, onProgress);
+    std::istream input(&streamBuffer);
+    return parseProject(input);
 }
 
-bool ImportExport::exportLevel(const Level& level, const std::string& path)
+std::string ImportExport::saveToString(const ProjectSnapshot& snapshot, const HitboxEncodingOptions& options)
 {
-    std::ofstream fileStream(path);
-    if (!fileStream.is_open())
+    return snapshotToJson(snapshot, options).dump(IndentFor(options));
+}
+
+std::optional<Project> ImportExport::loadFromString(const std::string& document)
+{
+    std::istringstream input(document);
+    return parseProject(input);
+}
+
+bool ImportExport::exportLevel(const Level& level, const std::string& path, const HitboxEncodingOptions& options)
+{
+    PROFILE_ZONE("Export level");
+    return writeJson(path, levelToJson(level, options), IndentFor(options));
+}
+
+bool ImportExport::exportLevel(const LevelSnapshot& snapshot, const std::string& path, const HitboxEncodingOptions& options)
+{
+    PROFILE_ZONE("Export level");
+    return writeJson(path, levelToJson(snapshot.levelNameId, *snapshot.hitboxMap, *snapshot.gameObjects, options), IndentFor(options));
+}
+
+namespace
+{
+    bool writeLevelBinary(const std::string& levelNameId, const List<sf::VertexArray>& hitboxMap,
+        const GameObjectStore& store, const std::string& path)
     {
-        std::cerr << "Error: output file invalid" << path << std::endl;
-        return false;
+        List<char> strings;
+        Dictionary<std::string, uint32_t> stringOffsets;
+        auto addString = [&strings, &stringOffsets](const std::string& value) -> uint32_t
+        {
+            auto found = stringOffsets.find(value);
+            if (found != stringOffsets.end())
+            {
+                return found->second;
+            }
+            uint32_t offset = static_cast<uint32_t>(strings.size());
+            strings.insert(strings.end(), value.begin(), value.end());
+            strings.push_back('\0');
+            stringOffsets.emplace(value, offset);
+            return offset;
+        };
+
+        binary::LevelInfo info{};
+        info.levelNameOffset = addString(levelNameId);
+
+        List<binary::ChainRecord> chains;
+        List<binary::Point> points;
+        chains.reserve(hitboxMap.size());
+        for (const sf::VertexArray& chain : hitboxMap)
+        {
+            binary::ChainRecord record{};
+            record.firstPoint = static_cast<uint32_t>(points.size());
+            record.pointCount = static_cast<uint32_t>(chain.getVertexCount());
+            record.primitiveType = static_cast<binary::PrimitiveType>(chain.getPrimitiveType());
+            record.color = chain.getVertexCount() > 0 ? chain[0].color.toInteger() : sf::Color::White.toInteger();
+            for (size_t i = 0; i < chain.getVertexCount(); i++)
+            {
+                points.push_back({ chain[i].position.x, chain[i].position.y });
+            }
+            chains.push_back(record);
+        }
+
+        List<binary::GameObjectRecord> objects;
+        objects.reserve(store.GetCount());
+        // Each asset name is added once, by interned index, rather than hashed per object.
+        List<uint32_t> assetOffsets;
+        const uint32_t kNoOffset = static_cast<uint32_t>(-1);
+        for (size_t i = 0; i < store.GetCount(); i++)
+        {
+            binary::GameObjectRecord record{};
+            record.position = { store.GetPositions()[i].x, store.GetPositions()[i].y };
+            record.scale = { store.GetScales()[i].x, store.GetScales()[i].y };
+            record.origin = { store.GetOrigins()[i].x, store.GetOrigins()[i].y };
+            record.rotationDegrees = store.GetRotations()[i].asDegrees();
+            const AssetIndex asset = store.GetAssets()[i];
+            if (asset >= assetOffsets.size())
+            {
+                assetOffsets.resize(asset + 1, kNoOffset);
+            }
+            if (assetOffsets[asset] == kNoOffset)
+            {
+                assetOffsets[asset] = addString(store.GetAssetID(i));
+            }
+            record.assetIdOffset = assetOffsets[asset];
+            objects.push_back(record);
+        }
+
+        info.chainCount = static_cast<uint32_t>(chains.size());
+        info.pointCount = static_cast<uint32_t>(points.size());
+        info.gameObjectCount = static_cast<uint32_t>(objects.size());
+
+        struct SectionData
+        {
+            binary::SectionType type;
+            uint32_t count;
+            const void* data;
+            uint64_t size;
+        };
+        const SectionData sectionData[] = {
+            { binary::SectionType::Strings, static_cast<uint32_t>(stringOffsets.size()), strings.data(), strings.size() },
+            { binary::SectionType::LevelInfo, 1, &info, sizeof(info) },
+            { binary::SectionType::Chains, info.chainCount, chains.data(), chains.size() * sizeof(binary::ChainRecord) },
+            { binary::SectionType::ChainPoints, info.pointCount, points.data(), points.size() * sizeof(binary::Point) },
+            { binary::SectionType::GameObjects, info.gameObjectCount, objects.data(), objects.size() * sizeof(binary::GameObjectRecord) }
+        };
+        constexpr uint32_t sectionCount = sizeof(sectionData) / sizeof(sectionData[0]);
+
+        auto align = [](uint64_t offset) { return (offset + binary::kSectionAlignment - 1) / binary::kSectionAlignment * binary::kSectionAlignment; };
+        List<binary::SectionEntry> sections;
+        uint64_t offset = align(sizeof(binary::FileHeader) + sectionCount * sizeof(binary::SectionEntry));
+        for (const SectionData& data : sectionData)
+        {
+            sections.push_back({ data.type, data.count, offset, data.size });
+            offset = align(offset + data.size);
+        }
+
+        binary::FileHeader header{};
+        std::memcpy(header.magic, binary::kMagic, sizeof(header.magic));
+        header.versionMajor = binary::kVersionMajor;
+        header.versionMinor = binary::kVersionMinor;
+        header.sectionCount = sectionCount;
+        header.fileSize = offset;
+
+        List<char> buffer(static_cast<size_t>(header.fileSize), '\0');
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        std::memcpy(buffer.data() + sizeof(header), sections.data(), sections.size() * sizeof(binary::SectionEntry));
+        for (uint32_t i = 0; i < sectionCount; i++)
+        {
+            if (sectionData[i].size > 0)
+            {
+                std::memcpy(buffer.data() + sections[i].offset, sectionData[i].data, static_cast<size_t>(sectionData[i].size));
+            }
+        }
+
+        return WriteAtomically(path, std::ios::binary, [&buffer](std::ostream& stream)
+            {
+                stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            });
+    }
+}
+
+bool ImportExport::exportLevelBinary(const Level& level, const std::string& path)
+{
+    PROFILE_ZONE("Export binary level");
+    return writeLevelBinary(level.levelNameId, level.hitboxMap, level.gameObjects, path);
+}
+
+bool ImportExport::exportLevelBinary(const LevelSnapshot& snapshot, const std::string& path)
+{
+    PROFILE_ZONE("Export binary level");
+    return writeLevelBinary(snapshot.levelNameId, *snapshot.hitboxMap, *snapshot.gameObjects, path);
+}
+
+bool ImportExport::exportAtlas(const TextureAtlas& atlas, const Map<std::string, std::string>& regionNames, const std::string& path)
+{
+    namespace fs = std::filesystem;
+    fs::path layoutPath(path);
+    List<std::string> pageImages;
+    for (size_t i = 0; i < atlas.GetPageCount(); i++)
+    {
+        std::string imageName = layoutPath.stem().string() + "_" + std::to_string(i) + ".png";
+        if (!atlas.GetPage(i).copyToImage().saveToFile(layoutPath.parent_path() / imageName))
+        {
+            std::cerr << "Error: could not write atlas page " << imageName << std::endl;
+            return false;
+        }
+        pageImages.push_back(imageName);
     }
-    json levelJson = level;
-    fileStream << levelJson.dump(4);
-    fileStream.close();
-    return true;
+
+    return writeJson(path, atlasToJson(atlas, regionNames, pageImages), 4);
 }
@@ -1,15 +1,36 @@
 #pragma once
 
+#include <functional>
 #include <iostream>
 #include <optional>
+#include "io/HitboxEncoding.h"
+#include "io/ProjectSnapshot.h"
 #include "level/Level.h"
 #include "project/Project.h"
+#include "project/TextureAtlas.h"
 
 namespace vle {
     namespace ImportExport
     {
-        bool save(const Project& project, const std::string& path);
-        std::optional<Project> load(const std::string& path);
-        bool exportLevel(const Level& level, const std::string& path);
+        // Receives the fraction of the file consumed so far, from 0 to 1.
+        using ProgressCallback = std::function<void(float progress)>;
+
+        // Every writer goes through a temporary file next to path that is renamed over it
+        // once complete, so a failed or interrupted write leaves the previous file intact.
+
+        // Project files are editor-only, so they default to the compact hitbox layout.
+        bool save(const Project& project, const std::string& path, const HitboxEncodingOptions& options = { HitboxLayout::Compact });
+        bool save(const ProjectSnapshot& snapshot, const std::string& path, const HitboxEncodingOptions& options = { HitboxLayout::Compact });
+        std::optional<Project> load(const std::string& path, const ProgressCallback& onProgress = {});
+        // The same project document, kept in memory instead of a file.
+        std::string saveToString(const ProjectSnapshot& snapshot, const HitboxEncodingOptions& options = { HitboxLayout::Compact });
+        std::optional<Project> loadFromString(const std::string& document);
+        bool exportLevel(const Level& level, const std::string& path, const HitboxEncodingOptions& options = {});
+        bool exportLevel(const LevelSnapshot& snapshot, const std::string& path, const HitboxEncodingOptions& options = {});
+        bool exportLevelBinary(const Level& level, const std::string& path);
+        bool exportLevelBinary(const LevelSnapshot& snapshot, const std::string& path);
+        // Writes the atlas layout to path and each page next to it as <stem>_<page>.png.
+        // regionNames maps each name in the layout to the key of its region in the atlas.
+        bool exportAtlas(const TextureAtlas& atlas, const Map<std::string, std::string>& regionNames, const std::string& path);
     }
 }
\ No newline at end of file
@@ -0,0 +1,413 @@
+#include "ProjectSaxHandler.h"
+#include "io/Serialization.h"
+
+using namespace vle;
+
+using json = nlohmann::json;
+
+ProjectSaxHandler::ProjectSaxHandler(Project& project)
+	: mProject{ project },
+	mVertex{},
+	mChainCompact{ false },
+	mSeenHitboxMap{ false },
+	mSeenGameObjects{ false },
+	mSeenLevel{ false },
+	mComplete{ false },
+	mCapturing{ false },
+	mCaptureTarget{ CaptureTarget::Discard },
+	mProjectFields(json::object()),
+	mLevelFields(json::object())
+{
+}
+
+bool ProjectSaxHandler::null()
+{
+	return Scalar(nullptr);
+}
+
+bool ProjectSaxHandler::boolean(bool val)
+{
+	return Scalar(val);
+}
+
+bool ProjectSaxHandler::number_integer(number_integer_t val)
+{
+	return Scalar(val);
+}
+
+bool ProjectSaxHandler::number_unsigned(number_unsigned_t val)
+{
+	return Scalar(val);
+}
+
+bool ProjectSaxHandler::number_float(number_float_t val, const string_t&)
+{
+	return Scalar(val);
+}
+
+bool ProjectSaxHandler::string(string_t& val)
+{
+	return Scalar(std::move(val));
+}
+
+bool ProjectSaxHandler::binary(binary_t& val)
+{
+	return Scalar(json(std::move(val)));
+}
+
+bool ProjectSaxHandler::start_object(std::size_t elements)
+{
+	return BeginContainer(true, elements);
+}
+
+bool ProjectSaxHandler::key(string_t& val)
+{
+	if (mCapturing)
+	{
+		mCaptureKey = val;
+	}
+	else
+	{
+		mKey = val;
+	}
+	return true;
+}
+
+bool ProjectSaxHandler::end_object()
+{
+	return EndContainer();
+}
+
+bool ProjectSaxHandler::start_array(std::size_t elements)
+{
+	return BeginContainer(false, elements);
+}
+
+bool ProjectSaxHandler::end_array()
+{
+	return EndContainer();
+}
+
+bool ProjectSaxHandler::parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex)
+{
+	return Fail(ex.what());
+}
+
+bool ProjectSaxHandler::Scalar(json&& value)
+{
+	if (mCapturing)
+	{
+		return AddCaptured(std::move(value), false);
+	}
+	if (mStack.empty())
+	{
+		return Fail("project file must contain a JSON object");
+	}
+	switch (mStack.back())
+	{
+	case Frame::VertexColor:
+		if (!value.is_number())
+		{
+			return Fail("invalid vertex color");
+		}
+		if (mKey == "r")		mVertex.color.r = value.get<std::uint8_t>();
+		else if (mKey == "g")	mVertex.color.g = value.get<std::uint8_t>();
+		else if (mKey == "b")	mVertex.color.b = value.get<std::uint8_t>();
+		else if (mKey == "a")	mVertex.color.a = value.get<std::uint8_t>();
+		return true;
+	case Frame::VertexPosition:
+		if (!value.is_number())
+		{
+			return Fail("invalid vertex position");
+		}
+		if (mKey == "x")		mVertex.position.x = value.get<float>();
+		else if (mKey == "y")	mVertex.position.y = value.get<float>();
+		return true;
+	case Frame::Project:
+		StartCapture(CaptureTarget::ProjectField);
+		break;
+	case Frame::Level:
+		StartCapture(CaptureTarget::LevelField);
+		break;
+	case Frame::ChainPoints:
+		if (!value.is_number())
+		{
+			return Fail("invalid hitbox chain coordinate");
+		}
+		mChainCoordinates.push_back(value.get<double>());
+		return true;
+	case Frame::ChainColors:
+		if (!value.is_number_unsigned())
+		{
+			return Fail("invalid hitbox chain color");
+		}
+		mChainColors.push_back(value.get<std::uint32_t>());
+		return true;
+	case Frame::Chain:
+		StartCapture(CaptureTarget::ChainField);
+		break;
+	case Frame::Vertex:
+		StartCapture(CaptureTarget::Discard);
+		break;
+	case Frame::GameObjects:
+		StartCapture(CaptureTarget::GameObject);
+		break;
+	default:
+		return Fail("unexpected value in hitbox map");
+	}
+	return AddCaptured(std::move(value), false);
+}
+
+bool ProjectSaxHandler::BeginContainer(bool isObject, std::size_t elements)
+{
+	json container = isObject ? json::object() : json::array();
+	if (mCapturing)
+	{
+		return AddCaptured(std::move(container), true);
+	}
+	if (mStack.empty())
+	{
+		if (!isObject)
+		{
+			return Fail("project file must contain a JSON object");
+		}
+		mStack.push_back(Frame::Project);
+		return true;
+	}
+
+	// Text JSON never knows array sizes up front, binary encodings (CBOR, MessagePack) do.
+	const bool sizeKnown = elements != static_cast<std::size_t>(-1);
+	Level& level = mProject.level;
+	switch (mStack.back())
+	{
+	case Frame::Project:
+		if (mKey == "level" && isObject)
+		{
+			mSeenLevel = true;
+			mStack.push_back(Frame::Level);
+			return true;
+		}
+		StartCapture(CaptureTarget::ProjectField);
+		break;
+	case Frame::Level:
+		if (mKey == "hitboxMap" && !isObject)
+		{
+			mSeenHitboxMap = true;
+			level.hitboxMap.clear();
+			if (sizeKnown) level.hitboxMap.reserve(elements);
+			mStack.push_back(Frame::HitboxMap);
+			return true;
+		}
+		if (mKey == "gameObjects" && !isObject)
+		{
+			mSeenGameObjects = true;
+			level.gameObjects.Clear();
+			if (sizeKnown) level.gameObjects.Reserve(elements);
+			mStack.push_back(Frame::GameObjects);
+			return true;
+		}
+		StartCapture(CaptureTarget::LevelField);
+		break;
+	case Frame::HitboxMap:
+		if (!isObject)
+		{
+			return Fail("hitbox chains must be objects");
+		}
+		level.hitboxMap.emplace_back();
+		mChainFields = json::object();
+		mChainCoordinates.clear();
+		mChainColors.clear();
+		mChainCompact = false;
+		mStack.push_back(Frame::Chain);
+		return true;
+	case Frame::Chain:
+		if (mKey == "vertices" && !isObject)
+		{
+			level.hitboxMap.back().clear();
+			mStack.push_back(Frame::Vertices);
+			return true;
+		}
+		if (mKey == "points" && !isObject)
+		{
+			mChainCompact = true;
+			if (sizeKnown) mChainCoordinates.reserve(elements);
+			mStack.push_back(Frame::ChainPoints);
+			return true;
+		}
+		if (mKey == "colors" && !isObject)
+		{
+			if (sizeKnown) mChainColors.reserve(elements);
+			mStack.push_back(Frame::ChainColors);
+			return true;
+		}
+		StartCapture(CaptureTarget::ChainField);
+		break;
+	case Frame::Vertices:
+		if (!isObject)
+		{
+			return Fail("hitbox vertices must be objects");
+		}
+		mVertex = sf::Vertex{};
+		mStack.push_back(Frame::Vertex);
+		return true;
+	case Frame::Vertex:
+		if (mKey == "color" && isObject)
+		{
+			mStack.push_back(Frame::VertexColor);
+			return true;
+		}
+		if (mKey == "position" && isObject)
+		{
+			mStack.push_back(Frame::VertexPosition);
+			return true;
+		}
+		StartCapture(CaptureTarget::Discard);
+		break;
+	case Frame::GameObjects:
+		StartCapture(CaptureTarget::GameObject);
+		break;
+	default:
+		StartCapture(CaptureTarget::Discard);
+		break;
+	}
+	return AddCaptured(std::move(container), true);
+}
+
+bool ProjectSaxHandler::EndContainer()
+{
+	if (mCapturing)
+	{
+		mCaptureStack.pop_back();
+		return mCaptureStack.empty() ? FinishCapture() : true;
+	}
+	if (mStack.empty())
+	{
+		return Fail("unbalanced JSON");
+	}
+	Frame frame = mStack.back();
+	mStack.pop_back();
+	switch (frame)
+	{
+	case Frame::Vertex:
+		mProject.level.hitboxMap.back().append(mVertex);
+		break;
+	case Frame::Chain:
+		return FinishChain();
+	case Frame::Project:
+		return Finish();
+	default:
+		break;
+	}
+	return true;
+}
+
+void ProjectSaxHandler::StartCapture(CaptureTarget target)
+{
+	mCapturing = true;
+	mCaptureTarget = target;
+	mCaptureName = mKey;
+	mCaptured = nullptr;
+	mCaptureStack.clear();
+}
+
+bool ProjectSaxHandler::AddCaptured(json&& value, bool isContainer)
+{
+	json* slot = nullptr;
+	if (mCaptureStack.empty())
+	{
+		mCaptured = std::move(value);
+		slot = &mCaptured;
+	}
+	else
+	{
+		json& parent = *mCaptureStack.back();
+		if (parent.is_array())
+		{
+			parent.push_back(std::move(value));
+			slot = &parent.back();
+		}
+		else
+		{
+			slot = &(parent[mCaptureKey] = std::move(value));
+		}
+	}
+	if (isContainer)
+	{
+		mCaptureStack.push_back(slot);
+		return true;
+	}
+	return mCaptureStack.empty() ? FinishCapture() : true;
+}
+
+bool ProjectSaxHandler::FinishCapture()
+{
+	mCapturing = false;
+	try
+	{
+		switch (mCaptureTarget)
+		{
+		case CaptureTarget::ProjectField:
+			mProjectFields[mCaptureName] = std::move(mCaptured);
+			break;
+		case CaptureTarget::LevelField:
+			mLevelFields[mCaptureName] = std::move(mCaptured);
+			break;
+		case CaptureTarget::ChainField:
+			mChainFields[mCaptureName] = std::move(mCaptured);
+			break;
+		case CaptureTarget::GameObject:
+			mProject.level.gameObjects.Add(mCaptured.get<GameObject>());
+			break;
+		case CaptureTarget::Discard:
+			break;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		return Fail(e.what());
+	}
+	mCaptured = nullptr;
+	return true;
+}
+
+bool ProjectSaxHandler::FinishChain()
+{
+	sf::VertexArray& chain = mProject.level.hitboxMap.back();
+	try
+	{
+		chain.setPrimitiveType(mChainFields.at("primitiveType").get<sf::PrimitiveType>());
+		if (mChainCompact)
+		{
+			decodeCompactChain(mChainCoordinates, mChainColors, mChainFields, chain);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		return Fail(e.what());
+	}
+	return true;
+}
+
+bool ProjectSaxHandler::Finish()
+{
+	if (!mSeenLevel)		return Fail("missing key 'level'");
+	if (!mSeenHitboxMap)	return Fail("missing key 'hitboxMap'");
+	if (!mSeenGameObjects)	return Fail("missing key 'gameObjects'");
+	try
+	{
+		levelHeaderFromJson(mLevelFields, mProject.level);
+		projectSettingsFromJson(mProjectFields, mProject);
+	}
+	catch (const std::exception& e)
+	{
+		return Fail(e.what());
+	}
+	mComplete = true;
+	return true;
+}
+
+bool ProjectSaxHandler::Fail(const std::string& error)
+{
+	mError = error;
+	return false;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <nlohmann/json.hpp>
+#include "project/Project.h"
+
+namespace vle {
+	// SAX handler that fills a Project while the JSON text is being tokenized.
+	// Hitbox vertices are written straight into Level::hitboxMap (compact chains are decoded
+	// from their flat coordinate list when the chain closes) and each game object is
+	// converted as soon as it closes, so only one small subtree is ever held as a DOM.
+	// Everything else (paths, settings, assets) is small and goes through the regular
+	// from_json converters once the project object ends.
+	class ProjectSaxHandler : public nlohmann::json_sax<nlohmann::json>
+	{
+	public:
+		explicit ProjectSaxHandler(Project& project);
+
+		bool null() override;
+		bool boolean(bool val) override;
+		bool number_integer(number_integer_t val) override;
+		bool number_unsigned(number_unsigned_t val) override;
+		bool number_float(number_float_t val, const string_t& s) override;
+		bool string(string_t& val) override;
+		bool binary(binary_t& val) override;
+		bool start_object(std::size_t elements) override;
+		bool key(string_t& val) override;
+		bool end_object() override;
+		bool start_array(std::size_t elements) override;
+		bool end_array() override;
+		bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex) override;
+
+		bool IsComplete() const { return mComplete; }
+		const std::string& GetError() const { return mError; }
+
+	private:
+		enum class Frame
+		{
+			Project,
+			Level,
+			HitboxMap,
+			Chain,
+			ChainPoints,
+			ChainColors,
+			Vertices,
+			Vertex,
+			VertexColor,
+			VertexPosition,
+			GameObjects
+		};
+
+		enum class CaptureTarget
+		{
+			ProjectField,
+			LevelField,
+			ChainField,
+			GameObject,
+			Discard
+		};
+
+		bool Scalar(nlohmann::json&& value);
+		bool BeginContainer(bool isObject, std::size_t elements);
+		bool EndContainer();
+
+		void StartCapture(CaptureTarget target);
+		bool AddCaptured(nlohmann::json&& value, bool isContainer);
+		bool FinishCapture();
+		bool FinishChain();
+		bool Finish();
+		bool Fail(const std::string& error);
+
+		Project& mProject;
+		List<Frame> mStack;
+		std::string mKey;
+		sf::Vertex mVertex;
+		nlohmann::json mChainFields;
+		List<double> mChainCoordinates;
+		List<std::uint32_t> mChainColors;
+		bool mChainCompact;
+		bool mSeenHitboxMap;
+		bool mSeenGameObjects;
+		bool mSeenLevel;
+		bool mComplete;
+		std::string mError;
+
+		bool mCapturing;
+		CaptureTarget mCaptureTarget;
+		std::string mCaptureName;
+		std::string mCaptureKey;
+		nlohmann::json mCaptured;
+		List<nlohmann::json*> mCaptureStack;
+		nlohmann::json mProjectFields;
+		nlohmann::json mLevelFields;
+	};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <SFML/Graphics.hpp>
+#include "core/Utils.h"
+#include "level/GameObjectStore.h"
+#include "project/Project.h"
+
+namespace vle {
+	// What writing a level reads, frozen so another thread can serialize it while the
+	// editor keeps changing the live level. The hitbox map is shared, not copied: the
+	// editor only ever replaces it as a whole, so one copy serves every snapshot taken
+	// until the next replacement.
+	struct LevelSnapshot
+	{
+		std::string levelNameId;
+		shared<const List<sf::VertexArray>> hitboxMap;
+		shared<const GameObjectStore> gameObjects;
+	};
+
+	struct ProjectSnapshot
+	{
+		// Paths, settings and assets. Its level is left empty; see level below.
+		Project settings;
+		LevelSnapshot level;
+	};
+
+	// hitboxMap may be a copy of level.hitboxMap kept from an earlier snapshot; when it is
+	// null the hitbox map is copied.
+	inline LevelSnapshot snapshotLevel(const Level& level, shared<const List<sf::VertexArray>> hitboxMap = nullptr)
+	{
+		if (!hitboxMap)
+		{
+			hitboxMap = std::make_shared<const List<sf::VertexArray>>(level.hitboxMap);
+		}
+		return LevelSnapshot{ level.levelNameId, std::move(hitboxMap), std::make_shared<const GameObjectStore>(level.gameObjects) };
+	}
+
+	inline ProjectSnapshot snapshotProject(const Project& project, shared<const List<sf::VertexArray>> hitboxMap = nullptr)
+	{
+		ProjectSnapshot snapshot;
+		snapshot.settings.backgroundTexturePath = project.backgroundTexturePath;
+		snapshot.settings.hitboxTexturePath = project.hitboxTexturePath;
+		snapshot.settings.simplifyIndex = project.simplifyIndex;
+		snapshot.settings.bHitboxMap = project.bHitboxMap;
+		snapshot.settings.bHitboxCreateLoop = project.bHitboxCreateLoop;
+		for (const auto& assetPair : project.assets)
+		{
+			if (assetPair.second)
+			{
+				snapshot.settings.assets[assetPair.first] = std::make_unique<Asset>(*assetPair.second);
+			}
+		}
+		snapshot.level = snapshotLevel(project.level, std::move(hitboxMap));
+		return snapshot;
+	}
+}
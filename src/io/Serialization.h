@@ -1,24 +1,40 @@
 #pragma once
 
+#include <cmath>
 #include <nlohmann/json.hpp>
 #include <SFML/Graphics.hpp>
+#include "io/HitboxEncoding.h"
 #include "level/Level.h"
 #include "project/AssetManager.h"
 #include "project/Project.h"
 
+namespace vle {
+	inline void decodeCompactChain(const List<double>& coordinates, const List<std::uint32_t>& colors, const nlohmann::json& fields, sf::VertexArray& chain);
+}
+
 namespace sf
 {
-	void to_json(nlohmann::json& j, const sf::Vector2f& vec)
+	inline void to_json(nlohmann::json& j, const sf::Vector2f& vec)
 	{
 		j = nlohmann::json{ {"x", vec.x}, {"y", vec.y} };
 	}
-	void from_json(const nlohmann::json& j, sf::Vector2f& vec)
+	inline void from_json(const nlohmann::json& j, sf::Vector2f& vec)
 	{
 		j.at("x").get_to(vec.x);
 		j.at("y").get_to(vec.y);
 	}
 
-	void to_json(nlohmann::json& j, const sf::Color& color)
+	inline void to_json(nlohmann::json& j, const sf::IntRect& rect)
+	{
+		j = nlohmann::json{
+			{"x", rect.position.x},
+			{"y", rect.position.y},
+			{"width", rect.size.x},
+			{"height", rect.size.y}
+		};
+	}
+
+	inline void to_json(nlohmann::json& j, const sf::Color& color)
 	{
 		j = nlohmann::json{
 			{"r", color.r },
@@ -27,7 +43,7 @@ namespace sf
 			{"a", color.a }
 		};
 	}
-	void from_json(const nlohmann::json& j, sf::Color& color)
+	inline void from_json(const nlohmann::json& j, sf::Color& color)
 	{
 		j.at("r").get_to(color.r);
 		j.at("g").get_to(color.g);
@@ -35,20 +51,20 @@ namespace sf
 		j.at("a").get_to(color.a);
 	}
 
-	void to_json(nlohmann::json& j, const sf::Vertex& ver)
+	inline void to_json(nlohmann::json& j, const sf::Vertex& ver)
 	{
 		j = nlohmann::json{
 			{"color", ver.color},
 			{"position", ver.position}
 		};
 	}
-	void from_json(const nlohmann::json& j, sf::Vertex& ver)
+	inline void from_json(const nlohmann::json& j, sf::Vertex& ver)
 	{
 		j.at("color").get_to(ver.color);
 		j.at("position").get_to(ver.position);
 	}
 
-	void to_json(nlohmann::json& j, const sf::PrimitiveType& prim)
+	inline void to_json(nlohmann::json& j, const sf::PrimitiveType& prim)
 	{
 		switch (prim)
 		{
@@ -60,7 +76,7 @@ namespace sf
 		case sf::PrimitiveType::TriangleFan:	j = "TriangleFan";		break;
 		}
 	}
-	void from_json(const nlohmann::json& j, sf::PrimitiveType& prim)
+	inline void from_json(const nlohmann::json& j, sf::PrimitiveType& prim)
 	{
 		const std::string primStr = j.get<std::string>();
 		if (primStr == "Points")				prim = sf::PrimitiveType::Points;
@@ -74,7 +90,7 @@ namespace sf
 		}
 	}
 
-	void to_json(nlohmann::json& j, const sf::VertexArray& vertexArray)
+	inline void to_json(nlohmann::json& j, const sf::VertexArray& vertexArray)
 	{
 		j = nlohmann::json{
 			{"primitiveType", vertexArray.getPrimitiveType()},
@@ -86,10 +102,15 @@ namespace sf
 			vertices.push_back(vertexArray[i]);
 		}
 	}
-	void from_json(const nlohmann::json& j, sf::VertexArray& vertexArray)
+	inline void from_json(const nlohmann::json& j, sf::VertexArray& vertexArray)
 	{
 		vertexArray.setPrimitiveType(j.at("primitiveType").get<sf::PrimitiveType>());
 		vertexArray.clear();
+		if (j.contains("points"))
+		{
+			vle::decodeCompactChain(j.at("points").get<vle::List<double>>(), j.value("colors", vle::List<std::uint32_t>{}), j, vertexArray);
+			return;
+		}
 		auto& vertices = j.at("vertices");
 		for (const auto& vertex : vertices)
 		{
@@ -97,13 +118,13 @@ namespace sf
 		}
 	}
 
-	void to_json(nlohmann::json& j, const sf::Angle& angle)
+	inline void to_json(nlohmann::json& j, const sf::Angle& angle)
 	{
 		j = nlohmann::json{
 			{"degrees", angle.asDegrees()}
 		};
 	}
-	void from_json(const nlohmann::json& j, sf::Angle& angle)
+	inline void from_json(const nlohmann::json& j, sf::Angle& angle)
 	{
 		float degrees = j.at("degrees").get<float>();
 		angle = sf::degrees(degrees);
@@ -136,43 +157,178 @@ namespace nlohmann {
 }
 
 namespace vle {
-	void to_json(nlohmann::json& j, const GameObject& object)
+	// Compact chains: {"primitiveType", "points": [x0, y0, ...], "color"?, "colors"?, "quantization"?, "delta"?}
+	// "color" is the packed RGBA of every vertex when it is uniform and not white, "colors" holds
+	// one packed RGBA per vertex otherwise. With "quantization" the points are integer multiples
+	// of that step, and with "delta" each point is stored as the offset from the previous one.
+	inline nlohmann::json hitboxChainToJson(const sf::VertexArray& chain, const HitboxEncodingOptions& options)
+	{
+		if (options.layout == HitboxLayout::Verbose)
+		{
+			return chain;
+		}
+		const size_t count = chain.getVertexCount();
+		const double step = options.quantizationStep;
+		const bool quantize = step > 0.0;
+		const bool delta = quantize && options.deltaEncode;
+
+		nlohmann::json points = nlohmann::json::array();
+		points.get_ref<nlohmann::json::array_t&>().reserve(count * 2);
+		long long previousX = 0;
+		long long previousY = 0;
+		bool uniformColor = true;
+		for (size_t i = 0; i < count; i++)
+		{
+			const sf::Vertex& vertex = chain[i];
+			if (vertex.color != chain[0].color)
+			{
+				uniformColor = false;
+			}
+			if (!quantize)
+			{
+				points.push_back(vertex.position.x);
+				points.push_back(vertex.position.y);
+				continue;
+			}
+			long long x = std::llround(vertex.position.x / step);
+			long long y = std::llround(vertex.position.y / step);
+			points.push_back(delta ? x - previousX : x);
+			points.push_back(delta ? y - previousY : y);
+			previousX = x;
+			previousY = y;
+		}
+
+		nlohmann::json j = nlohmann::json{
+			{"primitiveType", chain.getPrimitiveType()},
+			{"points", std::move(points)}
+		};
+		if (count > 0 && uniformColor && chain[0].color != sf::Color::White)
+		{
+			j["color"] = chain[0].color.toInteger();
+		}
+		else if (!uniformColor)
+		{
+			nlohmann::json colors = nlohmann::json::array();
+			for (size_t i = 0; i < count; i++)
+			{
+				colors.push_back(chain[i].color.toInteger());
+			}
+			j["colors"] = std::move(colors);
+		}
+		if (quantize)
+		{
+			j["quantization"] = options.quantizationStep;
+		}
+		if (delta)
+		{
+			j["delta"] = true;
+		}
+		return j;
+	}
+
+	// Rebuilds the vertices of a compact chain; fields holds the chain's scalar keys.
+	// Shared by from_json and the streaming loader.
+	inline void decodeCompactChain(const List<double>& coordinates, const List<std::uint32_t>& colors, const nlohmann::json& fields, sf::VertexArray& chain)
+	{
+		if (coordinates.size() % 2 != 0)
+		{
+			throw std::invalid_argument("Odd number of hitbox chain coordinates");
+		}
+		const size_t count = coordinates.size() / 2;
+		if (!colors.empty() && colors.size() != count)
+		{
+			throw std::invalid_argument("Hitbox chain colors do not match its points");
+		}
+		const double step = fields.value("quantization", 0.0);
+		const bool delta = step > 0.0 && fields.value("delta", false);
+		const sf::Color uniformColor = fields.contains("color") ? sf::Color(fields.at("color").get<std::uint32_t>()) : sf::Color::White;
+
+		chain.resize(count);
+		double x = 0.0;
+		double y = 0.0;
+		for (size_t i = 0; i < count; i++)
+		{
+			x = delta ? x + coordinates[i * 2] : coordinates[i * 2];
+			y = delta ? y + coordinates[i * 2 + 1] : coordinates[i * 2 + 1];
+			sf::Vertex& vertex = chain[i];
+			vertex.position = step > 0.0 ? sf::Vector2f(float(x * step), float(y * step)) : sf::Vector2f(float(x), float(y));
+			vertex.color = colors.empty() ? uniformColor : sf::Color(colors[i]);
+		}
+	}
+
+	inline void to_json(nlohmann::json& j, const GameObject& object)
 	{
 		j = nlohmann::json{
 			{"assetID", object.assetID},
-			{"position", object.sprite->getPosition()},
-			{"scale", object.sprite->getScale()},
-			{"rotation", object.sprite->getRotation()},
-			{"origin", object.sprite->getOrigin()}
+			{"position", object.position},
+			{"scale", object.scale},
+			{"rotation", object.rotation},
+			{"origin", object.origin}
 		};
 	}
-	void from_json(const nlohmann::json& j, GameObject& object)
+	inline void from_json(const nlohmann::json& j, GameObject& object)
 	{
 		j.at("assetID").get_to(object.assetID);
-		const sf::Texture texture;
-		object.sprite.emplace(texture);
-		object.sprite->setPosition(j.at("position").get<sf::Vector2f>());
-		object.sprite->setScale(j.at("scale").get<sf::Vector2f>());
-		object.sprite->setRotation(j.at("rotation").get<sf::Angle>());
-		object.sprite->setOrigin(j.at("origin").get<sf::Vector2f>());
+		j.at("position").get_to(object.position);
+		j.at("scale").get_to(object.scale);
+		j.at("rotation").get_to(object.rotation);
+		j.at("origin").get_to(object.origin);
 	}
 
-	void to_json(nlohmann::json& j, const Level& level)
+	inline void to_json(nlohmann::json& j, const GameObjectStore& objects)
 	{
-		j = nlohmann::json{
-			{"levelNameId", level.levelNameId},
-			{"hitboxMap", level.hitboxMap},
-			{"gameObjects", level.gameObjects}
+		j = nlohmann::json::array();
+		j.get_ref<nlohmann::json::array_t&>().reserve(objects.GetCount());
+		for (size_t i = 0; i < objects.GetCount(); i++)
+		{
+			j.push_back(objects.Get(i));
+		}
+	}
+	inline void from_json(const nlohmann::json& j, GameObjectStore& objects)
+	{
+		objects.Clear();
+		objects.Reserve(j.size());
+		for (const nlohmann::json& object : j)
+		{
+			objects.Add(object.get<GameObject>());
+		}
+	}
+
+	inline nlohmann::json levelToJson(const std::string& levelNameId, const List<sf::VertexArray>& hitboxMap,
+		const GameObjectStore& gameObjects, const HitboxEncodingOptions& options)
+	{
+		nlohmann::json chains = nlohmann::json::array();
+		for (const sf::VertexArray& chain : hitboxMap)
+		{
+			chains.push_back(hitboxChainToJson(chain, options));
+		}
+		return nlohmann::json{
+			{"levelNameId", levelNameId},
+			{"hitboxMap", std::move(chains)},
+			{"gameObjects", gameObjects}
 		};
 	}
-	void from_json(const nlohmann::json& j, Level& level)
+	inline nlohmann::json levelToJson(const Level& level, const HitboxEncodingOptions& options)
+	{
+		return levelToJson(level.levelNameId, level.hitboxMap, level.gameObjects, options);
+	}
+	inline void to_json(nlohmann::json& j, const Level& level)
+	{
+		j = levelToJson(level, HitboxEncodingOptions{});
+	}
+	// Level fields other than hitboxMap and gameObjects, shared with the streaming loader.
+	inline void levelHeaderFromJson(const nlohmann::json& j, Level& level)
 	{
 		j.at("levelNameId").get_to(level.levelNameId);
+	}
+	inline void from_json(const nlohmann::json& j, Level& level)
+	{
+		levelHeaderFromJson(j, level);
 		j.at("hitboxMap").get_to(level.hitboxMap);
 		j.at("gameObjects").get_to(level.gameObjects);
 	}
 
-	void to_json(nlohmann::json& j, const Asset& asset)
+	inline void to_json(nlohmann::json& j, const Asset& asset)
 	{
 		j = nlohmann::json{
 			{"texturePath", asset.texturePath},
@@ -180,17 +336,18 @@ namespace vle {
 			{"defaultRotation", asset.defaultRotation}
 		};
 	}
-	void from_json(const nlohmann::json& j, Asset& asset)
+	inline void from_json(const nlohmann::json& j, Asset& asset)
 	{
 		j.at("texturePath").get_to(asset.texturePath);
 		j.at("defaultScale").get_to(asset.defaultScale);
 		j.at("defaultRotation").get_to(asset.defaultRotation);
 	}
 
-	void to_json(nlohmann::json& j, const Project& project)
+	// Project fields around an already converted level.
+	inline nlohmann::json projectToJson(const Project& project, nlohmann::json level)
 	{
-		j = nlohmann::json{
-			{"level", project.level},
+		return nlohmann::json{
+			{"level", std::move(level)},
 			{"backgroundTexturePath", project.backgroundTexturePath},
 			{"hitboxTexturePath", project.hitboxTexturePath},
 			{"simplifyIndex", project.simplifyIndex},
@@ -198,13 +355,57 @@ namespace vle {
 			{"assets", project.assets}
 		};
 	}
-	void from_json(const nlohmann::json& j, Project& project)
+	inline nlohmann::json projectToJson(const Project& project, const HitboxEncodingOptions& options)
+	{
+		return projectToJson(project, levelToJson(project.level, options));
+	}
+	inline void to_json(nlohmann::json& j, const Project& project)
+	{
+		j = projectToJson(project, HitboxEncodingOptions{});
+	}
+	// Project fields other than the level, shared with the streaming loader.
+	inline void projectSettingsFromJson(const nlohmann::json& j, Project& project)
 	{
-		j.at("level").get_to(project.level);
 		j.at("backgroundTexturePath").get_to(project.backgroundTexturePath);
 		j.at("hitboxTexturePath").get_to(project.hitboxTexturePath);
 		j.at("simplifyIndex").get_to(project.simplifyIndex);
 		j.at("bHitboxMap").get_to(project.bHitboxMap);
 		j.at("assets").get_to(project.assets);
 	}
-}
\ No newline at end of file
+	inline void from_json(const nlohmann::json& j, Project& project)
+	{
+		j.at("level").get_to(project.level);
+		projectSettingsFromJson(j, project);
+	}
+
+	// pageImages holds the file name written for each atlas page, in page order. regionNames
+	// maps each name to write to the key of its region, which several names may share.
+	inline nlohmann::json atlasToJson(const TextureAtlas& atlas, const Map<std::string, std::string>& regionNames, const List<std::string>& pageImages)
+	{
+		nlohmann::json pages = nlohmann::json::array();
+		for (size_t i = 0; i < atlas.GetPageCount(); i++)
+		{
+			sf::Vector2u size = atlas.GetPage(i).getSize();
+			pages.push_back(nlohmann::json{
+				{"image", pageImages.at(i)},
+				{"width", size.x},
+				{"height", size.y}
+			});
+		}
+		nlohmann::json regions = nlohmann::json::object();
+		for (const auto& pair : regionNames)
+		{
+			if (const AtlasRegion* region = atlas.GetRegion(pair.second))
+			{
+				regions[pair.first] = nlohmann::json{
+					{"page", region->page},
+					{"rect", region->rect}
+				};
+			}
+		}
+		return nlohmann::json{
+			{"pages", std::move(pages)},
+			{"regions", std::move(regions)}
+		};
+	}
+}
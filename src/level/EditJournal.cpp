@@ -0,0 +1,248 @@
+#include "EditJournal.h"
+
+using namespace vle;
+
+ObjectTransform ObjectTransform::Of(const GameObjectStore& objects, size_t index)
+{
+	return ObjectTransform{ objects.GetPositions()[index], objects.GetScales()[index], objects.GetRotations()[index] };
+}
+
+void ObjectTransform::ApplyTo(GameObjectStore& objects, size_t index) const
+{
+	objects.SetPosition(index, position);
+	objects.SetScale(index, scale);
+	objects.SetRotation(index, rotation);
+}
+
+EditJournal::EditJournal(size_t memoryLimit)
+	: mCursor{ 0 },
+	mMemoryLimit{ memoryLimit },
+	mMemoryUsage{ 0 },
+	mMergeOpen{ false }
+{
+}
+
+void EditJournal::RecordTransform(GameObjectHandle object, const ObjectTransform& before, const ObjectTransform& after)
+{
+	if (mMergeOpen && !CanRedo() && !mEntries.empty())
+	{
+		Entry& last = mEntries.back();
+		if (last.type == EntryType::Transform && last.transforms.size() == 1 && last.transforms[0].object == object)
+		{
+			last.transforms[0].after = after;
+			return;
+		}
+	}
+	Entry entry;
+	entry.type = EntryType::Transform;
+	entry.transforms.push_back(TransformChange{ object, before, after });
+	Push(std::move(entry));
+	mMergeOpen = true;
+}
+
+void EditJournal::RecordTransforms(List<TransformChange> changes)
+{
+	if (changes.empty())
+	{
+		return;
+	}
+	Entry entry;
+	entry.type = EntryType::Transform;
+	entry.transforms = std::move(changes);
+	entry.transforms.shrink_to_fit();
+	Push(std::move(entry));
+}
+
+void EditJournal::RecordAdd(const Level& level, GameObjectHandle object)
+{
+	Push(Capture(EntryType::Add, level, object));
+}
+
+void EditJournal::RecordRemove(const Level& level, GameObjectHandle object)
+{
+	Push(Capture(EntryType::Remove, level, object));
+}
+
+void EditJournal::BringToFront(Level& level, GameObjectHandle object)
+{
+	Entry entry;
+	entry.type = EntryType::BringToFront;
+	entry.object = object;
+	entry.index = level.gameObjects.IndexOf(object);
+	if (entry.index == GameObjectStore::kInvalidIndex)
+	{
+		return;
+	}
+	entry.order = level.spatialIndex.GetOrder(object);
+	level.gameObjects.BringToFront(entry.index);
+	level.spatialIndex.BringToFront(object);
+	entry.frontOrder = level.spatialIndex.GetOrder(object);
+	Push(std::move(entry));
+}
+
+bool EditJournal::Undo(Level& level, Change& change)
+{
+	mMergeOpen = false;
+	if (!CanUndo())
+	{
+		return false;
+	}
+	const Entry& entry = mEntries[--mCursor];
+	switch (entry.type)
+	{
+	case EntryType::Transform:
+		ApplyTransforms(level, entry, true, change);
+		break;
+	case EntryType::Add:
+		Erase(level, entry, change);
+		break;
+	case EntryType::Remove:
+		Reinsert(level, entry, change);
+		break;
+	case EntryType::BringToFront:
+		MoveTo(level, entry, entry.index, entry.order, change);
+		break;
+	}
+	return true;
+}
+
+bool EditJournal::Redo(Level& level, Change& change)
+{
+	mMergeOpen = false;
+	if (!CanRedo())
+	{
+		return false;
+	}
+	const Entry& entry = mEntries[mCursor++];
+	switch (entry.type)
+	{
+	case EntryType::Transform:
+		ApplyTransforms(level, entry, false, change);
+		break;
+	case EntryType::Add:
+		Reinsert(level, entry, change);
+		break;
+	case EntryType::Remove:
+		Erase(level, entry, change);
+		break;
+	case EntryType::BringToFront:
+		MoveTo(level, entry, level.gameObjects.GetCount() - 1, entry.frontOrder, change);
+		break;
+	}
+	return true;
+}
+
+void EditJournal::Clear()
+{
+	mEntries.clear();
+	mCursor = 0;
+	mMemoryUsage = 0;
+	mMergeOpen = false;
+}
+
+void EditJournal::SetMemoryLimit(size_t bytes)
+{
+	mMemoryLimit = bytes;
+	TrimToLimit();
+}
+
+void EditJournal::Push(Entry&& entry)
+{
+	// A new edit ends the redo branch.
+	while (mEntries.size() > mCursor)
+	{
+		mMemoryUsage -= EntryBytes(mEntries.back());
+		mEntries.pop_back();
+	}
+	mMemoryUsage += EntryBytes(entry);
+	mEntries.push_back(std::move(entry));
+	mCursor = mEntries.size();
+	mMergeOpen = false;
+	TrimToLimit();
+}
+
+EditJournal::Entry EditJournal::Capture(EntryType type, const Level& level, GameObjectHandle object) const
+{
+	Entry entry;
+	entry.type = type;
+	entry.object = object;
+	entry.index = level.gameObjects.IndexOf(object);
+	if (entry.index != GameObjectStore::kInvalidIndex)
+	{
+		entry.record = level.gameObjects.Get(entry.index);
+		entry.size = level.gameObjects.GetSizes()[entry.index];
+	}
+	entry.order = level.spatialIndex.GetOrder(object);
+	return entry;
+}
+
+size_t EditJournal::EntryBytes(const Entry& entry)
+{
+	return sizeof(Entry) + entry.transforms.capacity() * sizeof(TransformChange) + entry.record.assetID.capacity();
+}
+
+void EditJournal::ApplyTransforms(Level& level, const Entry& entry, bool undo, Change& change)
+{
+	GameObjectStore& objects = level.gameObjects;
+	for (const TransformChange& transform : entry.transforms)
+	{
+		const size_t index = objects.IndexOf(transform.object);
+		if (index == GameObjectStore::kInvalidIndex)
+		{
+			continue;
+		}
+		(undo ? transform.before : transform.after).ApplyTo(objects, index);
+		level.spatialIndex.Update(transform.object, objects.GetBounds(index));
+		change.transformed.push_back(transform.object);
+	}
+}
+
+void EditJournal::Reinsert(Level& level, const Entry& entry, Change& change)
+{
+	if (entry.index == GameObjectStore::kInvalidIndex ||
+		!level.gameObjects.Restore(entry.object, entry.index, entry.record, entry.size))
+	{
+		return;
+	}
+	level.spatialIndex.Insert(entry.object, level.gameObjects.GetBounds(entry.index), entry.order);
+	change.structure = Change::Structure::Added;
+	change.index = entry.index;
+}
+
+void EditJournal::Erase(Level& level, const Entry& entry, Change& change)
+{
+	const size_t index = level.gameObjects.IndexOf(entry.object);
+	if (index == GameObjectStore::kInvalidIndex)
+	{
+		return;
+	}
+	level.spatialIndex.Remove(entry.object);
+	level.gameObjects.Remove(entry.object);
+	change.structure = Change::Structure::Removed;
+	change.index = index;
+}
+
+void EditJournal::MoveTo(Level& level, const Entry& entry, size_t to, std::uint64_t order, Change& change)
+{
+	const size_t index = level.gameObjects.IndexOf(entry.object);
+	if (index == GameObjectStore::kInvalidIndex || to >= level.gameObjects.GetCount())
+	{
+		return;
+	}
+	level.gameObjects.Move(index, to);
+	level.spatialIndex.SetOrder(entry.object, order);
+	change.structure = Change::Structure::Moved;
+	change.index = index;
+	change.toIndex = to;
+}
+
+void EditJournal::TrimToLimit()
+{
+	// The newest entry is kept even when it alone is over the limit.
+	while (mMemoryUsage > mMemoryLimit && mEntries.size() > 1 && mCursor > 0)
+	{
+		mMemoryUsage -= EntryBytes(mEntries.front());
+		mEntries.pop_front();
+		mCursor--;
+	}
+}
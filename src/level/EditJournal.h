@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <SFML/Graphics.hpp>
+#include "core/Utils.h"
+#include "Level.h"
+
+namespace vle {
+	// The part of an object the editor lets the user change directly.
+	struct ObjectTransform
+	{
+		sf::Vector2f position;
+		sf::Vector2f scale;
+		sf::Angle rotation;
+
+		static ObjectTransform Of(const GameObjectStore& objects, size_t index);
+		void ApplyTo(GameObjectStore& objects, size_t index) const;
+
+		bool operator==(const ObjectTransform& other) const
+		{
+			return position == other.position && scale == other.scale && rotation == other.rotation;
+		}
+		bool operator!=(const ObjectTransform& other) const { return !(*this == other); }
+	};
+
+	// Undo history of the edits made to a level's game objects. Entries hold only
+	// what an edit changed, so undoing or redoing costs as much as the edit did,
+	// however large the level is. Once the entries use more memory than the limit
+	// the oldest ones are dropped.
+	class EditJournal
+	{
+	public:
+		struct TransformChange
+		{
+			GameObjectHandle object;
+			ObjectTransform before;
+			ObjectTransform after;
+		};
+
+		// What an undo or redo touched, so the caller can refresh what it draws.
+		struct Change
+		{
+			enum class Structure
+			{
+				None,
+				Added,
+				Removed,
+				Moved
+			};
+
+			// An undo or redo adds, removes or moves at most one object: index is where it
+			// was added or removed, or where it moved from, and toIndex where it moved to.
+			Structure structure = Structure::None;
+			size_t index = 0;
+			size_t toIndex = 0;
+			List<GameObjectHandle> transformed;
+
+			bool IsStructural() const { return structure != Structure::None; }
+		};
+
+		static constexpr size_t kDefaultMemoryLimit = 32 * 1024 * 1024;
+
+		explicit EditJournal(size_t memoryLimit = kDefaultMemoryLimit);
+
+		// Consecutive changes to the same object fold into one entry until Seal is
+		// called, so a drag or a slider gesture undoes in one step.
+		void RecordTransform(GameObjectHandle object, const ObjectTransform& before, const ObjectTransform& after);
+		// One entry for an edit applied to many objects at once.
+		void RecordTransforms(List<TransformChange> changes);
+		// Call after the object was added and bound to its texture.
+		void RecordAdd(const Level& level, GameObjectHandle object);
+		// Call before the object is removed.
+		void RecordRemove(const Level& level, GameObjectHandle object);
+		// Brings the object to the front of the draw order and records it. Redo puts it
+		// back under the same order key, which later entries rely on.
+		void BringToFront(Level& level, GameObjectHandle object);
+		void Seal() { mMergeOpen = false; }
+
+		bool Undo(Level& level, Change& change);
+		bool Redo(Level& level, Change& change);
+		bool CanUndo() const { return mCursor > 0; }
+		bool CanRedo() const { return mCursor < mEntries.size(); }
+		void Clear();
+
+		void SetMemoryLimit(size_t bytes);
+		size_t GetMemoryLimit() const { return mMemoryLimit; }
+		size_t GetMemoryUsage() const { return mMemoryUsage; }
+		size_t GetUndoCount() const { return mCursor; }
+
+	private:
+		enum class EntryType
+		{
+			Transform,
+			Add,
+			Remove,
+			BringToFront
+		};
+
+		struct Entry
+		{
+			EntryType type;
+			List<TransformChange> transforms;
+			// Add, Remove and BringToFront: the object and where it sat in draw order.
+			GameObjectHandle object;
+			GameObject record;
+			sf::Vector2f size;
+			size_t index = 0;
+			std::uint64_t order = 0;
+			std::uint64_t frontOrder = 0;
+		};
+
+		void Push(Entry&& entry);
+		Entry Capture(EntryType type, const Level& level, GameObjectHandle object) const;
+		static size_t EntryBytes(const Entry& entry);
+		static void ApplyTransforms(Level& level, const Entry& entry, bool undo, Change& change);
+		static void Reinsert(Level& level, const Entry& entry, Change& change);
+		static void Erase(Level& level, const Entry& entry, Change& change);
+		static void MoveTo(Level& level, const Entry& entry, size_t to, std::uint64_t order, Change& change);
+		void TrimToLimit();
+
+		// Oldest entry first; entries from mCursor on are the ones Redo replays.
+		std::deque<Entry> mEntries;
+		size_t mCursor;
+		size_t mMemoryLimit;
+		size_t mMemoryUsage;
+		bool mMergeOpen;
+	};
+}
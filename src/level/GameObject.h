@@ -1,12 +1,44 @@
 #pragma once
 
-#include <iostream>
-#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <SFML/System.hpp>
 
 namespace vle {
+	// One placed asset instance as it is saved and loaded. In the editor objects live
+	// column-wise in a GameObjectStore; this record is only used to move them in and out.
 	struct GameObject
 	{
 		std::string assetID;
-		std::optional<sf::Sprite> sprite;
+		sf::Vector2f position;
+		sf::Vector2f scale{ 1.f, 1.f };
+		sf::Angle rotation;
+		sf::Vector2f origin;
 	};
-}
\ No newline at end of file
+
+	// Refers to an object for as long as it exists. Once the object is removed the
+	// handle goes stale instead of pointing at whatever reuses its slot.
+	struct GameObjectHandle
+	{
+		std::uint32_t slot = kInvalidSlot;
+		std::uint32_t generation = 0;
+
+		bool IsNull() const { return slot == kInvalidSlot; }
+		bool operator==(const GameObjectHandle& other) const { return slot == other.slot && generation == other.generation; }
+		bool operator!=(const GameObjectHandle& other) const { return !(*this == other); }
+
+		static constexpr std::uint32_t kInvalidSlot = 0xFFFFFFFFu;
+	};
+}
+
+namespace std {
+	template<>
+	struct hash<vle::GameObjectHandle>
+	{
+		size_t operator()(const vle::GameObjectHandle& handle) const
+		{
+			return std::hash<std::uint64_t>()((static_cast<std::uint64_t>(handle.generation) << 32) | handle.slot);
+		}
+	};
+}
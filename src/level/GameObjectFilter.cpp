@@ -0,0 +1,173 @@
+#include "GameObjectFilter.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace vle;
+
+GameObjectFilter::GameObjectFilter()
+	: mSelectedOnly{ false },
+	mSelected{},
+	mDirty{ true },
+	mObjectsRevision{ 0 },
+	mSpatialRevision{ 0 },
+	mObjectCount{ 0 }
+{
+}
+
+void GameObjectFilter::SetText(const std::string& text)
+{
+	std::string lower = ToLower(text);
+	if (lower != mText)
+	{
+		mText = std::move(lower);
+		mDirty = true;
+	}
+}
+
+void GameObjectFilter::SetRegion(const std::optional<sf::FloatRect>& region)
+{
+	if (region != mRegion)
+	{
+		mRegion = region;
+		mDirty = true;
+	}
+}
+
+void GameObjectFilter::SetSelectedOnly(bool selectedOnly, GameObjectHandle selected)
+{
+	if (selectedOnly != mSelectedOnly || (selectedOnly && selected != mSelected))
+	{
+		mDirty = true;
+	}
+	mSelectedOnly = selectedOnly;
+	mSelected = selected;
+}
+
+bool GameObjectFilter::IsActive() const
+{
+	return !mText.empty() || mRegion.has_value() || mSelectedOnly;
+}
+
+void GameObjectFilter::Update(const GameObjectStore& objects, const SpatialIndex& spatialIndex)
+{
+	// Transforms do not change the rows unless they are limited to a region.
+	if (!mDirty && objects.GetRevision() == mObjectsRevision &&
+		(!mRegion || spatialIndex.GetRevision() == mSpatialRevision))
+	{
+		return;
+	}
+	mDirty = false;
+	mObjectsRevision = objects.GetRevision();
+	mSpatialRevision = spatialIndex.GetRevision();
+	mObjectCount = objects.GetCount();
+	mRows.clear();
+	if (!IsActive())
+	{
+		return;
+	}
+	if (!mText.empty())
+	{
+		MatchAssets();
+	}
+
+	const List<AssetIndex>& assets = objects.GetAssets();
+	if (mSelectedOnly)
+	{
+		const size_t index = objects.IndexOf(mSelected);
+		if (index != GameObjectStore::kInvalidIndex && (mText.empty() || AssetMatches(assets[index])) &&
+			(!mRegion || objects.GetBounds(index).findIntersection(*mRegion)))
+		{
+			mRows.push_back(index);
+		}
+		return;
+	}
+	if (mRegion)
+	{
+		mQueryResult.clear();
+		spatialIndex.Query(*mRegion, mQueryResult);
+		for (GameObjectHandle handle : mQueryResult)
+		{
+			const size_t index = objects.IndexOf(handle);
+			if (index != GameObjectStore::kInvalidIndex && (mText.empty() || AssetMatches(assets[index])))
+			{
+				mRows.push_back(index);
+			}
+		}
+	}
+	else
+	{
+		for (AssetIndex asset : mMatchedAssets)
+		{
+			objects.GetInstances(asset, mInstances);
+			mRows.insert(mRows.end(), mInstances.begin(), mInstances.end());
+		}
+	}
+	std::sort(mRows.begin(), mRows.end());
+}
+
+size_t GameObjectFilter::GetRowCount() const
+{
+	return IsActive() ? mRows.size() : mObjectCount;
+}
+
+size_t GameObjectFilter::GetIndex(size_t row) const
+{
+	return IsActive() ? mRows[row] : row;
+}
+
+void GameObjectFilter::MatchAssets()
+{
+	if (mText != mMatchedText)
+	{
+		// Anything that contains the new text contained the old one it extends.
+		if (!mMatchedText.empty() && mText.find(mMatchedText) != std::string::npos)
+		{
+			auto dropped = std::remove_if(mMatchedAssets.begin(), mMatchedAssets.end(), [this](AssetIndex asset)
+				{
+					return mLowerNames[asset].find(mText) == std::string::npos;
+				});
+			for (auto it = dropped; it != mMatchedAssets.end(); ++it)
+			{
+				mAssetMatches[*it] = false;
+			}
+			mMatchedAssets.erase(dropped, mMatchedAssets.end());
+		}
+		else
+		{
+			mMatchedAssets.clear();
+			for (AssetIndex asset = 0; asset < mAssetMatches.size(); asset++)
+			{
+				mAssetMatches[asset] = mLowerNames[asset].find(mText) != std::string::npos;
+				if (mAssetMatches[asset])
+				{
+					mMatchedAssets.push_back(asset);
+				}
+			}
+		}
+		mMatchedText = mText;
+	}
+
+	// Names interned since the last match, by new assets or loaded levels.
+	const NameTable& names = NameTable::Assets();
+	for (AssetIndex asset = static_cast<AssetIndex>(mLowerNames.size()); asset < names.GetCount(); asset++)
+	{
+		mLowerNames.push_back(ToLower(names.GetName(asset)));
+		mAssetMatches.push_back(mLowerNames.back().find(mText) != std::string::npos);
+		if (mAssetMatches.back())
+		{
+			mMatchedAssets.push_back(asset);
+		}
+	}
+}
+
+bool GameObjectFilter::AssetMatches(AssetIndex asset) const
+{
+	return asset < mAssetMatches.size() && mAssetMatches[asset];
+}
+
+std::string GameObjectFilter::ToLower(const std::string& text)
+{
+	std::string lower = text;
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return lower;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <SFML/Graphics.hpp>
+#include "core/Utils.h"
+#include "GameObjectStore.h"
+#include "SpatialIndex.h"
+
+namespace vle {
+	// The rows of the game object list: draw indices of the objects whose asset ID
+	// contains the search text, that overlap a region and, optionally, only the
+	// selected one. Matches come from the per-asset instances of the store and from
+	// the spatial index instead of a scan of every object, and are only rebuilt when
+	// the filter or the level changes. Without a filter every object is a row and
+	// nothing is stored.
+	class GameObjectFilter
+	{
+	public:
+		GameObjectFilter();
+
+		// Case-insensitive. Typing on refines the previous matches instead of
+		// checking every asset name again.
+		void SetText(const std::string& text);
+		void SetRegion(const std::optional<sf::FloatRect>& region);
+		// A null handle with selectedOnly set shows nothing.
+		void SetSelectedOnly(bool selectedOnly, GameObjectHandle selected);
+		bool IsActive() const;
+
+		// Call once per frame before reading rows.
+		void Update(const GameObjectStore& objects, const SpatialIndex& spatialIndex);
+		size_t GetRowCount() const;
+		// Draw index of the object shown in the row.
+		size_t GetIndex(size_t row) const;
+
+	private:
+		void MatchAssets();
+		bool AssetMatches(AssetIndex asset) const;
+		static std::string ToLower(const std::string& text);
+
+		std::string mText;
+		std::optional<sf::FloatRect> mRegion;
+		bool mSelectedOnly;
+		GameObjectHandle mSelected;
+		bool mDirty;
+
+		// Addressed by asset index, covering the names interned when last matched.
+		List<std::string> mLowerNames;
+		List<char> mAssetMatches;
+		List<AssetIndex> mMatchedAssets;
+		std::string mMatchedText;
+
+		std::uint64_t mObjectsRevision;
+		std::uint64_t mSpatialRevision;
+		size_t mObjectCount;
+		List<size_t> mRows;
+		List<size_t> mInstances;
+		List<GameObjectHandle> mQueryResult;
+	};
+}
@@ -0,0 +1,309 @@
+#include "GameObjectStore.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace vle;
+
+namespace
+{
+	std::uint64_t NextRevision()
+	{
+		static std::atomic<std::uint64_t> revision{ 0 };
+		return ++revision;
+	}
+}
+
+GameObjectHandle GameObjectStore::Add(const GameObject& object)
+{
+	std::uint32_t slot = GameObjectHandle::kInvalidSlot;
+	while (!mFreeSlots.empty() && slot == GameObjectHandle::kInvalidSlot)
+	{
+		if (!IsSlotLive(mFreeSlots.back()))
+		{
+			slot = mFreeSlots.back();
+		}
+		mFreeSlots.pop_back();
+	}
+	if (slot == GameObjectHandle::kInvalidSlot)
+	{
+		slot = static_cast<std::uint32_t>(mSlots.size());
+		mSlots.push_back(Slot{ 0, 0 });
+	}
+	const AssetIndex asset = NameTable::Assets().Intern(object.assetID);
+	mSlots[slot].index = static_cast<std::uint32_t>(mAssets.size());
+	mAssets.push_back(asset);
+	mPositions.push_back(object.position);
+	mScales.push_back(object.scale);
+	mRotations.push_back(object.rotation);
+	mOrigins.push_back(object.origin);
+	mSizes.push_back({});
+	mIndexSlots.push_back(slot);
+	AddInstance(asset, slot);
+	mRevision = NextRevision();
+	return GameObjectHandle{ slot, mSlots[slot].generation };
+}
+
+bool GameObjectStore::Remove(GameObjectHandle handle)
+{
+	const size_t index = IndexOf(handle);
+	if (index == kInvalidIndex)
+	{
+		return false;
+	}
+	EraseAt(index);
+	return true;
+}
+
+size_t GameObjectStore::RemoveIf(const std::function<bool(size_t index)>& predicate)
+{
+	// Compact every column in one pass instead of erasing objects one at a time.
+	size_t kept = 0;
+	const size_t count = GetCount();
+	for (size_t i = 0; i < count; i++)
+	{
+		const std::uint32_t slot = mIndexSlots[i];
+		if (predicate(i))
+		{
+			ReleaseSlot(slot);
+			RemoveInstance(mAssets[i], slot);
+			continue;
+		}
+		if (kept != i)
+		{
+			mAssets[kept] = mAssets[i];
+			mPositions[kept] = mPositions[i];
+			mScales[kept] = mScales[i];
+			mRotations[kept] = mRotations[i];
+			mOrigins[kept] = mOrigins[i];
+			mSizes[kept] = mSizes[i];
+			mIndexSlots[kept] = slot;
+			mSlots[slot].index = static_cast<std::uint32_t>(kept);
+		}
+		kept++;
+	}
+	mAssets.resize(kept);
+	mPositions.resize(kept);
+	mScales.resize(kept);
+	mRotations.resize(kept);
+	mOrigins.resize(kept);
+	mSizes.resize(kept);
+	mIndexSlots.resize(kept);
+	if (kept != count)
+	{
+		mRevision = NextRevision();
+	}
+	return count - kept;
+}
+
+void GameObjectStore::Clear()
+{
+	// Generations survive a clear so handles from before it stay stale.
+	for (std::uint32_t slot : mIndexSlots)
+	{
+		ReleaseSlot(slot);
+	}
+	for (List<std::uint32_t>& instances : mAssetInstances)
+	{
+		instances.clear();
+	}
+	mAssets.clear();
+	mPositions.clear();
+	mScales.clear();
+	mRotations.clear();
+	mOrigins.clear();
+	mSizes.clear();
+	mIndexSlots.clear();
+	mRevision = NextRevision();
+}
+
+void GameObjectStore::Reserve(size_t count)
+{
+	mAssets.reserve(count);
+	mPositions.reserve(count);
+	mScales.reserve(count);
+	mRotations.reserve(count);
+	mOrigins.reserve(count);
+	mSizes.reserve(count);
+	mIndexSlots.reserve(count);
+	mSlots.reserve(count);
+}
+
+size_t GameObjectStore::IndexOf(GameObjectHandle handle) const
+{
+	if (handle.slot >= mSlots.size())
+	{
+		return kInvalidIndex;
+	}
+	const Slot& slot = mSlots[handle.slot];
+	if (slot.generation != handle.generation || slot.index >= mIndexSlots.size() || mIndexSlots[slot.index] != handle.slot)
+	{
+		return kInvalidIndex;
+	}
+	return slot.index;
+}
+
+GameObjectHandle GameObjectStore::HandleAt(size_t index) const
+{
+	const std::uint32_t slot = mIndexSlots[index];
+	return GameObjectHandle{ slot, mSlots[slot].generation };
+}
+
+GameObject GameObjectStore::Get(size_t index) const
+{
+	return GameObject{ GetAssetID(index), mPositions[index], mScales[index], mRotations[index], mOrigins[index] };
+}
+
+const std::string& GameObjectStore::GetAssetID(size_t index) const
+{
+	return NameTable::Assets().GetName(mAssets[index]);
+}
+
+void GameObjectStore::Move(size_t from, size_t to)
+{
+	if (from == to)
+	{
+		return;
+	}
+	const size_t first = std::min(from, to);
+	const size_t last = std::max(from, to);
+	auto move = [from, to](auto& column)
+		{
+			if (from < to)
+			{
+				std::rotate(column.begin() + from, column.begin() + from + 1, column.begin() + to + 1);
+			}
+			else
+			{
+				std::rotate(column.begin() + to, column.begin() + from, column.begin() + from + 1);
+			}
+		};
+	move(mAssets);
+	move(mPositions);
+	move(mScales);
+	move(mRotations);
+	move(mOrigins);
+	move(mSizes);
+	move(mIndexSlots);
+	for (size_t i = first; i <= last; i++)
+	{
+		mSlots[mIndexSlots[i]].index = static_cast<std::uint32_t>(i);
+	}
+	mRevision = NextRevision();
+}
+
+bool GameObjectStore::Restore(GameObjectHandle handle, size_t index, const GameObject& object, sf::Vector2f size)
+{
+	if (handle.slot >= mSlots.size() || IsSlotLive(handle.slot) || index > GetCount())
+	{
+		return false;
+	}
+	const AssetIndex asset = NameTable::Assets().Intern(object.assetID);
+	mAssets.insert(mAssets.begin() + index, asset);
+	mPositions.insert(mPositions.begin() + index, object.position);
+	mScales.insert(mScales.begin() + index, object.scale);
+	mRotations.insert(mRotations.begin() + index, object.rotation);
+	mOrigins.insert(mOrigins.begin() + index, object.origin);
+	mSizes.insert(mSizes.begin() + index, size);
+	mIndexSlots.insert(mIndexSlots.begin() + index, handle.slot);
+	mSlots[handle.slot].generation = handle.generation;
+	for (size_t i = index; i < mIndexSlots.size(); i++)
+	{
+		mSlots[mIndexSlots[i]].index = static_cast<std::uint32_t>(i);
+	}
+	AddInstance(asset, handle.slot);
+	mRevision = NextRevision();
+	return true;
+}
+
+void GameObjectStore::GetInstances(AssetIndex asset, List<size_t>& indices) const
+{
+	indices.clear();
+	if (asset >= mAssetInstances.size())
+	{
+		return;
+	}
+	indices.reserve(mAssetInstances[asset].size());
+	for (std::uint32_t slot : mAssetInstances[asset])
+	{
+		indices.push_back(mSlots[slot].index);
+	}
+}
+
+size_t GameObjectStore::GetInstanceCount(AssetIndex asset) const
+{
+	return asset < mAssetInstances.size() ? mAssetInstances[asset].size() : 0;
+}
+
+sf::Transform GameObjectStore::GetTransform(size_t index) const
+{
+	const float angle = -mRotations[index].asRadians();
+	const float cosine = std::cos(angle);
+	const float sine = std::sin(angle);
+	const sf::Vector2f scale = mScales[index];
+	const sf::Vector2f origin = mOrigins[index];
+	const sf::Vector2f position = mPositions[index];
+	const float sxc = scale.x * cosine;
+	const float syc = scale.y * cosine;
+	const float sxs = scale.x * sine;
+	const float sys = scale.y * sine;
+	const float tx = -origin.x * sxc - origin.y * sys + position.x;
+	const float ty = origin.x * sxs - origin.y * syc + position.y;
+	return sf::Transform(sxc, sys, tx, -sxs, syc, ty, 0.f, 0.f, 1.f);
+}
+
+sf::FloatRect GameObjectStore::GetBounds(size_t index) const
+{
+	return GetTransform(index).transformRect(sf::FloatRect({ 0.f, 0.f }, mSizes[index]));
+}
+
+bool GameObjectStore::IsSlotLive(std::uint32_t slot) const
+{
+	const std::uint32_t index = mSlots[slot].index;
+	return index < mIndexSlots.size() && mIndexSlots[index] == slot;
+}
+
+void GameObjectStore::ReleaseSlot(std::uint32_t slot)
+{
+	mSlots[slot].generation = mNextGeneration++;
+	mFreeSlots.push_back(slot);
+}
+
+void GameObjectStore::EraseAt(size_t index)
+{
+	const std::uint32_t slot = mIndexSlots[index];
+	ReleaseSlot(slot);
+	RemoveInstance(mAssets[index], slot);
+	mAssets.erase(mAssets.begin() + index);
+	mPositions.erase(mPositions.begin() + index);
+	mScales.erase(mScales.begin() + index);
+	mRotations.erase(mRotations.begin() + index);
+	mOrigins.erase(mOrigins.begin() + index);
+	mSizes.erase(mSizes.begin() + index);
+	mIndexSlots.erase(mIndexSlots.begin() + index);
+	for (size_t i = index; i < mIndexSlots.size(); i++)
+	{
+		mSlots[mIndexSlots[i]].index = static_cast<std::uint32_t>(i);
+	}
+	mRevision = NextRevision();
+}
+
+void GameObjectStore::AddInstance(AssetIndex asset, std::uint32_t slot)
+{
+	if (asset >= mAssetInstances.size())
+	{
+		mAssetInstances.resize(asset + 1);
+	}
+	mAssetInstances[asset].push_back(slot);
+}
+
+void GameObjectStore::RemoveInstance(AssetIndex asset, std::uint32_t slot)
+{
+	List<std::uint32_t>& instances = mAssetInstances[asset];
+	auto found = std::find(instances.begin(), instances.end(), slot);
+	if (found != instances.end())
+	{
+		*found = instances.back();
+		instances.pop_back();
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <functional>
+#include <SFML/Graphics.hpp>
+#include "core/NameTable.h"
+#include "core/Utils.h"
+#include "GameObject.h"
+
+namespace vle {
+	// Game objects stored as parallel arrays in draw order: index 0 is drawn first.
+	// Indices shift when objects are removed or reordered, so anything kept across
+	// frames (selection, tools) holds a GameObjectHandle and resolves it with IndexOf.
+	// Asset names are interned, and the instances of every asset are indexed so
+	// per-asset edits only visit the objects they change.
+	class GameObjectStore
+	{
+	public:
+		// Adds the object on top of everything else.
+		GameObjectHandle Add(const GameObject& object);
+		bool Remove(GameObjectHandle handle);
+		// Removes every object the predicate accepts, keeping the order of the rest.
+		size_t RemoveIf(const std::function<bool(size_t index)>& predicate);
+		void Clear();
+		void Reserve(size_t count);
+
+		size_t GetCount() const { return mAssets.size(); }
+		// Changes whenever objects are added, removed or reordered. Unique across
+		// stores, so equal revisions mean equal contents even after a copy.
+		std::uint64_t GetRevision() const { return mRevision; }
+		bool IsEmpty() const { return mAssets.empty(); }
+		bool IsValid(GameObjectHandle handle) const { return IndexOf(handle) != kInvalidIndex; }
+		// Draw-order index of the object, kInvalidIndex once it has been removed.
+		size_t IndexOf(GameObjectHandle handle) const;
+		GameObjectHandle HandleAt(size_t index) const;
+		GameObject Get(size_t index) const;
+		void BringToFront(size_t index) { Move(index, GetCount() - 1); }
+		// Moves the object to another draw index, shifting the ones in between.
+		void Move(size_t from, size_t to);
+		// Puts a removed object back at a draw index under its old handle, so handles
+		// taken before the removal resolve to it again. Used by undo and redo; fails
+		// if the handle's slot is in use.
+		bool Restore(GameObjectHandle handle, size_t index, const GameObject& object, sf::Vector2f size);
+
+		const List<AssetIndex>& GetAssets() const { return mAssets; }
+		const std::string& GetAssetID(size_t index) const;
+		const List<sf::Vector2f>& GetPositions() const { return mPositions; }
+		const List<sf::Vector2f>& GetScales() const { return mScales; }
+		const List<sf::Angle>& GetRotations() const { return mRotations; }
+		const List<sf::Vector2f>& GetOrigins() const { return mOrigins; }
+		// Size of the texture region each object shows; zero until its texture is bound.
+		const List<sf::Vector2f>& GetSizes() const { return mSizes; }
+
+		void SetPosition(size_t index, sf::Vector2f position) { mPositions[index] = position; }
+		void SetScale(size_t index, sf::Vector2f scale) { mScales[index] = scale; }
+		void SetRotation(size_t index, sf::Angle rotation) { mRotations[index] = rotation; }
+		void SetOrigin(size_t index, sf::Vector2f origin) { mOrigins[index] = origin; }
+		void SetSize(size_t index, sf::Vector2f size) { mSizes[index] = size; }
+
+		// Draw-order indices of every instance of the asset, in no particular order.
+		void GetInstances(AssetIndex asset, List<size_t>& indices) const;
+		size_t GetInstanceCount(AssetIndex asset) const;
+
+		// Same transform an sf::Sprite with these properties would have.
+		sf::Transform GetTransform(size_t index) const;
+		sf::FloatRect GetBounds(size_t index) const;
+
+		static constexpr size_t kInvalidIndex = static_cast<size_t>(-1);
+
+	private:
+		struct Slot
+		{
+			std::uint32_t generation;
+			std::uint32_t index;
+		};
+
+		bool IsSlotLive(std::uint32_t slot) const;
+		void ReleaseSlot(std::uint32_t slot);
+		void EraseAt(size_t index);
+		void AddInstance(AssetIndex asset, std::uint32_t slot);
+		void RemoveInstance(AssetIndex asset, std::uint32_t slot);
+
+		List<AssetIndex> mAssets;
+		List<sf::Vector2f> mPositions;
+		List<sf::Vector2f> mScales;
+		List<sf::Angle> mRotations;
+		List<sf::Vector2f> mOrigins;
+		List<sf::Vector2f> mSizes;
+		List<std::uint32_t> mIndexSlots;
+
+		List<Slot> mSlots;
+		// May hold slots that Restore took back; Add skips those.
+		List<std::uint32_t> mFreeSlots;
+		// Generations are unique per store, so a restored handle can never collide
+		// with one handed out while its object was gone.
+		std::uint32_t mNextGeneration = 1;
+		std::uint64_t mRevision = 0;
+		// Slots of the instances of each asset, addressed by asset index.
+		List<List<std::uint32_t>> mAssetInstances;
+	};
+}
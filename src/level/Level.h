@@ -1,7 +1,9 @@
 #pragma once
 
 #include "Vectorizer/Vectorizer.h"
-#include "GameObject.h"
+#include "GameObjectStore.h"
+#include "RankedChains.h"
+#include "SpatialIndex.h"
 #include "core/Utils.h"
 
 namespace vle {
@@ -9,10 +11,41 @@ namespace vle {
 	{
 		std::string levelNameId;
 		List<sf::VertexArray> hitboxMap;
-		List<unique<GameObject>> gameObjects;
-		void addGameObject(unique<GameObject> object)
+		GameObjectStore gameObjects;
+		// Editor-side lookup structure, not serialized. Rebuild it after replacing gameObjects.
+		SpatialIndex spatialIndex;
+		// Editor-side, not serialized: the chains hitboxMap was simplified from.
+		RankedChains tracedHitboxes;
+		GameObjectHandle addGameObject(const GameObject& object)
 		{
-			gameObjects.push_back(std::move(object));
+			GameObjectHandle handle = gameObjects.Add(object);
+			spatialIndex.Insert(handle, gameObjects.GetBounds(gameObjects.GetCount() - 1));
+			return handle;
+		}
+		void removeGameObject(GameObjectHandle handle)
+		{
+			spatialIndex.Remove(handle);
+			gameObjects.Remove(handle);
+		}
+		void setHitboxChains(const List<Vectorizer::Math::Chain>& chains)
+		{
+			List<sf::VertexArray> newHitboxMap;
+			newHitboxMap.reserve(chains.size());
+			for (const Vectorizer::Math::Chain& chain : chains)
+			{
+				sf::VertexArray newChain(sf::PrimitiveType::LineStrip);
+				for (const Vectorizer::Math::Point& point : chain)
+				{
+					newChain.append(sf::Vertex{ { point.x, point.y } });
+				}
+				newHitboxMap.push_back(std::move(newChain));
+			}
+			hitboxMap.swap(newHitboxMap);
+		}
+		void setTracedHitboxes(const List<Vectorizer::Math::Chain>& chains, int simplifyIndex)
+		{
+			tracedHitboxes.Build(chains);
+			tracedHitboxes.Simplify(simplifyIndex, hitboxMap);
 		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "RankedChains.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+using namespace vle;
+using Vectorizer::Math::Chain;
+using Vectorizer::Math::Point;
+
+namespace
+{
+	// Slider level n drops vertices spanning less than kAreaPerStep * n^2 square pixels,
+	// roughly a bump n pixels wide and n pixels tall.
+	const float kAreaPerStep = 0.5f;
+	const float kKeep = std::numeric_limits<float>::infinity();
+
+	float TriangleArea(const Point& a, const Point& b, const Point& c)
+	{
+		return 0.5f * std::fabs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y));
+	}
+}
+
+void RankedChains::Build(const List<Chain>& chains)
+{
+	Clear();
+	size_t total = 0;
+	for (const Chain& chain : chains)
+	{
+		total += chain.size();
+	}
+	mPoints.reserve(total);
+	mChains.reserve(chains.size());
+	for (const Chain& chain : chains)
+	{
+		if (chain.empty())
+		{
+			continue;
+		}
+		// Closed chains repeat their first point; it is stored once and re-added by Simplify.
+		const bool closed = chain.size() > 3 && chain.front().x == chain.back().x && chain.front().y == chain.back().y;
+		ChainInfo info{ mPoints.size(), closed ? chain.size() - 1 : chain.size(), closed };
+		mPoints.insert(mPoints.end(), chain.begin(), chain.begin() + info.count);
+		mChains.push_back(info);
+	}
+	mRanks.assign(mPoints.size(), kKeep);
+	for (const ChainInfo& chain : mChains)
+	{
+		RankChain(chain);
+	}
+}
+
+void RankedChains::Clear()
+{
+	mPoints.clear();
+	mRanks.clear();
+	mChains.clear();
+}
+
+void RankedChains::RankChain(const ChainInfo& chain)
+{
+	// Open chains keep their end points; closed chains never shrink below a triangle.
+	const size_t minimumCount = chain.closed ? 3 : 2;
+	if (chain.count <= minimumCount)
+	{
+		return;
+	}
+	const Point* points = &mPoints[chain.first];
+	float* ranks = &mRanks[chain.first];
+	const size_t count = chain.count;
+	List<size_t> previous(count);
+	List<size_t> next(count);
+	List<float> areas(count, kKeep);
+	for (size_t i = 0; i < count; i++)
+	{
+		previous[i] = (i + count - 1) % count;
+		next[i] = (i + 1) % count;
+	}
+
+	using Entry = std::pair<float, size_t>;
+	std::priority_queue<Entry, List<Entry>, std::greater<Entry>> heap;
+	auto updateArea = [&](size_t i)
+		{
+			if (!chain.closed && (i == 0 || i == count - 1))
+			{
+				return;
+			}
+			areas[i] = TriangleArea(points[previous[i]], points[i], points[next[i]]);
+			heap.push({ areas[i], i });
+		};
+	for (size_t i = 0; i < count; i++)
+	{
+		updateArea(i);
+	}
+
+	// Vertices are removed smallest triangle first. A removal never gets a rank below the
+	// one before it, so every threshold keeps a consistent prefix of the removal order.
+	size_t remaining = count;
+	float lastRank = 0.f;
+	while (remaining > minimumCount && !heap.empty())
+	{
+		const Entry entry = heap.top();
+		heap.pop();
+		const size_t i = entry.second;
+		if (ranks[i] != kKeep || entry.first != areas[i])
+		{
+			continue;
+		}
+		lastRank = std::max(lastRank, entry.first);
+		ranks[i] = lastRank;
+		remaining--;
+		next[previous[i]] = next[i];
+		previous[next[i]] = previous[i];
+		updateArea(previous[i]);
+		updateArea(next[i]);
+	}
+}
+
+void RankedChains::Simplify(int simplifyIndex, List<sf::VertexArray>& hitboxMap) const
+{
+	const float threshold = AreaThreshold(simplifyIndex);
+	List<sf::VertexArray> simplified;
+	simplified.reserve(mChains.size());
+	for (const ChainInfo& chain : mChains)
+	{
+		sf::VertexArray newChain(sf::PrimitiveType::LineStrip);
+		size_t firstKept = chain.count;
+		for (size_t i = 0; i < chain.count; i++)
+		{
+			if (mRanks[chain.first + i] >= threshold)
+			{
+				const Point& point = mPoints[chain.first + i];
+				newChain.append(sf::Vertex{ { point.x, point.y } });
+				firstKept = std::min(firstKept, i);
+			}
+		}
+		if (chain.closed && firstKept < chain.count)
+		{
+			const Point& point = mPoints[chain.first + firstKept];
+			newChain.append(sf::Vertex{ { point.x, point.y } });
+		}
+		simplified.push_back(std::move(newChain));
+	}
+	hitboxMap.swap(simplified);
+}
+
+float RankedChains::AreaThreshold(int simplifyIndex)
+{
+	const float step = static_cast<float>(std::max(simplifyIndex, 0));
+	// Level 0 still drops exactly collinear points, which carry no shape.
+	return std::max(kAreaPerStep * step * step, std::numeric_limits<float>::min());
+}
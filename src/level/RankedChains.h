@@ -0,0 +1,41 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "Vectorizer/Vectorizer.h"
+#include "core/Utils.h"
+
+namespace vle {
+	// Unsimplified hitbox chains with a Visvalingam-Whyatt importance rank per vertex.
+	// Ranks are computed once; any simplification level is then a filter that keeps the
+	// vertices ranked above its threshold, so the simplify slider can be previewed live.
+	// Editor-side only, not serialized.
+	class RankedChains
+	{
+	public:
+		void Build(const List<Vectorizer::Math::Chain>& chains);
+		void Clear();
+		bool IsEmpty() const { return mChains.empty(); }
+		size_t GetVertexCount() const { return mPoints.size(); }
+
+		// Writes the chains simplified to the given slider level as white line strips.
+		void Simplify(int simplifyIndex, List<sf::VertexArray>& hitboxMap) const;
+		// Smallest triangle area, in square pixels, a vertex must span to survive the given level.
+		static float AreaThreshold(int simplifyIndex);
+		// Level the vectorizer is asked for when tracing chains that will be ranked.
+		static constexpr int kTraceSimplifyIndex = 0;
+
+	private:
+		struct ChainInfo
+		{
+			size_t first;
+			size_t count;
+			bool closed;
+		};
+
+		void RankChain(const ChainInfo& chain);
+
+		List<Vectorizer::Math::Point> mPoints;
+		List<float> mRanks;
+		List<ChainInfo> mChains;
+	};
+}
@@ -0,0 +1,248 @@
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace vle;
+
+void SpatialIndex::Clear()
+{
+	mEntries.clear();
+	mCells.clear();
+	mOversized.clear();
+	mNextOrder = 0;
+	mRevision++;
+}
+
+void SpatialIndex::Rebuild(const GameObjectStore& objects)
+{
+	Clear();
+	mEntries.reserve(objects.GetCount());
+	for (size_t i = 0; i < objects.GetCount(); i++)
+	{
+		Insert(objects.HandleAt(i), objects.GetBounds(i));
+	}
+}
+
+void SpatialIndex::Insert(GameObjectHandle object, const sf::FloatRect& bounds)
+{
+	Insert(object, bounds, mNextOrder);
+}
+
+void SpatialIndex::Insert(GameObjectHandle object, const sf::FloatRect& bounds, std::uint64_t order)
+{
+	Remove(object);
+	Entry& entry = mEntries[object];
+	entry.object = object;
+	entry.order = order;
+	mNextOrder = std::max(mNextOrder, order + 1);
+	entry.bounds = bounds;
+	entry.stamp = 0;
+	AddToCells(entry);
+	mRevision++;
+}
+
+void SpatialIndex::Remove(GameObjectHandle object)
+{
+	auto found = mEntries.find(object);
+	if (found == mEntries.end())
+	{
+		return;
+	}
+	RemoveFromCells(found->second);
+	mEntries.erase(found);
+	mRevision++;
+}
+
+void SpatialIndex::Update(GameObjectHandle object, const sf::FloatRect& bounds)
+{
+	auto found = mEntries.find(object);
+	if (found == mEntries.end())
+	{
+		return;
+	}
+	Entry& entry = found->second;
+	entry.bounds = bounds;
+	mRevision++;
+	const sf::Vector2i minCell = CellOf(entry.bounds.position);
+	const sf::Vector2i maxCell = CellOf(entry.bounds.position + entry.bounds.size);
+	if (!entry.oversized && minCell == entry.minCell && maxCell == entry.maxCell)
+	{
+		return;
+	}
+	RemoveFromCells(entry);
+	AddToCells(entry);
+}
+
+void SpatialIndex::BringToFront(GameObjectHandle object)
+{
+	auto found = mEntries.find(object);
+	if (found != mEntries.end())
+	{
+		found->second.order = mNextOrder++;
+	}
+}
+
+std::uint64_t SpatialIndex::GetOrder(GameObjectHandle object) const
+{
+	auto found = mEntries.find(object);
+	return found != mEntries.end() ? found->second.order : 0;
+}
+
+void SpatialIndex::SetOrder(GameObjectHandle object, std::uint64_t order)
+{
+	auto found = mEntries.find(object);
+	if (found != mEntries.end())
+	{
+		found->second.order = order;
+		mNextOrder = std::max(mNextOrder, order + 1);
+	}
+}
+
+GameObjectHandle SpatialIndex::Pick(sf::Vector2f point) const
+{
+	const Entry* best = nullptr;
+	auto consider = [&best, point](const Entry* entry)
+		{
+			if (entry->bounds.contains(point) && (!best || entry->order > best->order))
+			{
+				best = entry;
+			}
+		};
+	const sf::Vector2i cell = CellOf(point);
+	auto found = mCells.find(CellKey(cell.x, cell.y));
+	if (found != mCells.end())
+	{
+		for (const Entry* entry : found->second)
+		{
+			consider(entry);
+		}
+	}
+	for (const Entry* entry : mOversized)
+	{
+		consider(entry);
+	}
+	return best ? best->object : GameObjectHandle{};
+}
+
+void SpatialIndex::Query(const sf::FloatRect& area, List<GameObjectHandle>& result) const
+{
+	// Objects spanning several cells are seen once per cell; the stamp reports each only once.
+	const std::uint32_t stamp = ++mQueryStamp;
+	auto collect = [&result, &area, stamp](const Entry* entry)
+		{
+			if (entry->stamp != stamp && Overlaps(entry->bounds, area))
+			{
+				entry->stamp = stamp;
+				result.push_back(entry->object);
+			}
+		};
+
+	const sf::Vector2i minCell = CellOf(area.position);
+	const sf::Vector2i maxCell = CellOf(area.position + area.size);
+	const double areaCells = (double(maxCell.x) - minCell.x + 1) * (double(maxCell.y) - minCell.y + 1);
+	if (areaCells > static_cast<double>(mCells.size()))
+	{
+		// Zoomed far out: walking the occupied cells is cheaper than walking the area.
+		for (const auto& cell : mCells)
+		{
+			for (const Entry* entry : cell.second)
+			{
+				collect(entry);
+			}
+		}
+	}
+	else
+	{
+		for (int y = minCell.y; y <= maxCell.y; y++)
+		{
+			for (int x = minCell.x; x <= maxCell.x; x++)
+			{
+				auto found = mCells.find(CellKey(x, y));
+				if (found == mCells.end())
+				{
+					continue;
+				}
+				for (const Entry* entry : found->second)
+				{
+					collect(entry);
+				}
+			}
+		}
+	}
+	for (const Entry* entry : mOversized)
+	{
+		collect(entry);
+	}
+}
+
+sf::Vector2i SpatialIndex::CellOf(sf::Vector2f point) const
+{
+	return { static_cast<int>(std::floor(point.x / mCellSize)), static_cast<int>(std::floor(point.y / mCellSize)) };
+}
+
+std::uint64_t SpatialIndex::CellKey(int x, int y)
+{
+	return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+}
+
+bool SpatialIndex::Overlaps(const sf::FloatRect& a, const sf::FloatRect& b)
+{
+	// Inclusive, so objects without a texture yet (zero sized bounds) are still found.
+	return a.position.x <= b.position.x + b.size.x && b.position.x <= a.position.x + a.size.x &&
+		a.position.y <= b.position.y + b.size.y && b.position.y <= a.position.y + a.size.y;
+}
+
+void SpatialIndex::AddToCells(Entry& entry)
+{
+	entry.minCell = CellOf(entry.bounds.position);
+	entry.maxCell = CellOf(entry.bounds.position + entry.bounds.size);
+	const long long cellCount = (static_cast<long long>(entry.maxCell.x) - entry.minCell.x + 1) *
+		(static_cast<long long>(entry.maxCell.y) - entry.minCell.y + 1);
+	entry.oversized = cellCount > kMaxCellsPerObject;
+	if (entry.oversized)
+	{
+		mOversized.push_back(&entry);
+		return;
+	}
+	for (int y = entry.minCell.y; y <= entry.maxCell.y; y++)
+	{
+		for (int x = entry.minCell.x; x <= entry.maxCell.x; x++)
+		{
+			mCells[CellKey(x, y)].push_back(&entry);
+		}
+	}
+}
+
+void SpatialIndex::RemoveFromCells(Entry& entry)
+{
+	auto removeFrom = [&entry](List<Entry*>& entries)
+		{
+			auto found = std::find(entries.begin(), entries.end(), &entry);
+			if (found != entries.end())
+			{
+				*found = entries.back();
+				entries.pop_back();
+			}
+		};
+	if (entry.oversized)
+	{
+		removeFrom(mOversized);
+		return;
+	}
+	for (int y = entry.minCell.y; y <= entry.maxCell.y; y++)
+	{
+		for (int x = entry.minCell.x; x <= entry.maxCell.x; x++)
+		{
+			auto cell = mCells.find(CellKey(x, y));
+			if (cell == mCells.end())
+			{
+				continue;
+			}
+			removeFrom(cell->second);
+			if (cell->second.empty())
+			{
+				mCells.erase(cell);
+			}
+		}
+	}
+}
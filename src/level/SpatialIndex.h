@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <SFML/Graphics.hpp>
+#include "core/Utils.h"
+#include "GameObjectStore.h"
+
+namespace vle {
+	// Uniform hash grid over the world bounds of game objects.
+	// Every object gets an order key that grows with draw order, so picking returns
+	// the topmost hit without knowing list positions. Objects spanning too many
+	// cells are kept in a separate list that every query checks.
+	class SpatialIndex
+	{
+	public:
+		explicit SpatialIndex(float cellSize = 256.f)
+			: mCellSize{ cellSize },
+			mNextOrder{ 0 },
+			mQueryStamp{ 0 },
+			mRevision{ 0 }
+		{
+		}
+
+		SpatialIndex(const SpatialIndex&) = delete;
+		SpatialIndex& operator=(const SpatialIndex&) = delete;
+		SpatialIndex(SpatialIndex&&) = default;
+		SpatialIndex& operator=(SpatialIndex&&) = default;
+
+		void Clear();
+		// Orders objects by their draw order in the store.
+		void Rebuild(const GameObjectStore& objects);
+		// Adds the object on top of everything already indexed.
+		void Insert(GameObjectHandle object, const sf::FloatRect& bounds);
+		// Adds the object with an order key taken earlier from GetOrder.
+		void Insert(GameObjectHandle object, const sf::FloatRect& bounds, std::uint64_t order);
+		void Remove(GameObjectHandle object);
+		// Call after the object moved, scaled, rotated or changed texture.
+		void Update(GameObjectHandle object, const sf::FloatRect& bounds);
+		void BringToFront(GameObjectHandle object);
+		// Order keys let undo put an object back exactly where it was in the stack.
+		std::uint64_t GetOrder(GameObjectHandle object) const;
+		void SetOrder(GameObjectHandle object, std::uint64_t order);
+
+		// Topmost object whose bounds contain the point, a null handle if there is none.
+		GameObjectHandle Pick(sf::Vector2f point) const;
+		// Appends every object whose bounds overlap the area, in no particular order.
+		void Query(const sf::FloatRect& area, List<GameObjectHandle>& result) const;
+		size_t GetCount() const { return mEntries.size(); }
+		// Changes whenever an object is inserted, removed or its bounds change.
+		std::uint64_t GetRevision() const { return mRevision; }
+
+	private:
+		struct Entry
+		{
+			GameObjectHandle object;
+			std::uint64_t order;
+			sf::FloatRect bounds;
+			sf::Vector2i minCell;
+			sf::Vector2i maxCell;
+			bool oversized;
+			mutable std::uint32_t stamp;
+		};
+
+		static constexpr int kMaxCellsPerObject = 64;
+
+		sf::Vector2i CellOf(sf::Vector2f point) const;
+		static std::uint64_t CellKey(int x, int y);
+		static bool Overlaps(const sf::FloatRect& a, const sf::FloatRect& b);
+		void AddToCells(Entry& entry);
+		void RemoveFromCells(Entry& entry);
+
+		float mCellSize;
+		std::uint64_t mNextOrder;
+		mutable std::uint32_t mQueryStamp;
+		std::uint64_t mRevision;
+		Dictionary<GameObjectHandle, Entry> mEntries;
+		Dictionary<std::uint64_t, List<Entry*>> mCells;
+		List<Entry*> mOversized;
+	};
+}
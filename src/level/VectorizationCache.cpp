@@ -0,0 +1,221 @@
+#include "VectorizationCache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "core/Hash.h"
+#include "io/AtomicFile.h"
+#include "io/BinaryIO.h"
+
+using namespace vle;
+using Vectorizer::Math::Chain;
+using Vectorizer::Math::Point;
+
+namespace
+{
+	const char kEntryExtension[] = ".chains";
+	const char kMagic[4] = { 'V', 'L', 'E', 'C' };
+	const uint32_t kVersion = 1;
+
+	std::optional<uint64_t> HashFile(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			return std::nullopt;
+		}
+		uint64_t hash = kFnvOffset;
+		List<char> buffer(1 << 16);
+		while (file)
+		{
+			file.read(buffer.data(), buffer.size());
+			hash = Fnv1a(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+		}
+		return hash;
+	}
+}
+
+VectorizationCache& VectorizationCache::Get()
+{
+	// Initialized once even when tracing threads make the first call at the same time.
+	static VectorizationCache vectorizationCache;
+	return vectorizationCache;
+}
+
+VectorizationCache::VectorizationCache()
+	: mMaxSize{ kDefaultMaxSize },
+	mStats{}
+{
+}
+
+std::string VectorizationCache::EntryPath(const std::string& imagePath, int simplifyIndex) const
+{
+	namespace fs = std::filesystem;
+	std::optional<uint64_t> hash = HashFile(imagePath);
+	if (!hash.has_value())
+	{
+		return "";
+	}
+	const int32_t settings = simplifyIndex;
+	const uint64_t key = Fnv1a(&settings, sizeof(settings), hash.value());
+	std::ostringstream name;
+	name << std::hex << key << kEntryExtension;
+	return (fs::path(imagePath).parent_path() / kCacheDirectory / name.str()).string();
+}
+
+std::optional<List<Chain>> VectorizationCache::Load(const std::string& imagePath, int simplifyIndex)
+{
+	namespace fs = std::filesystem;
+	const std::string path = EntryPath(imagePath, simplifyIndex);
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	const std::streamoff fileSize = file.is_open() ? static_cast<std::streamoff>(file.tellg()) : 0;
+	file.seekg(0);
+	// Counts are checked against the bytes left, so a truncated or corrupt entry is a
+	// miss rather than a huge allocation.
+	auto fits = [&file, fileSize](uint64_t count, uint64_t recordSize)
+		{
+			const std::streamoff position = file.tellg();
+			return position >= 0 && count <= static_cast<uint64_t>(fileSize - position) / recordSize;
+		};
+	const uint64_t pointSize = sizeof(Point::x) + sizeof(Point::y);
+	List<Chain> chains;
+	char magic[4] = {};
+	uint32_t version = 0;
+	uint32_t chainCount = 0;
+	bool valid = !path.empty() && file.is_open() && file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(magic)) == 0 &&
+		Read(file, version) && version == kVersion && Read(file, chainCount) && fits(chainCount, sizeof(uint32_t));
+	if (valid)
+	{
+		chains.resize(chainCount);
+		for (Chain& chain : chains)
+		{
+			uint32_t pointCount = 0;
+			if (!Read(file, pointCount) || !fits(pointCount, pointSize))
+			{
+				valid = false;
+				break;
+			}
+			chain.resize(pointCount);
+			for (Point& point : chain)
+			{
+				valid = valid && Read(file, point.x) && Read(file, point.y);
+			}
+			if (!valid)
+			{
+				break;
+			}
+		}
+	}
+	file.close();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!valid)
+	{
+		mStats.misses++;
+		return std::nullopt;
+	}
+	// Touch the entry so eviction goes by last use rather than by creation.
+	std::error_code ignored;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), ignored);
+	mStats.hits++;
+	return chains;
+}
+
+bool VectorizationCache::Store(const std::string& imagePath, int simplifyIndex, const List<Chain>& chains)
+{
+	namespace fs = std::filesystem;
+	const std::string path = EntryPath(imagePath, simplifyIndex);
+	if (path.empty())
+	{
+		return false;
+	}
+	std::error_code error;
+	const fs::path directory = fs::path(path).parent_path();
+	fs::create_directories(directory, error);
+	if (error)
+	{
+		std::cerr << "Error: cannot create vectorization cache " << directory.string() << ": " << error.message() << std::endl;
+		return false;
+	}
+
+	// Written under a temporary name so a concurrent Load never sees half an entry.
+	const std::string temporaryPath = TemporaryPathFor(path);
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << "Error: cannot write vectorization cache entry " << temporaryPath << std::endl;
+			return false;
+		}
+		file.write(kMagic, sizeof(kMagic));
+		Write(file, kVersion);
+		Write(file, static_cast<uint32_t>(chains.size()));
+		for (const Chain& chain : chains)
+		{
+			Write(file, static_cast<uint32_t>(chain.size()));
+			for (const Point& point : chain)
+			{
+				Write(file, point.x);
+				Write(file, point.y);
+			}
+		}
+		if (!file)
+		{
+			std::cerr << "Error: cannot write vectorization cache entry " << temporaryPath << std::endl;
+			return false;
+		}
+	}
+	fs::rename(temporaryPath, path, error);
+	if (error)
+	{
+		fs::remove(temporaryPath, error);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	Trim(directory.string());
+	return true;
+}
+
+VectorizationCacheStats VectorizationCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+void VectorizationCache::Trim(const std::string& directory)
+{
+	namespace fs = std::filesystem;
+	struct Entry
+	{
+		fs::path path;
+		std::uintmax_t size;
+		fs::file_time_type lastUse;
+	};
+	List<Entry> entries;
+	std::uintmax_t totalSize = 0;
+	std::error_code error;
+	for (const fs::directory_entry& file : fs::directory_iterator(directory, error))
+	{
+		if (!file.is_regular_file(error) || file.path().extension() != kEntryExtension)
+		{
+			continue;
+		}
+		Entry entry{ file.path(), file.file_size(error), file.last_write_time(error) };
+		totalSize += entry.size;
+		entries.push_back(std::move(entry));
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+	// The newest entry is always kept, even when it alone exceeds the cap.
+	for (size_t i = 0; i + 1 < entries.size() && totalSize > mMaxSize; i++)
+	{
+		if (fs::remove(entries[i].path, error))
+		{
+			totalSize -= entries[i].size;
+			mStats.evictions++;
+		}
+	}
+	mStats.diskBytes = totalSize;
+}
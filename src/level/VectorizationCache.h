@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include "Vectorizer/Vectorizer.h"
+#include "core/Utils.h"
+
+namespace vle {
+	struct VectorizationCacheStats
+	{
+		unsigned long long hits = 0;
+		unsigned long long misses = 0;
+		unsigned long long evictions = 0;
+		// Size of the cache directory written to last.
+		std::uintmax_t diskBytes = 0;
+	};
+
+	// Keeps traced hitbox chains on disk, in a .vle_cache directory next to the hitbox image,
+	// so an unchanged image is traced only once. Entries are keyed by a hash of the image
+	// bytes together with the settings that produced them; the oldest entries of a directory
+	// are evicted once it grows past the size cap.
+	class VectorizationCache
+	{
+	public:
+		static VectorizationCache& Get();
+
+		VectorizationCache(const VectorizationCache&) = delete;
+		VectorizationCache& operator=(const VectorizationCache&) = delete;
+		VectorizationCache(VectorizationCache&&) = delete;
+		VectorizationCache& operator=(VectorizationCache&&) = delete;
+
+		// Closing loops only changes the export, so it is not part of the key.
+		std::optional<List<Vectorizer::Math::Chain>> Load(const std::string& imagePath, int simplifyIndex);
+		bool Store(const std::string& imagePath, int simplifyIndex, const List<Vectorizer::Math::Chain>& chains);
+
+		void SetMaxSize(std::uintmax_t bytes) { mMaxSize = bytes; }
+		std::uintmax_t GetMaxSize() const { return mMaxSize; }
+		VectorizationCacheStats GetStats() const;
+
+		static constexpr std::uintmax_t kDefaultMaxSize = 256ull * 1024 * 1024;
+
+	private:
+		VectorizationCache();
+
+		std::string EntryPath(const std::string& imagePath, int simplifyIndex) const;
+		void Trim(const std::string& directory);
+
+		std::atomic<std::uintmax_t> mMaxSize;
+		mutable std::mutex mMutex;
+		VectorizationCacheStats mStats;
+	};
+}
@@ -0,0 +1,431 @@
+#include "VectorizationJob.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <SFML/Graphics.hpp>
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
+#include "level/VectorizationCache.h"
+
+using namespace vle;
+using Vectorizer::Math::Chain;
+using Vectorizer::Math::Point;
+
+namespace
+{
+	// How far from a tile border a point may be and still count as lying on it.
+	const float kSeamTolerance = 1.5f;
+	// How far apart the two halves of a contour may end when they meet at a border.
+	const float kJoinTolerance = 3.f;
+
+	struct Fragment
+	{
+		Chain points;
+		size_t tile;
+	};
+
+	float DistanceSquared(const Point& a, const Point& b)
+	{
+		const float dx = a.x - b.x;
+		const float dy = a.y - b.y;
+		return dx * dx + dy * dy;
+	}
+
+	bool NearSeam(float value, unsigned int tileCount, float tileSize)
+	{
+		const float seam = std::round(value / tileSize);
+		return seam >= 1.f && seam < static_cast<float>(tileCount) && std::fabs(value - seam * tileSize) <= kSeamTolerance;
+	}
+
+	// Cuts a contour into the pieces that do not run along a tile border. Each piece keeps
+	// the border points it starts and ends on, which is where it meets its neighbour tile.
+	void SplitAtSeams(const Chain& chain, size_t tile, unsigned int tilesX, unsigned int tilesY, float tileSize,
+		List<Chain>& untouched, List<Fragment>& fragments)
+	{
+		const bool closed = chain.size() > 2 && DistanceSquared(chain.front(), chain.back()) < 1e-6f;
+		const size_t count = closed ? chain.size() - 1 : chain.size();
+		List<bool> onSeam(count);
+		bool anySeam = false;
+		bool allSeam = true;
+		for (size_t i = 0; i < count; i++)
+		{
+			onSeam[i] = NearSeam(chain[i].x, tilesX, tileSize) || NearSeam(chain[i].y, tilesY, tileSize);
+			anySeam = anySeam || onSeam[i];
+			allSeam = allSeam && onSeam[i];
+		}
+		if (!anySeam)
+		{
+			untouched.push_back(chain);
+			return;
+		}
+		if (allSeam)
+		{
+			// Only the outline of the tile itself: the shape continues in the neighbours.
+			return;
+		}
+
+		// Closed contours are walked starting right after a border point, so no piece wraps around.
+		size_t start = 0;
+		if (closed)
+		{
+			while (!onSeam[start])
+			{
+				start++;
+			}
+			start = (start + 1) % count;
+		}
+		Fragment current{ {}, tile };
+		auto flush = [&fragments, &current]()
+			{
+				if (current.points.size() >= 2)
+				{
+					fragments.push_back(current);
+				}
+				current.points.clear();
+			};
+		const size_t steps = closed ? count + 1 : count;
+		for (size_t step = 0; step < steps; step++)
+		{
+			const size_t i = (start + step) % count;
+			if (!onSeam[i])
+			{
+				if (current.points.empty() && step > 0)
+				{
+					const size_t previous = (i + count - 1) % count;
+					if (onSeam[previous])
+					{
+						current.points.push_back(chain[previous]);
+					}
+				}
+				current.points.push_back(chain[i]);
+			}
+			else if (!current.points.empty())
+			{
+				current.points.push_back(chain[i]);
+				flush();
+			}
+		}
+		flush();
+	}
+}
+
+VectorizationJob::VectorizationJob(const std::string& imagePath, int simplifyIndex, unsigned int tileSize)
+	: mImagePath{ imagePath },
+	mSimplifyIndex{ simplifyIndex },
+	mTileSize{ std::max(tileSize, 64u) },
+	mCancelled{ false },
+	mFinished{ false },
+	mCacheHit{ false },
+	mTilesDone{ 0 },
+	mTileCount{ 1 }
+{
+	mThread = std::thread(&VectorizationJob::Run, this);
+}
+
+VectorizationJob::~VectorizationJob()
+{
+	Cancel();
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+}
+
+void VectorizationJob::Cancel()
+{
+	mCancelled = true;
+}
+
+float VectorizationJob::GetProgress() const
+{
+	if (mFinished)
+	{
+		return 1.f;
+	}
+	// The last few percent are left for stitching.
+	return 0.95f * static_cast<float>(mTilesDone) / static_cast<float>(std::max(1u, mTileCount.load()));
+}
+
+std::optional<List<Chain>> VectorizationJob::TakeResult()
+{
+	std::lock_guard<std::mutex> lock(mResultMutex);
+	std::optional<List<Chain>> result = std::move(mResult);
+	mResult.reset();
+	return result;
+}
+
+std::string VectorizationJob::GetError() const
+{
+	std::lock_guard<std::mutex> lock(mResultMutex);
+	return mError;
+}
+
+void VectorizationJob::Run()
+{
+	Profiler::SetThreadName("Vectorization");
+	std::optional<List<Chain>> result;
+	std::string error;
+	try
+	{
+		VectorizationCache& cache = VectorizationCache::Get();
+		result = cache.Load(mImagePath, mSimplifyIndex);
+		mCacheHit = result.has_value();
+		if (!mCacheHit)
+		{
+			List<Chain> chains = TraceTiled(mImagePath, mTileSize);
+			if (!mCancelled)
+			{
+				cache.Store(mImagePath, mSimplifyIndex, chains);
+				result = std::move(chains);
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		error = e.what();
+	}
+	{
+		std::lock_guard<std::mutex> lock(mResultMutex);
+		mResult = std::move(result);
+		mError = std::move(error);
+	}
+	mFinished = true;
+}
+
+List<Chain> VectorizationJob::TraceTiled(const std::string& imagePath, unsigned int tileSize)
+{
+	PROFILE_FUNCTION();
+	namespace fs = std::filesystem;
+	sf::Image image;
+	if (!image.loadFromFile(imagePath))
+	{
+		throw std::runtime_error("cannot read hitbox image " + imagePath);
+	}
+	const sf::Vector2u size = image.getSize();
+	const unsigned int tilesX = (size.x + tileSize - 1) / tileSize;
+	const unsigned int tilesY = (size.y + tileSize - 1) / tileSize;
+	if (tilesX <= 1 && tilesY <= 1)
+	{
+		List<Chain> chains = Vectorizer::vectorizeImage(imagePath, mSimplifyIndex);
+		mTilesDone = 1;
+		return chains;
+	}
+	mTileCount = tilesX * tilesY;
+
+	// The vectorizer only reads files, so every tile goes through a temporary PNG.
+	const fs::path tileDirectory = fs::temp_directory_path() /
+		("vle-tiles-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+	fs::create_directories(tileDirectory);
+
+	List<List<Chain>> tileChains(tilesX * tilesY);
+	{
+		ThreadPool pool;
+		List<std::future<void>> tiles;
+		tiles.reserve(tileChains.size());
+		for (unsigned int tileY = 0; tileY < tilesY; tileY++)
+		{
+			for (unsigned int tileX = 0; tileX < tilesX; tileX++)
+			{
+				tiles.push_back(pool.Enqueue([this, &image, &tileChains, &tileDirectory, tileX, tileY, tilesX, tileSize, size]()
+					{
+						if (mCancelled)
+						{
+							return;
+						}
+						PROFILE_ZONE("Vectorize tile");
+						const sf::Vector2u origin{ tileX * tileSize, tileY * tileSize };
+						const sf::Vector2u tileExtent{ std::min(tileSize, size.x - origin.x), std::min(tileSize, size.y - origin.y) };
+						sf::Image tile(tileExtent);
+						(void)tile.copy(image, { 0, 0 }, sf::IntRect(sf::Vector2i(origin), sf::Vector2i(tileExtent)));
+						const fs::path tilePath = tileDirectory / ("tile_" + std::to_string(tileX) + "_" + std::to_string(tileY) + ".png");
+						if (!tile.saveToFile(tilePath))
+						{
+							throw std::runtime_error("cannot write temporary tile " + tilePath.string());
+						}
+						List<Chain> chains = Vectorizer::vectorizeImage(tilePath.string(), mSimplifyIndex);
+						std::error_code ignored;
+						fs::remove(tilePath, ignored);
+						for (Chain& chain : chains)
+						{
+							for (Point& point : chain)
+							{
+								point.x += static_cast<float>(origin.x);
+								point.y += static_cast<float>(origin.y);
+							}
+						}
+						tileChains[tileY * tilesX + tileX] = std::move(chains);
+						mTilesDone++;
+					}));
+			}
+		}
+		std::exception_ptr failure;
+		for (std::future<void>& tile : tiles)
+		{
+			try
+			{
+				tile.get();
+			}
+			catch (...)
+			{
+				mCancelled = true;
+				failure = std::current_exception();
+			}
+		}
+		std::error_code ignored;
+		fs::remove_all(tileDirectory, ignored);
+		if (failure)
+		{
+			std::rethrow_exception(failure);
+		}
+	}
+	if (mCancelled)
+	{
+		return {};
+	}
+	return stitchTileChains(tileChains, tilesX, tilesY, static_cast<float>(tileSize));
+}
+
+List<Chain> vle::stitchTileChains(const List<List<Chain>>& tileChains, unsigned int tilesX, unsigned int tilesY, float tileSize)
+{
+	List<Chain> result;
+	List<Fragment> fragments;
+	for (size_t tile = 0; tile < tileChains.size(); tile++)
+	{
+		for (const Chain& chain : tileChains[tile])
+		{
+			SplitAtSeams(chain, tile, tilesX, tilesY, tileSize, result, fragments);
+		}
+	}
+
+	// Pair fragment ends from different tiles, closest pairs first.
+	// End e belongs to fragment e / 2; even ends are starts, odd ends are ends.
+	const float joinSquared = kJoinTolerance * kJoinTolerance;
+	auto endPoint = [&fragments](size_t end) -> const Point&
+		{
+			const Chain& points = fragments[end / 2].points;
+			return end % 2 == 0 ? points.front() : points.back();
+		};
+	auto cellOf = [](const Point& point)
+		{
+			return std::make_pair(static_cast<int>(std::floor(point.x / kJoinTolerance)), static_cast<int>(std::floor(point.y / kJoinTolerance)));
+		};
+	Map<std::pair<int, int>, List<size_t>> endCells;
+	for (size_t end = 0; end < fragments.size() * 2; end++)
+	{
+		endCells[cellOf(endPoint(end))].push_back(end);
+	}
+	struct Candidate
+	{
+		float distanceSquared;
+		size_t a;
+		size_t b;
+	};
+	List<Candidate> candidates;
+	for (size_t end = 0; end < fragments.size() * 2; end++)
+	{
+		const std::pair<int, int> cell = cellOf(endPoint(end));
+		for (int dy = -1; dy <= 1; dy++)
+		{
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				auto found = endCells.find({ cell.first + dx, cell.second + dy });
+				if (found == endCells.end())
+				{
+					continue;
+				}
+				for (size_t other : found->second)
+				{
+					if (other <= end || fragments[other / 2].tile == fragments[end / 2].tile)
+					{
+						continue;
+					}
+					const float distanceSquared = DistanceSquared(endPoint(end), endPoint(other));
+					if (distanceSquared <= joinSquared)
+					{
+						candidates.push_back(Candidate{ distanceSquared, end, other });
+					}
+				}
+			}
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.distanceSquared < b.distanceSquared; });
+	const size_t unmatched = static_cast<size_t>(-1);
+	List<size_t> partner(fragments.size() * 2, unmatched);
+	for (const Candidate& candidate : candidates)
+	{
+		if (partner[candidate.a] == unmatched && partner[candidate.b] == unmatched)
+		{
+			partner[candidate.a] = candidate.b;
+			partner[candidate.b] = candidate.a;
+		}
+	}
+
+	// Walk the joined fragments. Open contours are started from a free end first,
+	// the rest are loops and come back to where they started.
+	List<bool> visited(fragments.size(), false);
+	auto walk = [&](size_t first, bool forward)
+		{
+			Chain chain;
+			size_t current = first;
+			while (true)
+			{
+				visited[current] = true;
+				const Chain& points = fragments[current].points;
+				const size_t skip = chain.empty() ? 0 : 1;
+				if (forward)
+				{
+					chain.insert(chain.end(), points.begin() + skip, points.end());
+				}
+				else
+				{
+					chain.insert(chain.end(), points.rbegin() + skip, points.rend());
+				}
+				const size_t exitEnd = current * 2 + (forward ? 1 : 0);
+				const size_t next = partner[exitEnd];
+				if (next == unmatched)
+				{
+					break;
+				}
+				if (visited[next / 2])
+				{
+					if (next / 2 == first)
+					{
+						chain.push_back(chain.front());
+					}
+					break;
+				}
+				current = next / 2;
+				forward = next % 2 == 0;
+			}
+			if (chain.size() >= 2)
+			{
+				result.push_back(std::move(chain));
+			}
+		};
+	for (size_t i = 0; i < fragments.size(); i++)
+	{
+		if (visited[i])
+		{
+			continue;
+		}
+		if (partner[i * 2] == unmatched)
+		{
+			walk(i, true);
+		}
+		else if (partner[i * 2 + 1] == unmatched)
+		{
+			walk(i, false);
+		}
+	}
+	for (size_t i = 0; i < fragments.size(); i++)
+	{
+		if (!visited[i])
+		{
+			walk(i, true);
+		}
+	}
+	return result;
+}
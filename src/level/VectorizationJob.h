@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include "Vectorizer/Vectorizer.h"
+#include "core/Utils.h"
+
+namespace vle {
+	// Traces a hitbox image on a background thread, going through the VectorizationCache first.
+	// Images larger than one tile are cut into tiles that are traced on all cores;
+	// the contours are then stitched back together where they cross tile borders,
+	// dropping the artificial edges the cuts introduced.
+	class VectorizationJob
+	{
+	public:
+		VectorizationJob(const std::string& imagePath, int simplifyIndex, unsigned int tileSize = kDefaultTileSize);
+		// Cancels and waits for the tile currently being traced.
+		~VectorizationJob();
+
+		VectorizationJob(const VectorizationJob&) = delete;
+		VectorizationJob& operator=(const VectorizationJob&) = delete;
+
+		// Tiles already being traced still finish; the job ends without a result.
+		void Cancel();
+		bool IsCancelled() const { return mCancelled; }
+		bool IsFinished() const { return mFinished; }
+		float GetProgress() const;
+		// Set once the job has finished; empty when it was cancelled or failed.
+		std::optional<List<Vectorizer::Math::Chain>> TakeResult();
+		std::string GetError() const;
+		bool IsCacheHit() const { return mCacheHit; }
+
+		static constexpr unsigned int kDefaultTileSize = 1024;
+
+	private:
+		void Run();
+		List<Vectorizer::Math::Chain> TraceTiled(const std::string& imagePath, unsigned int tileSize);
+
+		std::string mImagePath;
+		int mSimplifyIndex;
+		unsigned int mTileSize;
+		std::atomic<bool> mCancelled;
+		std::atomic<bool> mFinished;
+		std::atomic<bool> mCacheHit;
+		std::atomic<unsigned int> mTilesDone;
+		std::atomic<unsigned int> mTileCount;
+		mutable std::mutex mResultMutex;
+		std::optional<List<Vectorizer::Math::Chain>> mResult;
+		std::string mError;
+		std::thread mThread;
+	};
+
+	// Joins contours traced on separate tiles of one image. Exposed for tools that trace tiles themselves.
+	List<Vectorizer::Math::Chain> stitchTileChains(const List<List<Vectorizer::Math::Chain>>& tileChains, unsigned int tilesX, unsigned int tilesY, float tileSize);
+}
@@ -1,4 +1,10 @@
 #include "AssetManager.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "core/Hash.h"
+#include "core/Profiler.h"
 
 using namespace vle;
 
@@ -13,41 +19,700 @@ AssetManager& AssetManager::Get()
 	return *assetManager;
 }
 
-bool AssetManager::LoadTexture(const std::string& name,const std::string& path)
+AssetManager::AssetManager() :
+	mTextureBytes{0},
+	mMemoryBudget{kDefaultMemoryBudget},
+	mFrame{0},
+	mHits{0},
+	mMisses{0},
+	mEvictions{0},
+	mSharedByPath{0},
+	mSharedByContent{0}
 {
-	if (mLoadedTextures.count(name))
+	// Leave one core to the UI thread, which does the uploads.
+	unsigned int cores = std::thread::hardware_concurrency();
+	mDecodePool = std::make_unique<ThreadPool>(cores > 1 ? cores - 1 : 1);
+}
+
+bool AssetManager::LoadTexture(const std::string& name,const std::string& path, bool packIntoAtlas)
+{
+	if (MapName(name, path, packIntoAtlas))
 	{
-		return false;
+		const std::string key = *FindKey(name);
+		List<std::string> finished;
+		FinishDecode(key, Decode(key), finished);
+	}
+	return GetTextureStatus(name) == TextureStatus::Ready;
+}
+
+bool AssetManager::LoadTextureAsync(const std::string& name, const std::string& path, bool packIntoAtlas)
+{
+	if (MapName(name, path, packIntoAtlas))
+	{
+		StartDecode(*FindKey(name));
+	}
+	const TextureStatus status = GetTextureStatus(name);
+	return status == TextureStatus::Pending || status == TextureStatus::Ready;
+}
+
+List<std::string> AssetManager::ProcessPendingUploads(sf::Time budget)
+{
+	List<std::string> finished;
+	sf::Clock uploadClock;
+	for (auto it = mPendingTextures.begin(); it != mPendingTextures.end();)
+	{
+		if (!finished.empty() && uploadClock.getElapsedTime() >= budget)
+		{
+			break;
+		}
+		if (it->image.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+		const std::string key = std::move(it->key);
+		std::optional<DecodedImage> decoded = it->image.get();
+		it = mPendingTextures.erase(it);
+		FinishDecode(key, std::move(decoded), finished);
 	}
-	auto newTexture = std::make_unique<sf::Texture>();
-	if (newTexture->loadFromFile(path))
+	for (const std::string& moved : mAtlas.TakeMovedRegions())
 	{
-		mLoadedTextures[name] = std::move(newTexture);
-		return true;
+		auto found = mTextures.find(moved);
+		if (found == mTextures.end())
+		{
+			continue;
+		}
+		for (const std::string& name : found->second.names)
+		{
+			if (std::find(finished.begin(), finished.end(), name) == finished.end())
+			{
+				finished.push_back(name);
+			}
+		}
 	}
-	return false;
+	return finished;
+}
+
+bool AssetManager::HasPendingTextures() const
+{
+	return !mPendingTextures.empty();
+}
+
+TextureStatus AssetManager::GetTextureStatus(const std::string& name) const
+{
+	const TextureEntry* entry = FindEntry(name);
+	return entry ? entry->status : TextureStatus::Missing;
 }
 
 const sf::Texture* AssetManager::GetTexture(const std::string& name) const
 {
-	auto found = mLoadedTextures.find(name);
-	if (found != mLoadedTextures.end())
+	const TextureEntry* entry = FindEntry(name);
+	return entry ? entry->texture.get() : nullptr;
+}
+
+const AtlasRegion* AssetManager::GetAtlasRegion(const std::string& name) const
+{
+	const std::string* key = FindKey(name);
+	return key ? mAtlas.GetRegion(*key) : nullptr;
+}
+
+const sf::Texture* AssetManager::GetTextureRegion(const std::string& name, sf::IntRect& rect) const
+{
+	if (const AtlasRegion* region = GetAtlasRegion(name))
+	{
+		rect = region->rect;
+		return &mAtlas.GetPage(region->page);
+	}
+	if (const sf::Texture* texture = GetTexture(name))
 	{
-		return found->second.get();
+		rect = sf::IntRect({ 0, 0 }, sf::Vector2i(texture->getSize()));
+		return texture;
 	}
 	return nullptr;
 }
 
+TextureStatus AssetManager::GetTextureStatus(AssetIndex asset) const
+{
+	return asset < mSlots.size() ? mSlots[asset].status : TextureStatus::Missing;
+}
+
+const sf::Texture* AssetManager::GetTexture(AssetIndex asset) const
+{
+	return asset < mSlots.size() ? mSlots[asset].texture : nullptr;
+}
+
+const sf::Texture* AssetManager::GetTextureRegion(AssetIndex asset, sf::IntRect& rect) const
+{
+	if (asset >= mSlots.size())
+	{
+		return nullptr;
+	}
+	const TextureSlot& slot = mSlots[asset];
+	if (slot.region)
+	{
+		rect = slot.region->rect;
+		return &mAtlas.GetPage(slot.region->page);
+	}
+	if (slot.texture)
+	{
+		rect = sf::IntRect({ 0, 0 }, sf::Vector2i(slot.texture->getSize()));
+	}
+	return slot.texture;
+}
+
+bool AssetManager::BindTexture(sf::Sprite& sprite, const std::string& name) const
+{
+	sf::IntRect rect;
+	const sf::Texture* texture = GetTextureRegion(name, rect);
+	if (!texture)
+	{
+		return false;
+	}
+	sprite.setTexture(*texture);
+	sprite.setTextureRect(rect);
+	sprite.setOrigin(sprite.getLocalBounds().size / 2.f);
+	return true;
+}
+
+bool AssetManager::BindTexture(GameObjectStore& objects, size_t index) const
+{
+	sf::IntRect rect;
+	if (!GetTextureRegion(objects.GetAssets()[index], rect))
+	{
+		return false;
+	}
+	const sf::Vector2f size(rect.size);
+	objects.SetSize(index, size);
+	objects.SetOrigin(index, size / 2.f);
+	return true;
+}
+
+Map<std::string, std::string> AssetManager::GetAtlasRegionNames() const
+{
+	Map<std::string, std::string> names;
+	for (const auto& pair : mTextureKeys)
+	{
+		if (mAtlas.GetRegion(pair.second))
+		{
+			names[pair.first] = pair.second;
+		}
+	}
+	return names;
+}
+
+TextureDedupStats AssetManager::GetDedupStats() const
+{
+	TextureDedupStats stats;
+	stats.names = mTextureKeys.size();
+	stats.textures = mTextures.size();
+	stats.sharedByPath = mSharedByPath;
+	stats.sharedByContent = mSharedByContent;
+	for (const auto& pair : mTextures)
+	{
+		const TextureEntry& entry = pair.second;
+		if (entry.status != TextureStatus::Ready || entry.names.size() < 2)
+		{
+			continue;
+		}
+		std::uint64_t bytes = entry.bytes;
+		if (const AtlasRegion* region = mAtlas.GetRegion(pair.first))
+		{
+			bytes = std::uint64_t(region->rect.size.x) * region->rect.size.y * 4;
+		}
+		stats.savedBytes += (entry.names.size() - 1) * bytes;
+	}
+	return stats;
+}
+
 bool AssetManager::RemoveTexture(const std::string& name)
 {
-	return mLoadedTextures.erase(name) > 0;
+	if (!FindKey(name))
+	{
+		return false;
+	}
+	UnmapName(name);
+	return true;
 }
 
 bool AssetManager::Clear()
 {
-	for (auto it = mLoadedTextures.begin(); it!=mLoadedTextures.end();)
+	// Decodes still running finish on their worker and their results are dropped.
+	mPendingTextures.clear();
+	mTextures.clear();
+	mTextureKeys.clear();
+	mPathAliases.clear();
+	mContentKeys.clear();
+	mAtlas.Clear();
+	// Handles outlive a project, so the references stay with their slots.
+	for (TextureSlot& slot : mSlots)
 	{
-		it = mLoadedTextures.erase(it);
+		const std::uint32_t references = slot.references;
+		slot = TextureSlot{};
+		slot.references = references;
 	}
+	mTextureBytes = 0;
+	mSharedByPath = 0;
+	mSharedByContent = 0;
 	return true;
-}
\ No newline at end of file
+}
+
+void AssetManager::Touch(AssetIndex asset)
+{
+	TextureSlot& slot = GetSlot(asset);
+	slot.lastUsed = mFrame;
+	if (slot.status == TextureStatus::Ready)
+	{
+		++mHits;
+	}
+	else if (slot.status == TextureStatus::Evicted)
+	{
+		++mMisses;
+		StartDecode(*FindKey(NameTable::Assets().GetName(asset)));
+	}
+}
+
+TextureHandle AssetManager::Acquire(AssetIndex asset)
+{
+	Touch(asset);
+	return TextureHandle{ asset };
+}
+
+List<std::string> AssetManager::Trim()
+{
+	++mFrame;
+	List<std::string> evicted;
+	std::uint64_t resident = mTextureBytes + GetAtlasBytes();
+	if (resident <= mMemoryBudget)
+	{
+		return evicted;
+	}
+	struct PageUsage
+	{
+		std::uint64_t lastUsed = 0;
+		bool kept = false;
+	};
+	// A standalone texture, or an atlas page when key is null.
+	struct Candidate
+	{
+		std::uint64_t lastUsed;
+		std::uint64_t bytes;
+		const std::string* key;
+		size_t page;
+	};
+	List<PageUsage> pages(mAtlas.GetPageCount());
+	List<Candidate> candidates;
+	for (const auto& pair : mTextures)
+	{
+		const TextureEntry& entry = pair.second;
+		// Every name of an entry shares its region.
+		const AtlasRegion* region = entry.assets.empty() ? nullptr : mSlots[entry.assets.front()].region;
+		if (!entry.texture && !region)
+		{
+			continue;
+		}
+		std::uint64_t lastUsed;
+		bool pinned;
+		GetUsage(entry, lastUsed, pinned);
+		const bool kept = pinned || lastUsed + 1 >= mFrame;
+		if (region)
+		{
+			PageUsage& page = pages[region->page];
+			page.lastUsed = std::max(page.lastUsed, lastUsed);
+			page.kept = page.kept || kept;
+		}
+		else if (!kept)
+		{
+			candidates.push_back(Candidate{ lastUsed, entry.bytes, &pair.first, 0 });
+		}
+	}
+	for (size_t i = 0; i < pages.size(); ++i)
+	{
+		if (!pages[i].kept)
+		{
+			const sf::Vector2u size = mAtlas.GetPage(i).getSize();
+			candidates.push_back(Candidate{ pages[i].lastUsed, std::uint64_t(size.x) * size.y * 4, nullptr, i });
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+		{
+			return a.lastUsed < b.lastUsed;
+		});
+	List<size_t> droppedPages;
+	for (const Candidate& candidate : candidates)
+	{
+		if (resident <= mMemoryBudget)
+		{
+			break;
+		}
+		resident -= candidate.bytes;
+		if (candidate.key)
+		{
+			Evict(*candidate.key, evicted);
+		}
+		else
+		{
+			droppedPages.push_back(candidate.page);
+		}
+	}
+	// Dropping a page renumbers the ones after it, so the highest goes first.
+	std::sort(droppedPages.rbegin(), droppedPages.rend());
+	for (size_t page : droppedPages)
+	{
+		for (const std::string& key : mAtlas.RemovePage(page))
+		{
+			Evict(key, evicted);
+		}
+	}
+	return evicted;
+}
+
+void AssetManager::LoadAllTextures()
+{
+	List<std::string> keys;
+	for (const auto& pair : mTextures)
+	{
+		if (pair.second.status == TextureStatus::Evicted || pair.second.status == TextureStatus::Pending)
+		{
+			keys.push_back(pair.first);
+		}
+	}
+	// A decode still running for one of them finds it Ready and is dropped.
+	List<std::string> finished;
+	for (const std::string& key : keys)
+	{
+		FinishDecode(key, Decode(key), finished);
+	}
+}
+
+TextureMemoryStats AssetManager::GetMemoryStats() const
+{
+	TextureMemoryStats stats;
+	stats.textureBytes = mTextureBytes;
+	stats.atlasBytes = GetAtlasBytes();
+	stats.budget = mMemoryBudget;
+	for (const auto& pair : mTextures)
+	{
+		if (!pair.second.texture)
+		{
+			continue;
+		}
+		std::uint64_t lastUsed;
+		bool pinned;
+		GetUsage(pair.second, lastUsed, pinned);
+		++stats.residentTextures;
+		stats.pinnedTextures += pinned ? 1 : 0;
+	}
+	stats.hits = mHits;
+	stats.misses = mMisses;
+	stats.evictions = mEvictions;
+	return stats;
+}
+
+std::optional<AssetManager::DecodedImage> AssetManager::Decode(const std::string& path)
+{
+	PROFILE_ZONE("Decode texture");
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		return std::nullopt;
+	}
+	List<char> bytes(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	if (bytes.empty() || !file.read(bytes.data(), bytes.size()))
+	{
+		return std::nullopt;
+	}
+	DecodedImage decoded;
+	decoded.contentHash = Fnv1a(bytes.data(), bytes.size());
+	if (!decoded.image.loadFromMemory(bytes.data(), bytes.size()))
+	{
+		return std::nullopt;
+	}
+	return decoded;
+}
+
+std::string AssetManager::ResolveKey(const std::string& path) const
+{
+	namespace fs = std::filesystem;
+	std::error_code error;
+	fs::path canonical = fs::weakly_canonical(path, error);
+	const std::string key = error ? fs::path(path).lexically_normal().string() : canonical.string();
+	auto alias = mPathAliases.find(key);
+	return alias != mPathAliases.end() ? alias->second : key;
+}
+
+const std::string* AssetManager::FindKey(const std::string& name) const
+{
+	auto found = mTextureKeys.find(name);
+	return found != mTextureKeys.end() ? &found->second : nullptr;
+}
+
+const AssetManager::TextureEntry* AssetManager::FindEntry(const std::string& name) const
+{
+	const std::string* key = FindKey(name);
+	if (!key)
+	{
+		return nullptr;
+	}
+	auto found = mTextures.find(*key);
+	return found != mTextures.end() ? &found->second : nullptr;
+}
+
+bool AssetManager::MapName(const std::string& name, const std::string& path, bool packIntoAtlas)
+{
+	const std::string key = ResolveKey(path);
+	const std::string* current = FindKey(name);
+	if (current && *current != key)
+	{
+		UnmapName(name);
+		current = nullptr;
+	}
+	auto [found, created] = mTextures.try_emplace(key);
+	TextureEntry& entry = found->second;
+	if (created)
+	{
+		entry.packIntoAtlas = packIntoAtlas;
+	}
+	if (!current)
+	{
+		if (!entry.names.empty() && entry.status != TextureStatus::Failed)
+		{
+			++mSharedByPath;
+		}
+		entry.names.push_back(name);
+		entry.assets.push_back(NameTable::Assets().Intern(name));
+		mTextureKeys[name] = key;
+		SyncSlot(name);
+	}
+	return entry.status == TextureStatus::Missing || entry.status == TextureStatus::Failed || entry.status == TextureStatus::Evicted;
+}
+
+void AssetManager::UnmapName(const std::string& name)
+{
+	auto mapped = mTextureKeys.find(name);
+	if (mapped == mTextureKeys.end())
+	{
+		return;
+	}
+	const std::string key = std::move(mapped->second);
+	mTextureKeys.erase(mapped);
+	auto found = mTextures.find(key);
+	if (found != mTextures.end())
+	{
+		List<std::string>& names = found->second.names;
+		List<AssetIndex>& assets = found->second.assets;
+		names.erase(std::remove(names.begin(), names.end(), name), names.end());
+		assets.erase(std::remove(assets.begin(), assets.end(), NameTable::Assets().Intern(name)), assets.end());
+		if (names.empty())
+		{
+			EraseEntry(key);
+		}
+	}
+	SyncSlot(name);
+}
+
+void AssetManager::StartDecode(const std::string& key)
+{
+	TextureEntry& entry = mTextures.at(key);
+	if (entry.status == TextureStatus::Pending)
+	{
+		return;
+	}
+	PendingTexture pending;
+	pending.key = key;
+	pending.image = mDecodePool->Enqueue([key]()
+		{
+			return Decode(key);
+		});
+	mPendingTextures.push_back(std::move(pending));
+	entry.status = TextureStatus::Pending;
+	SyncEntry(key);
+}
+
+void AssetManager::FinishDecode(const std::string& decodedKey, std::optional<DecodedImage> decoded, List<std::string>& finished)
+{
+	auto found = mTextures.find(decodedKey);
+	if (found == mTextures.end())
+	{
+		return;
+	}
+	std::string key = decodedKey;
+	if (decoded.has_value())
+	{
+		auto same = mContentKeys.find(decoded->contentHash);
+		if (same != mContentKeys.end() && same->second != key)
+		{
+			// A copy of a file already loaded: its names move over to that texture.
+			const std::string sharedKey = same->second;
+			TextureEntry& shared = mTextures.at(sharedKey);
+			for (const std::string& name : found->second.names)
+			{
+				mTextureKeys[name] = sharedKey;
+				shared.names.push_back(name);
+			}
+			shared.assets.insert(shared.assets.end(), found->second.assets.begin(), found->second.assets.end());
+			mSharedByContent += found->second.names.size();
+			mPathAliases[key] = sharedKey;
+			mTextures.erase(found);
+			key = sharedKey;
+			found = mTextures.find(key);
+		}
+	}
+	TextureEntry& entry = found->second;
+	if (entry.status != TextureStatus::Ready)
+	{
+		auto newTexture = std::make_unique<sf::Texture>();
+		if (decoded.has_value() && newTexture->loadFromImage(decoded->image))
+		{
+			// Packed sprites sample the atlas only, so the standalone copy is dropped;
+			// one too large for a page stays standalone.
+			if (!entry.packIntoAtlas || !mAtlas.Insert(key, *newTexture))
+			{
+				entry.texture = std::move(newTexture);
+			}
+			entry.status = TextureStatus::Ready;
+			entry.contentHash = decoded->contentHash;
+			mContentKeys[entry.contentHash] = key;
+		}
+		else
+		{
+			entry.status = TextureStatus::Failed;
+		}
+	}
+	SyncEntry(key);
+	finished.insert(finished.end(), entry.names.begin(), entry.names.end());
+}
+
+void AssetManager::EraseEntry(const std::string& key)
+{
+	auto found = mTextures.find(key);
+	if (found == mTextures.end())
+	{
+		return;
+	}
+	mAtlas.Remove(key);
+	mPendingTextures.erase(std::remove_if(mPendingTextures.begin(), mPendingTextures.end(),
+		[&key](const PendingTexture& pending) { return pending.key == key; }), mPendingTextures.end());
+	auto content = mContentKeys.find(found->second.contentHash);
+	if (content != mContentKeys.end() && content->second == key)
+	{
+		mContentKeys.erase(content);
+	}
+	for (auto alias = mPathAliases.begin(); alias != mPathAliases.end();)
+	{
+		alias = alias->second == key ? mPathAliases.erase(alias) : std::next(alias);
+	}
+	mTextureBytes -= found->second.bytes;
+	mTextures.erase(found);
+}
+
+void AssetManager::SyncEntry(const std::string& key)
+{
+	TextureEntry& entry = mTextures.at(key);
+	mTextureBytes -= entry.bytes;
+	entry.bytes = entry.texture ? std::uint64_t(entry.texture->getSize().x) * entry.texture->getSize().y * 4 : 0;
+	mTextureBytes += entry.bytes;
+	for (const std::string& name : entry.names)
+	{
+		SyncSlot(name);
+	}
+}
+
+void AssetManager::SyncSlot(const std::string& name)
+{
+	TextureSlot& slot = GetSlot(NameTable::Assets().Intern(name));
+	const std::string* key = FindKey(name);
+	const TextureEntry* entry = FindEntry(name);
+	slot.status = entry ? entry->status : TextureStatus::Missing;
+	slot.texture = entry ? entry->texture.get() : nullptr;
+	slot.region = key ? mAtlas.GetRegion(*key) : nullptr;
+}
+
+AssetManager::TextureSlot& AssetManager::GetSlot(AssetIndex asset)
+{
+	if (asset >= mSlots.size())
+	{
+		mSlots.resize(asset + 1);
+	}
+	return mSlots[asset];
+}
+
+void AssetManager::GetUsage(const TextureEntry& entry, std::uint64_t& lastUsed, bool& pinned) const
+{
+	lastUsed = 0;
+	pinned = false;
+	for (AssetIndex asset : entry.assets)
+	{
+		if (asset < mSlots.size())
+		{
+			lastUsed = std::max(lastUsed, mSlots[asset].lastUsed);
+			pinned = pinned || mSlots[asset].references > 0;
+		}
+	}
+}
+
+void AssetManager::Evict(const std::string& key, List<std::string>& evicted)
+{
+	TextureEntry& entry = mTextures.at(key);
+	entry.texture.reset();
+	entry.status = TextureStatus::Evicted;
+	SyncEntry(key);
+	++mEvictions;
+	evicted.insert(evicted.end(), entry.names.begin(), entry.names.end());
+}
+
+std::uint64_t AssetManager::GetAtlasBytes() const
+{
+	std::uint64_t bytes = 0;
+	for (size_t i = 0; i < mAtlas.GetPageCount(); ++i)
+	{
+		const sf::Vector2u size = mAtlas.GetPage(i).getSize();
+		bytes += std::uint64_t(size.x) * size.y * 4;
+	}
+	return bytes;
+}
+
+void AssetManager::AddReference(AssetIndex asset)
+{
+	++GetSlot(asset).references;
+}
+
+void AssetManager::ReleaseReference(AssetIndex asset)
+{
+	--GetSlot(asset).references;
+}
+
+TextureHandle::TextureHandle(AssetIndex asset) :
+	mAsset{asset}
+{
+	AssetManager::Get().AddReference(mAsset);
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other) :
+	mAsset{other.mAsset}
+{
+	if (!IsNull())
+	{
+		AssetManager::Get().AddReference(mAsset);
+	}
+}
+
+TextureHandle::TextureHandle(TextureHandle&& other) noexcept :
+	mAsset{other.mAsset}
+{
+	other.mAsset = kNone;
+}
+
+TextureHandle& TextureHandle::operator=(TextureHandle other) noexcept
+{
+	std::swap(mAsset, other.mAsset);
+	return *this;
+}
+
+TextureHandle::~TextureHandle()
+{
+	if (!IsNull())
+	{
+		AssetManager::Get().ReleaseReference(mAsset);
+	}
+}
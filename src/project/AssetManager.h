@@ -1,10 +1,81 @@
 #pragma once
+#include <cstdint>
+#include <future>
 #include <iostream>
+#include <optional>
 #include <SFML/Graphics.hpp>
+#include "core/NameTable.h"
+#include "core/ThreadPool.h"
 #include "core/Utils.h"
+#include "level/GameObjectStore.h"
 #include "project/Asset.h"
+#include "project/TextureAtlas.h"
 
 namespace vle {
+	enum class TextureStatus
+	{
+		Missing,	// never requested, or dropped by Clear/RemoveTexture
+		Pending,	// decoding on a worker or waiting for its GPU upload
+		Ready,
+		Failed,
+		Evicted		// released to fit the memory budget; loaded again when next used
+	};
+
+	struct TextureMemoryStats
+	{
+		// Standalone textures of assets that are not packed.
+		std::uint64_t textureBytes = 0;
+		// Atlas pages, the only copy of packed textures.
+		std::uint64_t atlasBytes = 0;
+		std::uint64_t budget = 0;
+		size_t residentTextures = 0;
+		size_t pinnedTextures = 0;
+		// Uses of a texture that was resident, and that had to be loaded again.
+		unsigned long long hits = 0;
+		unsigned long long misses = 0;
+		unsigned long long evictions = 0;
+	};
+
+	// What loading several assets from one image file saved.
+	struct TextureDedupStats
+	{
+		size_t names = 0;
+		size_t textures = 0;
+		// Names that found their file already loaded or loading, which cost no decode.
+		size_t sharedByPath = 0;
+		// Names whose file was a copy of one already loaded under another path, found
+		// after the decode, which cost no upload.
+		size_t sharedByContent = 0;
+		// Texture and atlas memory the shared textures would otherwise take.
+		std::uint64_t savedBytes = 0;
+	};
+
+	// Keeps the texture of an asset resident: while any copy of a handle exists the
+	// texture is never evicted, whatever the budget.
+	class TextureHandle
+	{
+	public:
+		TextureHandle() = default;
+		TextureHandle(const TextureHandle& other);
+		TextureHandle(TextureHandle&& other) noexcept;
+		TextureHandle& operator=(TextureHandle other) noexcept;
+		~TextureHandle();
+
+		bool IsNull() const { return mAsset == kNone; }
+		AssetIndex GetAsset() const { return mAsset; }
+
+	private:
+		friend class AssetManager;
+		static constexpr AssetIndex kNone = ~AssetIndex(0);
+
+		explicit TextureHandle(AssetIndex asset);
+
+		AssetIndex mAsset = kNone;
+	};
+
+	// Textures are stored once per image file: by canonical path, and by content hash
+	// for copies of a file under another path. Asset names map onto those entries, so
+	// assets sharing an image cost one decode and one GPU copy.
 	class AssetManager
 	{
 	public:
@@ -15,14 +86,142 @@ namespace vle {
 		AssetManager(AssetManager&&) = delete;
 		AssetManager& operator=(AssetManager&&) = delete;
 
-		bool LoadTexture(const std::string& name, const std::string& path);
+		// Textures loaded with packIntoAtlas are also copied into the shared atlas. A name
+		// whose file is already loaded shares its texture and returns true at once.
+		bool LoadTexture(const std::string& name, const std::string& path, bool packIntoAtlas = true);
+		// Decodes the image on a worker thread; the texture becomes available once
+		// ProcessPendingUploads has uploaded it on the main thread.
+		bool LoadTextureAsync(const std::string& name, const std::string& path, bool packIntoAtlas = true);
+		// Uploads decoded images until the budget is spent, at least one per call.
+		// Returns the names that became Ready or Failed, or whose atlas region moved.
+		List<std::string> ProcessPendingUploads(sf::Time budget);
+		bool HasPendingTextures() const;
+		TextureStatus GetTextureStatus(const std::string& name) const;
 		const sf::Texture* GetTexture(const std::string& name) const;
+		const AtlasRegion* GetAtlasRegion(const std::string& name) const;
+		// Texture an instance of the asset samples and the rect it samples: the atlas page
+		// and region when the texture is packed, the texture itself otherwise.
+		const sf::Texture* GetTextureRegion(const std::string& name, sf::IntRect& rect) const;
+		// Same lookups by interned name, served from a flat array without hashing;
+		// these are the ones per-object and per-frame code should use.
+		TextureStatus GetTextureStatus(AssetIndex asset) const;
+		const sf::Texture* GetTexture(AssetIndex asset) const;
+		const sf::Texture* GetTextureRegion(AssetIndex asset, sf::IntRect& rect) const;
+		// Points the sprite at the texture's region and centers its origin.
+		bool BindTexture(sf::Sprite& sprite, const std::string& name) const;
+		// Same for a stored game object, which samples the region of its own asset.
+		bool BindTexture(GameObjectStore& objects, size_t index) const;
+		// Regions are keyed by texture, not by name; this maps each packed name to its region's key.
+		const TextureAtlas& GetAtlas() const { return mAtlas; }
+		Map<std::string, std::string> GetAtlasRegionNames() const;
+		TextureDedupStats GetDedupStats() const;
 		bool RemoveTexture(const std::string& name);
 		bool Clear();
+
+		// Records that the texture was drawn this frame, loading it again if it was evicted.
+		void Touch(AssetIndex asset);
+		// Same, and keeps the texture resident for as long as the handle lives.
+		TextureHandle Acquire(AssetIndex asset);
+		// Evicts least recently used standalone textures and atlas pages until what is left
+		// fits the budget. A page goes whole, with every texture packed on it, and only once
+		// none of them is kept: textures with a handle, and those used this frame or the one
+		// before, are kept. Call once per frame; returns the names that were evicted.
+		List<std::string> Trim();
+		// Loads every evicted or still decoding texture at once, for exports that need all
+		// of them. Trim applies the budget again on the next frame.
+		void LoadAllTextures();
+		void SetMemoryBudget(std::uint64_t bytes) { mMemoryBudget = bytes; }
+		std::uint64_t GetMemoryBudget() const { return mMemoryBudget; }
+		TextureMemoryStats GetMemoryStats() const;
+
+		static constexpr std::uint64_t kDefaultMemoryBudget = 512ull * 1024 * 1024;
 		//Dictionary<std::string, unique<sf::Texture>>& GetLoadedTextures() const;
 	private:
-		AssetManager() = default;
+		struct DecodedImage
+		{
+			sf::Image image;
+			std::uint64_t contentHash;
+		};
+
+		// One image file, shared by every name mapped onto it. Keyed by canonical path,
+		// which is also its key in the atlas.
+		struct TextureEntry
+		{
+			TextureStatus status = TextureStatus::Missing;
+			// Null once the texture is packed: the atlas holds the only copy.
+			unique<sf::Texture> texture;
+			bool packIntoAtlas = true;
+			std::uint64_t contentHash = 0;
+			std::uint64_t bytes = 0;
+			List<std::string> names;
+			// The interned names, in the same order, for per-frame code that must not hash.
+			List<AssetIndex> assets;
+		};
+
+		struct PendingTexture
+		{
+			std::string key;
+			std::future<std::optional<DecodedImage>> image;
+		};
+
+		struct TextureSlot
+		{
+			TextureStatus status = TextureStatus::Missing;
+			const sf::Texture* texture = nullptr;
+			const AtlasRegion* region = nullptr;
+			std::uint64_t lastUsed = 0;
+			std::uint32_t references = 0;
+		};
+
+		static std::optional<DecodedImage> Decode(const std::string& path);
+		// The entry the file at path is, or would be, stored under.
+		std::string ResolveKey(const std::string& path) const;
+		const TextureEntry* FindEntry(const std::string& name) const;
+		const std::string* FindKey(const std::string& name) const;
+		// Maps the name onto the entry of path, creating it; true if it needs decoding.
+		bool MapName(const std::string& name, const std::string& path, bool packIntoAtlas);
+		void UnmapName(const std::string& name);
+		void StartDecode(const std::string& key);
+		// Uploads the decoded image, or hands the entry's names to an entry with the same
+		// content. Appends the names that changed to finished.
+		void FinishDecode(const std::string& key, std::optional<DecodedImage> decoded, List<std::string>& finished);
+		void EraseEntry(const std::string& key);
+		// Refreshes the cached lookups and byte count of an entry and its names.
+		void SyncEntry(const std::string& key);
+		// Refreshes the cached lookups of one name after its texture or region changed.
+		void SyncSlot(const std::string& name);
+		TextureSlot& GetSlot(AssetIndex asset);
+		// The latest use of any name of the entry, and whether a handle holds one of them.
+		void GetUsage(const TextureEntry& entry, std::uint64_t& lastUsed, bool& pinned) const;
+		// Drops the entry's standalone texture, if any; its atlas region must be gone already.
+		void Evict(const std::string& key, List<std::string>& evicted);
+		std::uint64_t GetAtlasBytes() const;
+		void AddReference(AssetIndex asset);
+		void ReleaseReference(AssetIndex asset);
+
+		friend class TextureHandle;
+
+		AssetManager();
 		static unique<AssetManager> assetManager;
-		Dictionary<std::string, unique<sf::Texture>> mLoadedTextures;
+		Dictionary<std::string, TextureEntry> mTextures;
+		// Asset name to texture key.
+		Dictionary<std::string, std::string> mTextureKeys;
+		// Canonical paths found to hold the same image as another entry, to that entry's key.
+		Dictionary<std::string, std::string> mPathAliases;
+		Dictionary<std::uint64_t, std::string> mContentKeys;
+		List<PendingTexture> mPendingTextures;
+		TextureAtlas mAtlas;
+		// Addressed by asset index. Atlas regions are updated in place when a page is
+		// repacked, so the cached pointers only change when a name is (re)loaded or removed.
+		List<TextureSlot> mSlots;
+		unique<ThreadPool> mDecodePool;
+		std::uint64_t mTextureBytes;
+		std::uint64_t mMemoryBudget;
+		std::uint64_t mFrame;
+		unsigned long long mHits;
+		unsigned long long mMisses;
+		unsigned long long mEvictions;
+		size_t mSharedByPath;
+		size_t mSharedByContent;
 	};
-}
\ No newline at end of file
+}
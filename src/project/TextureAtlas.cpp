@@ -0,0 +1,363 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <limits>
+
+using namespace vle;
+
+namespace
+{
+	const unsigned int kInitialPageSize = 512;
+	const unsigned int kMaxPageSize = 4096;
+}
+
+void SkylinePacker::Reset(sf::Vector2u size)
+{
+	mSize = size;
+	mSkyline.clear();
+	mSkyline.push_back(Segment{ 0, 0, size.x });
+}
+
+void SkylinePacker::Grow(sf::Vector2u size)
+{
+	if (size.x > mSize.x)
+	{
+		mSkyline.push_back(Segment{ mSize.x, 0, size.x - mSize.x });
+	}
+	mSize = { std::max(size.x, mSize.x), std::max(size.y, mSize.y) };
+	Merge();
+}
+
+std::optional<sf::Vector2u> SkylinePacker::Insert(sf::Vector2u size)
+{
+	size_t bestIndex = mSkyline.size();
+	unsigned int bestY = 0;
+	unsigned int bestTop = std::numeric_limits<unsigned int>::max();
+	unsigned int bestWidth = std::numeric_limits<unsigned int>::max();
+	for (size_t i = 0; i < mSkyline.size(); i++)
+	{
+		std::optional<unsigned int> y = Fit(i, size);
+		if (!y.has_value())
+		{
+			continue;
+		}
+		unsigned int top = y.value() + size.y;
+		if (top < bestTop || (top == bestTop && mSkyline[i].width < bestWidth))
+		{
+			bestIndex = i;
+			bestY = y.value();
+			bestTop = top;
+			bestWidth = mSkyline[i].width;
+		}
+	}
+	if (bestIndex == mSkyline.size())
+	{
+		return std::nullopt;
+	}
+
+	sf::Vector2u position{ mSkyline[bestIndex].x, bestY };
+	mSkyline.insert(mSkyline.begin() + bestIndex, Segment{ position.x, bestTop, size.x });
+	for (size_t i = bestIndex + 1; i < mSkyline.size();)
+	{
+		const Segment& previous = mSkyline[i - 1];
+		Segment& segment = mSkyline[i];
+		unsigned int previousEnd = previous.x + previous.width;
+		if (segment.x >= previousEnd)
+		{
+			break;
+		}
+		unsigned int overlap = previousEnd - segment.x;
+		if (segment.width <= overlap)
+		{
+			mSkyline.erase(mSkyline.begin() + i);
+			continue;
+		}
+		segment.x += overlap;
+		segment.width -= overlap;
+		break;
+	}
+	Merge();
+	return position;
+}
+
+std::optional<unsigned int> SkylinePacker::Fit(size_t index, sf::Vector2u size) const
+{
+	if (mSkyline[index].x + size.x > mSize.x)
+	{
+		return std::nullopt;
+	}
+	unsigned int y = 0;
+	unsigned int widthLeft = size.x;
+	for (size_t i = index; widthLeft > 0 && i < mSkyline.size(); i++)
+	{
+		y = std::max(y, mSkyline[i].y);
+		if (y + size.y > mSize.y)
+		{
+			return std::nullopt;
+		}
+		widthLeft -= std::min(widthLeft, mSkyline[i].width);
+	}
+	return y;
+}
+
+void SkylinePacker::Merge()
+{
+	for (size_t i = 1; i < mSkyline.size();)
+	{
+		if (mSkyline[i - 1].y == mSkyline[i].y)
+		{
+			mSkyline[i - 1].width += mSkyline[i].width;
+			mSkyline.erase(mSkyline.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+TextureAtlas::TextureAtlas(unsigned int padding)
+	: mPadding{ padding },
+	mMaxPageSize{ std::min(kMaxPageSize, sf::Texture::getMaximumSize()) }
+{
+}
+
+bool TextureAtlas::Insert(const std::string& name, const sf::Texture& texture)
+{
+	Remove(name);
+	const sf::Vector2u size = texture.getSize();
+	const sf::Vector2u paddedSize{ size.x + 2 * mPadding, size.y + 2 * mPadding };
+	if (size.x == 0 || size.y == 0 || paddedSize.x > mMaxPageSize || paddedSize.y > mMaxPageSize)
+	{
+		return false;
+	}
+
+	// Fill the pages we have before growing any of them, and grow before opening a new one.
+	std::optional<sf::Vector2u> position;
+	size_t pageIndex = 0;
+	for (bool allowGrow : { false, true })
+	{
+		for (pageIndex = 0; pageIndex < mPages.size() && !position.has_value(); pageIndex++)
+		{
+			position = PackInto(mPages[pageIndex], paddedSize, allowGrow);
+		}
+		if (position.has_value())
+		{
+			pageIndex--;
+			break;
+		}
+	}
+	if (!position.has_value())
+	{
+		unsigned int side = kInitialPageSize;
+		while (side < std::max(paddedSize.x, paddedSize.y))
+		{
+			side *= 2;
+		}
+		side = std::min(side, mMaxPageSize);
+		Page page;
+		page.texture = std::make_unique<sf::Texture>();
+		if (!page.texture->loadFromImage(sf::Image({ side, side }, sf::Color::Transparent)))
+		{
+			return false;
+		}
+		page.packer.Reset({ side, side });
+		mPages.push_back(std::move(page));
+		pageIndex = mPages.size() - 1;
+		position = PackInto(mPages.back(), paddedSize, false);
+		if (!position.has_value())
+		{
+			return false;
+		}
+	}
+
+	Page& page = mPages[pageIndex];
+	const sf::Vector2u destination{ position->x + mPadding, position->y + mPadding };
+	page.texture->update(texture, destination);
+	page.usedArea += static_cast<unsigned long long>(paddedSize.x) * paddedSize.y;
+	mRegions[name] = AtlasRegion{ pageIndex, sf::IntRect(sf::Vector2i(destination), sf::Vector2i(size)) };
+	return true;
+}
+
+bool TextureAtlas::Remove(const std::string& name)
+{
+	auto found = mRegions.find(name);
+	if (found == mRegions.end())
+	{
+		return false;
+	}
+	const size_t pageIndex = found->second.page;
+	const sf::Vector2i size = found->second.rect.size;
+	const unsigned long long area = static_cast<unsigned long long>(size.x + 2 * mPadding) * (size.y + 2 * mPadding);
+	mRegions.erase(found);
+	mMovedRegions.erase(std::remove(mMovedRegions.begin(), mMovedRegions.end(), name), mMovedRegions.end());
+
+	Page& page = mPages[pageIndex];
+	page.usedArea -= std::min(page.usedArea, area);
+	page.freedArea += area;
+	if (page.usedArea == 0)
+	{
+		page.packer.Reset(page.packer.GetSize());
+		page.freedArea = 0;
+	}
+	else if (page.freedArea > page.usedArea)
+	{
+		RepackPage(pageIndex);
+	}
+	return true;
+}
+
+List<std::string> TextureAtlas::RemovePage(size_t pageIndex)
+{
+	List<std::string> removed;
+	if (pageIndex >= mPages.size())
+	{
+		return removed;
+	}
+	for (auto it = mRegions.begin(); it != mRegions.end();)
+	{
+		if (it->second.page == pageIndex)
+		{
+			removed.push_back(it->first);
+			it = mRegions.erase(it);
+			continue;
+		}
+		if (it->second.page > pageIndex)
+		{
+			--it->second.page;
+			if (std::find(mMovedRegions.begin(), mMovedRegions.end(), it->first) == mMovedRegions.end())
+			{
+				mMovedRegions.push_back(it->first);
+			}
+		}
+		++it;
+	}
+	mMovedRegions.erase(std::remove_if(mMovedRegions.begin(), mMovedRegions.end(), [&removed](const std::string& name)
+		{
+			return std::find(removed.begin(), removed.end(), name) != removed.end();
+		}), mMovedRegions.end());
+	mPages.erase(mPages.begin() + pageIndex);
+	return removed;
+}
+
+void TextureAtlas::Clear()
+{
+	mPages.clear();
+	mRegions.clear();
+	mMovedRegions.clear();
+}
+
+const AtlasRegion* TextureAtlas::GetRegion(const std::string& name) const
+{
+	auto found = mRegions.find(name);
+	if (found != mRegions.end())
+	{
+		return &found->second;
+	}
+	return nullptr;
+}
+
+List<std::string> TextureAtlas::TakeMovedRegions()
+{
+	List<std::string> moved;
+	moved.swap(mMovedRegions);
+	return moved;
+}
+
+std::optional<sf::Vector2u> TextureAtlas::PackInto(Page& page, sf::Vector2u paddedSize, bool allowGrow)
+{
+	while (true)
+	{
+		std::optional<sf::Vector2u> position = page.packer.Insert(paddedSize);
+		if (position.has_value() || !allowGrow || !GrowPage(page))
+		{
+			return position;
+		}
+	}
+}
+
+bool TextureAtlas::GrowPage(Page& page)
+{
+	const sf::Vector2u size = page.packer.GetSize();
+	if (size.x >= mMaxPageSize && size.y >= mMaxPageSize)
+	{
+		return false;
+	}
+	sf::Vector2u grownSize = size;
+	if ((size.x <= size.y && size.x < mMaxPageSize) || size.y >= mMaxPageSize)
+	{
+		grownSize.x = std::min(size.x * 2, mMaxPageSize);
+	}
+	else
+	{
+		grownSize.y = std::min(size.y * 2, mMaxPageSize);
+	}
+	sf::Texture grown;
+	if (!grown.loadFromImage(sf::Image(grownSize, sf::Color::Transparent)))
+	{
+		return false;
+	}
+	grown.update(*page.texture, { 0, 0 });
+	*page.texture = std::move(grown);
+	page.packer.Grow(grownSize);
+	return true;
+}
+
+void TextureAtlas::RepackPage(size_t pageIndex)
+{
+	Page& page = mPages[pageIndex];
+	List<std::pair<const std::string, AtlasRegion>*> entries;
+	for (auto& pair : mRegions)
+	{
+		if (pair.second.page == pageIndex)
+		{
+			entries.push_back(&pair);
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b)
+		{
+			if (a->second.rect.size.y != b->second.rect.size.y)
+			{
+				return a->second.rect.size.y > b->second.rect.size.y;
+			}
+			return a->second.rect.size.x > b->second.rect.size.x;
+		});
+
+	// Pack into a scratch packer first: if the tallest-first order does not fit
+	// the page is left as it is, fragmented but valid.
+	SkylinePacker packer;
+	packer.Reset(page.packer.GetSize());
+	List<sf::Vector2u> destinations;
+	destinations.reserve(entries.size());
+	for (const auto* entry : entries)
+	{
+		const sf::Vector2i size = entry->second.rect.size;
+		std::optional<sf::Vector2u> position = packer.Insert({ size.x + 2 * mPadding, size.y + 2 * mPadding });
+		if (!position.has_value())
+		{
+			return;
+		}
+		destinations.push_back({ position->x + mPadding, position->y + mPadding });
+	}
+
+	const sf::Image source = page.texture->copyToImage();
+	sf::Image packed(packer.GetSize(), sf::Color::Transparent);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		(void)packed.copy(source, destinations[i], entries[i]->second.rect);
+	}
+	if (!page.texture->loadFromImage(packed))
+	{
+		return;
+	}
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		sf::IntRect& rect = entries[i]->second.rect;
+		if (rect.position != sf::Vector2i(destinations[i]))
+		{
+			rect.position = sf::Vector2i(destinations[i]);
+			mMovedRegions.push_back(entries[i]->first);
+		}
+	}
+	page.packer = packer;
+	page.freedArea = 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <SFML/Graphics.hpp>
+#include "core/Utils.h"
+
+namespace vle {
+	// Bottom-left skyline packer: the free space of a page is tracked as the
+	// top edge of everything packed so far.
+	class SkylinePacker
+	{
+	public:
+		void Reset(sf::Vector2u size);
+		// Enlarges the packing area without moving what is already packed.
+		void Grow(sf::Vector2u size);
+		std::optional<sf::Vector2u> Insert(sf::Vector2u size);
+		sf::Vector2u GetSize() const { return mSize; }
+
+	private:
+		struct Segment
+		{
+			unsigned int x;
+			unsigned int y;
+			unsigned int width;
+		};
+
+		std::optional<unsigned int> Fit(size_t index, sf::Vector2u size) const;
+		void Merge();
+
+		List<Segment> mSkyline;
+		sf::Vector2u mSize;
+	};
+
+	struct AtlasRegion
+	{
+		size_t page;
+		sf::IntRect rect;
+	};
+
+	// Packs many small textures into a few large pages so sprites sharing a page
+	// can be drawn without texture switches. Pages start small and grow up to
+	// the maximum page size; a page is repacked once more than half of its used
+	// area belongs to removed textures.
+	class TextureAtlas
+	{
+	public:
+		explicit TextureAtlas(unsigned int padding = 2);
+
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+		// Returns false if the texture does not fit in a page; it should then be drawn on its own.
+		bool Insert(const std::string& name, const sf::Texture& texture);
+		bool Remove(const std::string& name);
+		// Drops a page and every region on it, returning their names. Later pages move
+		// down one index, so their regions are reported as moved.
+		List<std::string> RemovePage(size_t pageIndex);
+		void Clear();
+
+		const AtlasRegion* GetRegion(const std::string& name) const;
+		const Dictionary<std::string, AtlasRegion>& GetRegions() const { return mRegions; }
+		size_t GetPageCount() const { return mPages.size(); }
+		// Page textures keep their address for as long as the page exists, even when it grows.
+		const sf::Texture& GetPage(size_t index) const { return *mPages[index].texture; }
+		// Names whose region moved to another place since the last call.
+		List<std::string> TakeMovedRegions();
+
+	private:
+		struct Page
+		{
+			unique<sf::Texture> texture;
+			SkylinePacker packer;
+			unsigned long long usedArea = 0;
+			unsigned long long freedArea = 0;
+		};
+
+		std::optional<sf::Vector2u> PackInto(Page& page, sf::Vector2u paddedSize, bool allowGrow);
+		bool GrowPage(Page& page);
+		void RepackPage(size_t pageIndex);
+
+		List<Page> mPages;
+		Dictionary<std::string, AtlasRegion> mRegions;
+		List<std::string> mMovedRegions;
+		unsigned int mPadding;
+		unsigned int mMaxPageSize;
+	};
+}
@@ -0,0 +1,167 @@
+#include "HitboxRenderer.h"
+#include <algorithm>
+
+using namespace vle;
+
+namespace
+{
+	// Level 0 keeps every vertex; level n drops vertices closer than kBaseTolerance * 2^(n-1).
+	const float kBaseTolerance = 1.f;
+
+	float ToleranceOf(size_t level)
+	{
+		return level == 0 ? 0.f : kBaseTolerance * static_cast<float>(1u << (level - 1));
+	}
+
+	bool Overlaps(const sf::FloatRect& a, const sf::FloatRect& b)
+	{
+		return a.position.x <= b.position.x + b.size.x && b.position.x <= a.position.x + a.size.x &&
+			a.position.y <= b.position.y + b.size.y && b.position.y <= a.position.y + a.size.y;
+	}
+}
+
+HitboxRenderer::HitboxRenderer()
+	: mVertexBuffer{ sf::PrimitiveType::Lines, sf::VertexBuffer::Usage::Static },
+	mUseVertexBuffer{ sf::VertexBuffer::isAvailable() },
+	mChainCount{ 0 },
+	mDirty{ true }
+{
+}
+
+void HitboxRenderer::MarkDirty()
+{
+	mDirty = true;
+}
+
+void HitboxRenderer::Update(const List<sf::VertexArray>& chains, const sf::FloatRect& viewArea, float worldUnitsPerPixel)
+{
+	if (mDirty || chains.size() != mChainCount)
+	{
+		Rebuild(chains);
+		mDirty = false;
+	}
+
+	size_t level = 0;
+	while (level + 1 < kLevelCount && ToleranceOf(level + 1) <= worldUnitsPerPixel)
+	{
+		level++;
+	}
+
+	mDrawRanges.clear();
+	for (size_t i = 0; i < mChainCount; i++)
+	{
+		const Range& range = mChainRanges[level][i];
+		if (range.vertexCount == 0 || !Overlaps(mChainBounds[i], viewArea))
+		{
+			continue;
+		}
+		if (!mDrawRanges.empty() && mDrawRanges.back().firstVertex + mDrawRanges.back().vertexCount == range.firstVertex)
+		{
+			mDrawRanges.back().vertexCount += range.vertexCount;
+		}
+		else
+		{
+			mDrawRanges.push_back(range);
+		}
+	}
+}
+
+void HitboxRenderer::Rebuild(const List<sf::VertexArray>& chains)
+{
+	mVertices.clear();
+	mChainBounds.clear();
+	mChainBounds.reserve(chains.size());
+	mChainCount = chains.size();
+	for (const sf::VertexArray& chain : chains)
+	{
+		mChainBounds.push_back(chain.getBounds());
+	}
+
+	for (size_t level = 0; level < kLevelCount; level++)
+	{
+		mChainRanges[level].clear();
+		mChainRanges[level].reserve(chains.size());
+		for (size_t i = 0; i < chains.size(); i++)
+		{
+			// Only line strips are decimated; other chains draw their full geometry at every level.
+			if (level > 0 && chains[i].getPrimitiveType() != sf::PrimitiveType::LineStrip)
+			{
+				mChainRanges[level].push_back(mChainRanges[0][i]);
+				continue;
+			}
+			const size_t first = mVertices.size();
+			AppendChain(chains[i], ToleranceOf(level));
+			mChainRanges[level].push_back(Range{ first, mVertices.size() - first });
+		}
+	}
+
+	if (!mUseVertexBuffer || mVertices.empty())
+	{
+		return;
+	}
+	if (!mVertexBuffer.create(mVertices.size()) || !mVertexBuffer.update(mVertices.data()))
+	{
+		mUseVertexBuffer = false;
+	}
+}
+
+void HitboxRenderer::AppendChain(const sf::VertexArray& chain, float tolerance)
+{
+	const size_t count = chain.getVertexCount();
+	switch (chain.getPrimitiveType())
+	{
+	case sf::PrimitiveType::Lines:
+		for (size_t i = 0; i + 1 < count; i += 2)
+		{
+			mVertices.push_back(chain[i]);
+			mVertices.push_back(chain[i + 1]);
+		}
+		break;
+	case sf::PrimitiveType::LineStrip:
+	{
+		if (count < 2)
+		{
+			break;
+		}
+		const float toleranceSquared = tolerance * tolerance;
+		sf::Vertex last = chain[0];
+		for (size_t i = 1; i < count; i++)
+		{
+			const sf::Vector2f offset = chain[i].position - last.position;
+			const bool isLast = i + 1 == count;
+			if (!isLast && offset.x * offset.x + offset.y * offset.y < toleranceSquared)
+			{
+				continue;
+			}
+			mVertices.push_back(last);
+			mVertices.push_back(chain[i]);
+			last = chain[i];
+		}
+		break;
+	}
+	default:
+		// Points and filled primitives are shown as their outline.
+		for (size_t i = 0; i + 1 < count; i++)
+		{
+			mVertices.push_back(chain[i]);
+			mVertices.push_back(chain[i + 1]);
+		}
+		break;
+	}
+}
+
+void HitboxRenderer::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	states.texture = nullptr;
+	for (const Range& range : mDrawRanges)
+	{
+		if (mUseVertexBuffer)
+		{
+			target.draw(mVertexBuffer, range.firstVertex, range.vertexCount, states);
+		}
+		else
+		{
+			target.draw(&mVertices[range.firstVertex], range.vertexCount, sf::PrimitiveType::Lines, states);
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "core/Utils.h"
+
+namespace vle {
+	// Draws the hitbox overlay from one static vertex buffer of Lines.
+	// The buffer is built once per hitbox map and holds every chain at several
+	// levels of detail; each frame only the chains overlapping the view are drawn,
+	// at the coarsest level whose error stays under about a screen pixel.
+	class HitboxRenderer : public sf::Drawable
+	{
+	public:
+		HitboxRenderer();
+
+		// Call whenever the hitbox map is replaced or edited.
+		void MarkDirty();
+		bool IsDirty() const { return mDirty; }
+		void Update(const List<sf::VertexArray>& chains, const sf::FloatRect& viewArea, float worldUnitsPerPixel);
+
+		size_t GetDrawCallCount() const { return mDrawRanges.size(); }
+
+	private:
+		struct Range
+		{
+			size_t firstVertex;
+			size_t vertexCount;
+		};
+
+		static constexpr size_t kLevelCount = 6;
+
+		void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+		void Rebuild(const List<sf::VertexArray>& chains);
+		void AppendChain(const sf::VertexArray& chain, float tolerance);
+
+		sf::VertexBuffer mVertexBuffer;
+		bool mUseVertexBuffer;
+		List<sf::Vertex> mVertices;
+		List<sf::FloatRect> mChainBounds;
+		// mChainRanges[level][chain]
+		List<Range> mChainRanges[kLevelCount];
+		List<Range> mDrawRanges;
+		size_t mChainCount;
+		bool mDirty;
+	};
+}
@@ -0,0 +1,193 @@
+#include "SpriteBatcher.h"
+#include <algorithm>
+#include "core/Profiler.h"
+#include "project/AssetManager.h"
+
+using namespace vle;
+
+SpriteBatcher::SpriteBatcher()
+	: mVertexBuffer{ sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Dynamic },
+	mUseVertexBuffer{ sf::VertexBuffer::isAvailable() },
+	mCulled{ false },
+	mStructureDirty{ true }
+{
+}
+
+void SpriteBatcher::MarkDirty(size_t index)
+{
+	mDirtyIndices.push_back(index);
+}
+
+void SpriteBatcher::MarkStructureDirty()
+{
+	mStructureDirty = true;
+}
+
+void SpriteBatcher::Update(const GameObjectStore& objects)
+{
+	PROFILE_ZONE("SpriteBatcher::Update");
+	// A size mismatch means an add or remove went unreported, so never draw stale quads.
+	if (mStructureDirty || objects.GetCount() * kVerticesPerQuad != mVertices.size())
+	{
+		Rebuild(objects);
+		mStructureDirty = false;
+		mDirtyIndices.clear();
+		return;
+	}
+	if (mDirtyIndices.empty())
+	{
+		return;
+	}
+
+	std::sort(mDirtyIndices.begin(), mDirtyIndices.end());
+	mDirtyIndices.erase(std::unique(mDirtyIndices.begin(), mDirtyIndices.end()), mDirtyIndices.end());
+	for (size_t index : mDirtyIndices)
+	{
+		WriteQuad(objects, index);
+	}
+	if (mUseVertexBuffer)
+	{
+		// Upload runs of neighbouring quads with one call each.
+		for (size_t first = 0; first < mDirtyIndices.size();)
+		{
+			size_t last = first;
+			while (last + 1 < mDirtyIndices.size() && mDirtyIndices[last + 1] == mDirtyIndices[last] + 1)
+			{
+				last++;
+			}
+			const size_t vertexOffset = mDirtyIndices[first] * kVerticesPerQuad;
+			const size_t vertexCount = (last - first + 1) * kVerticesPerQuad;
+			(void)mVertexBuffer.update(&mVertices[vertexOffset], vertexCount, static_cast<unsigned int>(vertexOffset));
+			first = last + 1;
+		}
+	}
+	mDirtyIndices.clear();
+}
+
+void SpriteBatcher::Cull(const GameObjectStore& objects, const List<GameObjectHandle>& visible)
+{
+	mVisibleBatches.clear();
+	// With most of the level on screen a few long draws beat many short ones.
+	mCulled = visible.size() * 2 < GetQuadCount();
+	if (!mCulled)
+	{
+		return;
+	}
+	mVisibleIndices.clear();
+	for (GameObjectHandle object : visible)
+	{
+		const size_t index = objects.IndexOf(object);
+		if (index != GameObjectStore::kInvalidIndex && index < GetQuadCount())
+		{
+			mVisibleIndices.push_back(index);
+		}
+	}
+	std::sort(mVisibleIndices.begin(), mVisibleIndices.end());
+
+	size_t batch = 0;
+	for (size_t index : mVisibleIndices)
+	{
+		const size_t firstVertex = index * kVerticesPerQuad;
+		while (mBatches[batch].firstVertex + mBatches[batch].vertexCount <= firstVertex)
+		{
+			batch++;
+		}
+		if (!mVisibleBatches.empty() && mVisibleBatches.back().texture == mBatches[batch].texture &&
+			mVisibleBatches.back().firstVertex + mVisibleBatches.back().vertexCount == firstVertex)
+		{
+			mVisibleBatches.back().vertexCount += kVerticesPerQuad;
+		}
+		else
+		{
+			mVisibleBatches.push_back(Batch{ mBatches[batch].texture, firstVertex, kVerticesPerQuad });
+		}
+	}
+}
+
+void SpriteBatcher::Rebuild(const GameObjectStore& objects)
+{
+	mVertices.resize(objects.GetCount() * kVerticesPerQuad);
+	mBatches.clear();
+	mCulled = false;
+	for (size_t i = 0; i < objects.GetCount(); i++)
+	{
+		const sf::Texture* texture = WriteQuad(objects, i);
+		if (mBatches.empty() || mBatches.back().texture != texture)
+		{
+			mBatches.push_back(Batch{ texture, i * kVerticesPerQuad, 0 });
+		}
+		mBatches.back().vertexCount += kVerticesPerQuad;
+	}
+
+	if (!mUseVertexBuffer || mVertices.empty())
+	{
+		return;
+	}
+	if (mVertexBuffer.getVertexCount() < mVertices.size())
+	{
+		// Leave headroom so placing objects one by one does not reallocate every time.
+		if (!mVertexBuffer.create(mVertices.size() + mVertices.size() / 2))
+		{
+			mUseVertexBuffer = false;
+			return;
+		}
+	}
+	(void)mVertexBuffer.update(mVertices.data(), mVertices.size(), 0);
+}
+
+const sf::Texture* SpriteBatcher::WriteQuad(const GameObjectStore& objects, size_t index)
+{
+	sf::Vertex* quad = &mVertices[index * kVerticesPerQuad];
+	const AssetIndex asset = objects.GetAssets()[index];
+	const TextureStatus status = AssetManager::Get().GetTextureStatus(asset);
+	sf::IntRect textureRect;
+	const sf::Texture* texture = status == TextureStatus::Ready ? AssetManager::Get().GetTextureRegion(asset, textureRect) : nullptr;
+	sf::FloatRect local;
+	sf::FloatRect texCoords;
+	sf::Color color;
+	if (texture)
+	{
+		local = sf::FloatRect({ 0.f, 0.f }, objects.GetSizes()[index]);
+		texCoords = sf::FloatRect(textureRect);
+		color = sf::Color::White;
+	}
+	else
+	{
+		local = sf::FloatRect(objects.GetOrigins()[index] - sf::Vector2f(kPlaceholderSize, kPlaceholderSize) / 2.f, { kPlaceholderSize, kPlaceholderSize });
+		color = status == TextureStatus::Failed ? sf::Color(200, 40, 40, 160) : sf::Color(120, 120, 120, 120);
+	}
+
+	const sf::Transform transform = objects.GetTransform(index);
+	const sf::Vector2f topLeft = transform.transformPoint(local.position);
+	const sf::Vector2f topRight = transform.transformPoint({ local.position.x + local.size.x, local.position.y });
+	const sf::Vector2f bottomRight = transform.transformPoint(local.position + local.size);
+	const sf::Vector2f bottomLeft = transform.transformPoint({ local.position.x, local.position.y + local.size.y });
+	const sf::Vector2f texTopLeft = texCoords.position;
+	const sf::Vector2f texTopRight = { texCoords.position.x + texCoords.size.x, texCoords.position.y };
+	const sf::Vector2f texBottomRight = texCoords.position + texCoords.size;
+	const sf::Vector2f texBottomLeft = { texCoords.position.x, texCoords.position.y + texCoords.size.y };
+
+	quad[0] = sf::Vertex{ topLeft, color, texTopLeft };
+	quad[1] = sf::Vertex{ topRight, color, texTopRight };
+	quad[2] = sf::Vertex{ bottomLeft, color, texBottomLeft };
+	quad[3] = sf::Vertex{ bottomLeft, color, texBottomLeft };
+	quad[4] = sf::Vertex{ topRight, color, texTopRight };
+	quad[5] = sf::Vertex{ bottomRight, color, texBottomRight };
+	return texture;
+}
+
+void SpriteBatcher::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	for (const Batch& batch : mCulled ? mVisibleBatches : mBatches)
+	{
+		states.texture = batch.texture;
+		if (mUseVertexBuffer)
+		{
+			target.draw(mVertexBuffer, batch.firstVertex, batch.vertexCount, states);
+		}
+		else
+		{
+			target.draw(&mVertices[batch.firstVertex], batch.vertexCount, sf::PrimitiveType::Triangles, states);
+		}
+	}
+}
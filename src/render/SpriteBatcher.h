@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "core/Utils.h"
+#include "level/GameObjectStore.h"
+
+namespace vle {
+	// Keeps the quads of every game object in one vertex buffer, in draw order;
+	// quad i belongs to the object at index i of the store.
+	// Neighbouring objects that sample the same texture (usually an atlas page) are
+	// drawn with a single call. Moving an object only rewrites its own quad; adding,
+	// removing, reordering objects or rebinding their textures needs MarkStructureDirty.
+	// Objects whose texture is not uploaded yet are drawn as flat placeholder quads.
+	class SpriteBatcher : public sf::Drawable
+	{
+	public:
+		SpriteBatcher();
+
+		void MarkDirty(size_t index);
+		void MarkStructureDirty();
+		void Update(const GameObjectStore& objects);
+		// Restricts the next draws to the given objects, keeping draw order. Call after Update.
+		void Cull(const GameObjectStore& objects, const List<GameObjectHandle>& visible);
+		// True when the next Update will change what is drawn.
+		bool IsDirty() const { return mStructureDirty || !mDirtyIndices.empty(); }
+
+		size_t GetBatchCount() const { return mBatches.size(); }
+		size_t GetQuadCount() const { return mVertices.size() / kVerticesPerQuad; }
+
+		static constexpr float kPlaceholderSize = 64.f;
+
+	private:
+		struct Batch
+		{
+			const sf::Texture* texture;
+			size_t firstVertex;
+			size_t vertexCount;
+		};
+
+		static constexpr size_t kVerticesPerQuad = 6;
+
+		void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+		void Rebuild(const GameObjectStore& objects);
+		// Returns the texture the quad samples, nullptr for placeholders.
+		const sf::Texture* WriteQuad(const GameObjectStore& objects, size_t index);
+
+		sf::VertexBuffer mVertexBuffer;
+		bool mUseVertexBuffer;
+		List<sf::Vertex> mVertices;
+		List<Batch> mBatches;
+		List<Batch> mVisibleBatches;
+		List<size_t> mVisibleIndices;
+		bool mCulled;
+		List<size_t> mDirtyIndices;
+		bool mStructureDirty;
+	};
+}
@@ -0,0 +1,229 @@
+#include "ThumbnailCache.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <sstream>
+#include "core/Hash.h"
+#include "core/Profiler.h"
+
+using namespace vle;
+
+namespace
+{
+	const unsigned int kThreads = 2;
+
+	std::string HashPath(const std::string& path)
+	{
+		std::ostringstream name;
+		name << std::hex << Fnv1a(path);
+		return name.str();
+	}
+
+	// Averages every source pixel into the target pixel it falls in, weighting colors by
+	// alpha so transparent pixels do not darken the edges of a sprite.
+	sf::Image Downscale(const sf::Image& source, unsigned int maxSize)
+	{
+		const sf::Vector2u size = source.getSize();
+		if (size.x <= maxSize && size.y <= maxSize)
+		{
+			return source;
+		}
+		const float scale = static_cast<float>(maxSize) / static_cast<float>(std::max(size.x, size.y));
+		const sf::Vector2u target{
+			std::max(1u, static_cast<unsigned int>(std::lround(size.x * scale))),
+			std::max(1u, static_cast<unsigned int>(std::lround(size.y * scale))) };
+		const std::uint8_t* pixels = source.getPixelsPtr();
+		List<std::uint8_t> result(static_cast<size_t>(target.x) * target.y * 4);
+		for (unsigned int y = 0; y < target.y; y++)
+		{
+			const unsigned int y0 = static_cast<unsigned int>(static_cast<uint64_t>(y) * size.y / target.y);
+			const unsigned int y1 = std::max(y0 + 1, static_cast<unsigned int>(static_cast<uint64_t>(y + 1) * size.y / target.y));
+			for (unsigned int x = 0; x < target.x; x++)
+			{
+				const unsigned int x0 = static_cast<unsigned int>(static_cast<uint64_t>(x) * size.x / target.x);
+				const unsigned int x1 = std::max(x0 + 1, static_cast<unsigned int>(static_cast<uint64_t>(x + 1) * size.x / target.x));
+				uint64_t red = 0, green = 0, blue = 0, alpha = 0;
+				for (unsigned int sy = y0; sy < y1; sy++)
+				{
+					const std::uint8_t* pixel = pixels + (static_cast<size_t>(sy) * size.x + x0) * 4;
+					for (unsigned int sx = x0; sx < x1; sx++, pixel += 4)
+					{
+						red += pixel[0] * pixel[3];
+						green += pixel[1] * pixel[3];
+						blue += pixel[2] * pixel[3];
+						alpha += pixel[3];
+					}
+				}
+				const uint64_t count = static_cast<uint64_t>(x1 - x0) * (y1 - y0);
+				std::uint8_t* out = result.data() + (static_cast<size_t>(y) * target.x + x) * 4;
+				out[0] = alpha ? static_cast<std::uint8_t>(red / alpha) : 0;
+				out[1] = alpha ? static_cast<std::uint8_t>(green / alpha) : 0;
+				out[2] = alpha ? static_cast<std::uint8_t>(blue / alpha) : 0;
+				out[3] = static_cast<std::uint8_t>((alpha + count / 2) / count);
+			}
+		}
+		return sf::Image(target, result.data());
+	}
+}
+
+ThumbnailCache::ThumbnailCache()
+	: mPendingCount{ 0 },
+	mCancelled{ std::make_shared<std::atomic<bool>>(false) },
+	mPool{ std::make_unique<ThreadPool>(kThreads) }
+{
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+	mCancelled->store(true);
+}
+
+void ThumbnailCache::Request(const std::string& name, const std::string& path)
+{
+	mPaths[name] = path;
+	auto [found, created] = mThumbnails.try_emplace(path);
+	if (!created)
+	{
+		return;
+	}
+	Thumbnail& thumbnail = found->second;
+	thumbnail.status = TextureStatus::Pending;
+	shared<std::atomic<bool>> cancelled = mCancelled;
+	thumbnail.image = mPool->Enqueue([path, cancelled]()
+		{
+			return Make(path, *cancelled);
+		});
+	++mPendingCount;
+}
+
+void ThumbnailCache::Clear()
+{
+	mCancelled->store(true);
+	mCancelled = std::make_shared<std::atomic<bool>>(false);
+	mThumbnails.clear();
+	mPaths.clear();
+	mPendingCount = 0;
+	mAtlas.Clear();
+}
+
+void ThumbnailCache::ProcessPendingUploads(sf::Time budget)
+{
+	sf::Clock uploadClock;
+	bool uploaded = false;
+	for (auto& pair : mThumbnails)
+	{
+		Thumbnail& thumbnail = pair.second;
+		if (thumbnail.status != TextureStatus::Pending)
+		{
+			continue;
+		}
+		if (uploaded && uploadClock.getElapsedTime() >= budget)
+		{
+			break;
+		}
+		if (thumbnail.image.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			continue;
+		}
+		std::optional<sf::Image> image = thumbnail.image.get();
+		--mPendingCount;
+		uploaded = true;
+		sf::Texture texture;
+		if (image.has_value() && texture.loadFromImage(image.value()) && mAtlas.Insert(pair.first, texture))
+		{
+			const AtlasRegion* region = mAtlas.GetRegion(pair.first);
+			thumbnail.sprite.emplace(mAtlas.GetPage(region->page), region->rect);
+			thumbnail.status = TextureStatus::Ready;
+		}
+		else
+		{
+			thumbnail.status = TextureStatus::Failed;
+		}
+	}
+	for (const std::string& moved : mAtlas.TakeMovedRegions())
+	{
+		auto found = mThumbnails.find(moved);
+		const AtlasRegion* region = mAtlas.GetRegion(moved);
+		if (found != mThumbnails.end() && found->second.sprite && region)
+		{
+			found->second.sprite->setTexture(mAtlas.GetPage(region->page));
+			found->second.sprite->setTextureRect(region->rect);
+		}
+	}
+}
+
+TextureStatus ThumbnailCache::GetStatus(const std::string& name) const
+{
+	const Thumbnail* thumbnail = Find(name);
+	return thumbnail ? thumbnail->status : TextureStatus::Missing;
+}
+
+const sf::Sprite* ThumbnailCache::GetSprite(const std::string& name) const
+{
+	const Thumbnail* thumbnail = Find(name);
+	return thumbnail && thumbnail->sprite ? &thumbnail->sprite.value() : nullptr;
+}
+
+const ThumbnailCache::Thumbnail* ThumbnailCache::Find(const std::string& name) const
+{
+	auto path = mPaths.find(name);
+	if (path == mPaths.end())
+	{
+		return nullptr;
+	}
+	auto found = mThumbnails.find(path->second);
+	return found != mThumbnails.end() ? &found->second : nullptr;
+}
+
+std::optional<sf::Image> ThumbnailCache::Make(const std::string& path, const std::atomic<bool>& cancelled)
+{
+	PROFILE_ZONE("Make thumbnail");
+	namespace fs = std::filesystem;
+	std::error_code error;
+	fs::path absolute = fs::absolute(path, error);
+	if (error)
+	{
+		absolute = path;
+	}
+	const fs::file_time_type modified = fs::last_write_time(absolute, error);
+	if (error || cancelled)
+	{
+		return std::nullopt;
+	}
+	// A changed image gets a new name; the thumbnails of its older versions are removed.
+	const std::string prefix = HashPath(absolute.string()) + "_";
+	std::ostringstream name;
+	name << prefix << std::hex << modified.time_since_epoch().count() << ".png";
+	const fs::path directory = absolute.parent_path() / kCacheDirectory / "thumbnails";
+	const fs::path cachePath = directory / name.str();
+
+	sf::Image thumbnail;
+	if (fs::exists(cachePath, error) && thumbnail.loadFromFile(cachePath))
+	{
+		return thumbnail;
+	}
+	sf::Image source;
+	if (!source.loadFromFile(absolute) || cancelled)
+	{
+		return std::nullopt;
+	}
+	thumbnail = Downscale(source, kThumbnailSize);
+
+	fs::create_directories(directory, error);
+	for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+	{
+		const std::string file = it->path().filename().string();
+		if (file.compare(0, prefix.size(), prefix) == 0 && it->path() != cachePath)
+		{
+			std::error_code removeError;
+			fs::remove(it->path(), removeError);
+		}
+	}
+	// Written under another name first, so a cached thumbnail is never half written.
+	const fs::path temporaryPath = directory / (name.str() + ".tmp.png");
+	if (thumbnail.saveToFile(temporaryPath))
+	{
+		fs::rename(temporaryPath, cachePath, error);
+	}
+	return thumbnail;
+}
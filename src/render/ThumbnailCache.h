@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <optional>
+#include <string>
+#include <SFML/Graphics.hpp>
+#include "core/ThreadPool.h"
+#include "core/Utils.h"
+#include "project/AssetManager.h"
+#include "project/TextureAtlas.h"
+
+namespace vle {
+	// Small previews of asset images for the library, independent of the full textures.
+	// Each is made on a worker by area-averaging the image down to kThumbnailSize, and
+	// kept in the .vle_cache directory next to the image under a name derived from the
+	// image's path and modification time, so reopening a project only decodes the
+	// thumbnails. All of them share one atlas, and each is shown through a sprite that
+	// lives as long as the thumbnail.
+	class ThumbnailCache
+	{
+	public:
+		static constexpr unsigned int kThumbnailSize = 128;
+
+		ThumbnailCache();
+		// Cancels the thumbnails still being made and waits for their workers.
+		~ThumbnailCache();
+
+		ThumbnailCache(const ThumbnailCache&) = delete;
+		ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+		// Shows the thumbnail of the image at path for name, making it unless another name has.
+		void Request(const std::string& name, const std::string& path);
+		void Clear();
+		// Packs finished thumbnails until the budget is spent, at least one per call.
+		void ProcessPendingUploads(sf::Time budget);
+		bool HasPendingThumbnails() const { return mPendingCount > 0; }
+
+		TextureStatus GetStatus(const std::string& name) const;
+		// Null until the thumbnail is ready.
+		const sf::Sprite* GetSprite(const std::string& name) const;
+
+	private:
+		struct Thumbnail
+		{
+			TextureStatus status = TextureStatus::Missing;
+			std::optional<sf::Sprite> sprite;
+			std::future<std::optional<sf::Image>> image;
+		};
+
+		static std::optional<sf::Image> Make(const std::string& path, const std::atomic<bool>& cancelled);
+		const Thumbnail* Find(const std::string& name) const;
+
+		// Keyed by image path; names map onto them.
+		Dictionary<std::string, Thumbnail> mThumbnails;
+		Dictionary<std::string, std::string> mPaths;
+		size_t mPendingCount;
+		TextureAtlas mAtlas;
+		// Replaced by Clear, so the jobs of a closed project see theirs set.
+		shared<std::atomic<bool>> mCancelled;
+		unique<ThreadPool> mPool;
+	};
+}
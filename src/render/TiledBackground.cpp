@@ -0,0 +1,498 @@
+#include "TiledBackground.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "core/Hash.h"
+#include "core/Profiler.h"
+#include "io/BinaryIO.h"
+
+using namespace vle;
+
+namespace
+{
+	const char kInfoFile[] = "pyramid.info";
+	const char kMagic[4] = { 'V', 'L', 'E', 'T' };
+	const uint32_t kVersion = 1;
+	// Tiles decoding at once; more are requested as these arrive.
+	const size_t kMaxPendingTiles = 16;
+	const unsigned int kDecodeThreads = 2;
+
+	// What identifies the source image a pyramid was cut from.
+	struct PyramidInfo
+	{
+		std::uintmax_t sourceSize = 0;
+		int64_t sourceTime = 0;
+		uint32_t tileSize = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t levelCount = 0;
+	};
+
+	bool ReadInfo(const std::string& path, PyramidInfo& info)
+	{
+		std::ifstream file(path, std::ios::binary);
+		char magic[sizeof(kMagic)];
+		uint32_t version = 0;
+		return file.is_open() && file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(magic)) == 0 &&
+			Read(file, version) && version == kVersion && Read(file, info.sourceSize) && Read(file, info.sourceTime) &&
+			Read(file, info.tileSize) && Read(file, info.width) && Read(file, info.height) && Read(file, info.levelCount);
+	}
+
+	// Written last, under a temporary name, so a pyramid whose info file exists is complete.
+	bool WriteInfo(const std::string& path, const PyramidInfo& info)
+	{
+		const std::string temporaryPath = path + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				return false;
+			}
+			file.write(kMagic, sizeof(kMagic));
+			Write(file, kVersion);
+			Write(file, info.sourceSize);
+			Write(file, info.sourceTime);
+			Write(file, info.tileSize);
+			Write(file, info.width);
+			Write(file, info.height);
+			Write(file, info.levelCount);
+			if (!file)
+			{
+				return false;
+			}
+		}
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, path, error);
+		return !error;
+	}
+
+	// One directory per image path; a changed image replaces its pyramid.
+	std::string PyramidDirectory(const std::string& imagePath)
+	{
+		namespace fs = std::filesystem;
+		std::error_code error;
+		fs::path absolute = fs::absolute(imagePath, error);
+		if (error)
+		{
+			absolute = imagePath;
+		}
+		std::ostringstream name;
+		name << std::hex << Fnv1a(absolute.string());
+		return (absolute.parent_path() / kCacheDirectory / "tiles" / name.str()).string();
+	}
+
+	// Halves the image, averaging each 2x2 block; odd edges repeat their last pixel.
+	sf::Image Downsample(const sf::Image& source)
+	{
+		const sf::Vector2u size = source.getSize();
+		const sf::Vector2u half{ (size.x + 1) / 2, (size.y + 1) / 2 };
+		const std::uint8_t* pixels = source.getPixelsPtr();
+		List<std::uint8_t> result(static_cast<size_t>(half.x) * half.y * 4);
+		for (unsigned int y = 0; y < half.y; y++)
+		{
+			const size_t row0 = static_cast<size_t>(y * 2) * size.x;
+			const size_t row1 = static_cast<size_t>(std::min(y * 2 + 1, size.y - 1)) * size.x;
+			for (unsigned int x = 0; x < half.x; x++)
+			{
+				const size_t column0 = x * 2;
+				const size_t column1 = std::min(x * 2 + 1, size.x - 1);
+				const std::uint8_t* a = pixels + (row0 + column0) * 4;
+				const std::uint8_t* b = pixels + (row0 + column1) * 4;
+				const std::uint8_t* c = pixels + (row1 + column0) * 4;
+				const std::uint8_t* d = pixels + (row1 + column1) * 4;
+				std::uint8_t* out = result.data() + (static_cast<size_t>(y) * half.x + x) * 4;
+				for (int channel = 0; channel < 4; channel++)
+				{
+					out[channel] = static_cast<std::uint8_t>((a[channel] + b[channel] + c[channel] + d[channel] + 2) / 4);
+				}
+			}
+		}
+		return sf::Image(half, result.data());
+	}
+}
+
+TiledBackground::TiledBackground()
+	: mSize{ 0, 0 },
+	mLevelCount{ 0 },
+	mResidentCount{ 0 },
+	mPendingCount{ 0 },
+	mMaxResidentTiles{ kDefaultMaxResidentTiles },
+	mFrame{ 0 },
+	mDirty{ true },
+	mOpened{ false },
+	mDecodePool{ std::make_unique<ThreadPool>(kDecodeThreads) },
+	mBuildFinished{ false },
+	mCancelled{ false }
+{
+}
+
+TiledBackground::~TiledBackground()
+{
+	Clear();
+}
+
+void TiledBackground::Load(const std::string& imagePath)
+{
+	Clear();
+	mBuildFinished = false;
+	mBuildThread = std::thread(&TiledBackground::Build, this, imagePath);
+}
+
+void TiledBackground::Clear()
+{
+	if (mBuildThread.joinable())
+	{
+		mCancelled = true;
+		mBuildThread.join();
+		mCancelled = false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mBuildMutex);
+		mBuilt.reset();
+	}
+	// Decodes still running finish on their worker and their results are dropped.
+	mTiles.clear();
+	mFallbackTiles.clear();
+	mDrawnTiles.clear();
+	mDirectory.clear();
+	mSize = { 0, 0 };
+	mLevelCount = 0;
+	mResidentCount = 0;
+	mPendingCount = 0;
+	mOpened = false;
+	mDirty = true;
+}
+
+void TiledBackground::ProcessPendingUploads(sf::Time budget)
+{
+	if (mBuildThread.joinable() && mBuildFinished)
+	{
+		mBuildThread.join();
+		std::lock_guard<std::mutex> lock(mBuildMutex);
+		if (mBuilt.has_value())
+		{
+			mDirectory = mBuilt->directory;
+			mSize = mBuilt->size;
+			mLevelCount = mBuilt->levelCount;
+			mOpened = true;
+			mDirty = true;
+			mBuilt.reset();
+		}
+	}
+	if (mPendingCount == 0)
+	{
+		return;
+	}
+
+	sf::Clock uploadClock;
+	bool uploaded = false;
+	for (auto& tilePair : mTiles)
+	{
+		Tile& tile = tilePair.second;
+		if (!tile.pending)
+		{
+			continue;
+		}
+		if (uploaded && uploadClock.getElapsedTime() >= budget)
+		{
+			break;
+		}
+		if (tile.image.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			continue;
+		}
+		std::optional<sf::Image> image = tile.image.get();
+		tile.pending = false;
+		mPendingCount--;
+		auto texture = std::make_unique<sf::Texture>();
+		if (image.has_value() && texture->loadFromImage(image.value()))
+		{
+			tile.texture = std::move(texture);
+			mResidentCount++;
+		}
+		else
+		{
+			tile.failed = true;
+		}
+		uploaded = true;
+		mDirty = true;
+	}
+}
+
+bool TiledBackground::TakeOpened()
+{
+	const bool opened = mOpened;
+	mOpened = false;
+	return opened;
+}
+
+void TiledBackground::Update(const sf::FloatRect& viewArea, float worldUnitsPerPixel)
+{
+	mFrame++;
+	mDirty = false;
+	mFallbackTiles.clear();
+	mDrawnTiles.clear();
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	// The coarsest level that still has at least one texel per screen pixel.
+	unsigned int level = 0;
+	for (float scale = worldUnitsPerPixel; scale >= 2.f && level + 1 < mLevelCount; scale /= 2.f)
+	{
+		level++;
+	}
+
+	const unsigned int topLevel = mLevelCount - 1;
+	if (Tile* top = Request(topLevel, 0, 0))
+	{
+		top->lastDrawn = mFrame;
+	}
+
+	const float tileExtent = static_cast<float>(kTileSize << level);
+	const sf::Vector2u tileCount = GetTileCount(level);
+	const float left = std::max(0.f, viewArea.position.x / tileExtent);
+	const float top = std::max(0.f, viewArea.position.y / tileExtent);
+	const float right = (viewArea.position.x + viewArea.size.x) / tileExtent;
+	const float bottom = (viewArea.position.y + viewArea.size.y) / tileExtent;
+	if (right < 0.f || bottom < 0.f)
+	{
+		return;
+	}
+	const unsigned int firstX = static_cast<unsigned int>(left);
+	const unsigned int firstY = static_cast<unsigned int>(top);
+	const unsigned int lastX = std::min(tileCount.x - 1, static_cast<unsigned int>(right));
+	const unsigned int lastY = std::min(tileCount.y - 1, static_cast<unsigned int>(bottom));
+
+	Set<std::uint64_t> fallbacks;
+	for (unsigned int y = firstY; y <= lastY && firstX <= lastX; y++)
+	{
+		for (unsigned int x = firstX; x <= lastX; x++)
+		{
+			if (Tile* tile = Request(level, x, y))
+			{
+				AddDrawnTile(*tile, level, x, y, mDrawnTiles);
+				continue;
+			}
+			unsigned int coarseX = x >> 1;
+			unsigned int coarseY = y >> 1;
+			for (unsigned int coarse = level + 1; coarse < mLevelCount; coarse++, coarseX >>= 1, coarseY >>= 1)
+			{
+				auto found = mTiles.find(TileKey(coarse, coarseX, coarseY));
+				if (found != mTiles.end() && found->second.texture)
+				{
+					if (fallbacks.insert(found->first).second)
+					{
+						AddDrawnTile(found->second, coarse, coarseX, coarseY, mFallbackTiles);
+					}
+					break;
+				}
+			}
+		}
+	}
+	// Coarser stand-ins first, so finer tiles that already arrived are drawn over them.
+	std::sort(mFallbackTiles.begin(), mFallbackTiles.end(), [](const DrawnTile& a, const DrawnTile& b) { return a.scale > b.scale; });
+	Evict();
+}
+
+bool TiledBackground::IsStreaming() const
+{
+	return mBuildThread.joinable() || mPendingCount > 0;
+}
+
+std::uint64_t TiledBackground::TileKey(unsigned int level, unsigned int x, unsigned int y)
+{
+	return (static_cast<std::uint64_t>(level) << 48) | (static_cast<std::uint64_t>(y) << 24) | x;
+}
+
+std::string TiledBackground::TilePath(const std::string& directory, unsigned int level, unsigned int x, unsigned int y)
+{
+	return (std::filesystem::path(directory) / (std::to_string(level) + "_" + std::to_string(x) + "_" + std::to_string(y) + ".png")).string();
+}
+
+sf::Vector2u TiledBackground::GetTileCount(unsigned int level) const
+{
+	const unsigned int extent = kTileSize << level;
+	return { (mSize.x + extent - 1) / extent, (mSize.y + extent - 1) / extent };
+}
+
+TiledBackground::Tile* TiledBackground::Request(unsigned int level, unsigned int x, unsigned int y)
+{
+	const std::uint64_t key = TileKey(level, x, y);
+	auto found = mTiles.find(key);
+	if (found != mTiles.end())
+	{
+		return found->second.texture ? &found->second : nullptr;
+	}
+	if (mPendingCount >= kMaxPendingTiles)
+	{
+		return nullptr;
+	}
+	Tile& tile = mTiles[key];
+	const std::string path = TilePath(mDirectory, level, x, y);
+	tile.image = mDecodePool->Enqueue([path]() -> std::optional<sf::Image>
+		{
+			PROFILE_ZONE("Decode tile");
+			sf::Image image;
+			if (!image.loadFromFile(path))
+			{
+				return std::nullopt;
+			}
+			return image;
+		});
+	tile.pending = true;
+	mPendingCount++;
+	return nullptr;
+}
+
+void TiledBackground::AddDrawnTile(Tile& tile, unsigned int level, unsigned int x, unsigned int y, List<DrawnTile>& drawn)
+{
+	tile.lastDrawn = mFrame;
+	const float scale = static_cast<float>(1u << level);
+	const float extent = static_cast<float>(kTileSize) * scale;
+	drawn.push_back(DrawnTile{ tile.texture.get(), { x * extent, y * extent }, scale });
+}
+
+void TiledBackground::Evict()
+{
+	if (mResidentCount <= mMaxResidentTiles)
+	{
+		return;
+	}
+	const std::uint64_t topKey = TileKey(mLevelCount - 1, 0, 0);
+	List<std::pair<std::uint64_t, std::uint64_t>> candidates;
+	for (const auto& tilePair : mTiles)
+	{
+		if (tilePair.second.texture && tilePair.second.lastDrawn < mFrame && tilePair.first != topKey)
+		{
+			candidates.emplace_back(tilePair.second.lastDrawn, tilePair.first);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+	for (const auto& candidate : candidates)
+	{
+		if (mResidentCount <= mMaxResidentTiles)
+		{
+			break;
+		}
+		mTiles.erase(candidate.second);
+		mResidentCount--;
+	}
+}
+
+void TiledBackground::Build(std::string imagePath)
+{
+	Profiler::SetThreadName("Background build");
+	PROFILE_ZONE("Build tile pyramid");
+	namespace fs = std::filesystem;
+	std::error_code error;
+	PyramidInfo source;
+	source.sourceSize = fs::file_size(imagePath, error);
+	if (!error)
+	{
+		source.sourceTime = static_cast<int64_t>(fs::last_write_time(imagePath, error).time_since_epoch().count());
+	}
+	if (error)
+	{
+		std::cerr << "Error: cannot read background image " << imagePath << std::endl;
+		mBuildFinished = true;
+		return;
+	}
+
+	const std::string directory = PyramidDirectory(imagePath);
+	const std::string infoPath = (fs::path(directory) / kInfoFile).string();
+	PyramidInfo info;
+	if (!ReadInfo(infoPath, info) || info.sourceSize != source.sourceSize || info.sourceTime != source.sourceTime ||
+		info.tileSize != kTileSize)
+	{
+		info = source;
+		info.tileSize = kTileSize;
+		sf::Image image;
+		fs::remove_all(directory, error);
+		fs::create_directories(directory, error);
+		if (error || !image.loadFromFile(imagePath))
+		{
+			std::cerr << "Error: cannot cut background image " << imagePath << " into tiles" << std::endl;
+			mBuildFinished = true;
+			return;
+		}
+		info.width = image.getSize().x;
+		info.height = image.getSize().y;
+		info.levelCount = 0;
+
+		ThreadPool pool;
+		while (!mCancelled)
+		{
+			const sf::Vector2u size = image.getSize();
+			const unsigned int tilesX = (size.x + kTileSize - 1) / kTileSize;
+			const unsigned int tilesY = (size.y + kTileSize - 1) / kTileSize;
+			List<std::future<bool>> tiles;
+			tiles.reserve(tilesX * tilesY);
+			for (unsigned int y = 0; y < tilesY; y++)
+			{
+				for (unsigned int x = 0; x < tilesX; x++)
+				{
+					tiles.push_back(pool.Enqueue([this, &image, &directory, &info, x, y, size]()
+						{
+							if (mCancelled)
+							{
+								return false;
+							}
+							const sf::Vector2u origin{ x * kTileSize, y * kTileSize };
+							const sf::Vector2u extent{ std::min(kTileSize, size.x - origin.x), std::min(kTileSize, size.y - origin.y) };
+							sf::Image tile(extent);
+							(void)tile.copy(image, { 0, 0 }, sf::IntRect(sf::Vector2i(origin), sf::Vector2i(extent)));
+							return tile.saveToFile(TilePath(directory, info.levelCount, x, y));
+						}));
+				}
+			}
+			bool written = true;
+			for (std::future<bool>& tile : tiles)
+			{
+				written = tile.get() && written;
+			}
+			if (!written)
+			{
+				if (!mCancelled)
+				{
+					std::cerr << "Error: cannot write background tiles to " << directory << std::endl;
+				}
+				mBuildFinished = true;
+				return;
+			}
+			info.levelCount++;
+			if (size.x <= kTileSize && size.y <= kTileSize)
+			{
+				break;
+			}
+			image = Downsample(image);
+		}
+		if (mCancelled || !WriteInfo(infoPath, info))
+		{
+			mBuildFinished = true;
+			return;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mBuildMutex);
+	mBuilt = Pyramid{ directory, { info.width, info.height }, info.levelCount };
+	mBuildFinished = true;
+}
+
+void TiledBackground::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	for (const List<DrawnTile>* tiles : { &mFallbackTiles, &mDrawnTiles })
+	{
+		for (const DrawnTile& tile : *tiles)
+		{
+			sf::Sprite sprite(*tile.texture);
+			sprite.setPosition(tile.position);
+			sprite.setScale({ tile.scale, tile.scale });
+			target.draw(sprite, states);
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <SFML/Graphics.hpp>
+#include "core/ThreadPool.h"
+#include "core/Utils.h"
+
+namespace vle {
+	// Draws a background image of any size from a pyramid of tiles: level 0 holds the
+	// image at full resolution, every level above it half the one below, up to a level
+	// that fits in a single tile. The pyramid is cut once, on a background thread, into
+	// the .vle_cache directory next to the image. After that only the tiles the view
+	// needs are decoded and uploaded, at the level matching the zoom, and the least
+	// recently drawn ones are released once more than the resident limit are loaded.
+	// Until a tile arrives the closest coarser tile already loaded is drawn in its place.
+	class TiledBackground : public sf::Drawable
+	{
+	public:
+		static constexpr unsigned int kTileSize = 512;
+		static constexpr size_t kDefaultMaxResidentTiles = 192;
+
+		TiledBackground();
+		// Cancels a pyramid still being cut and waits for it.
+		~TiledBackground();
+
+		TiledBackground(const TiledBackground&) = delete;
+		TiledBackground& operator=(const TiledBackground&) = delete;
+
+		// Drops the current image and starts opening, or cutting, the pyramid of imagePath.
+		void Load(const std::string& imagePath);
+		void Clear();
+		// Uploads decoded tiles until the budget is spent, at least one per call.
+		void ProcessPendingUploads(sf::Time budget);
+		// True once after the pyramid of the last Load became available.
+		bool TakeOpened();
+		// Picks the level for the zoom and the tiles covering viewArea, requesting the missing ones.
+		void Update(const sf::FloatRect& viewArea, float worldUnitsPerPixel);
+		// True when the next Update will change what is drawn.
+		bool IsDirty() const { return mDirty; }
+		// A pyramid is being cut or tiles are on their way.
+		bool IsStreaming() const;
+
+		sf::Vector2u GetSize() const { return mSize; }
+		bool IsOpen() const { return mLevelCount > 0; }
+		size_t GetResidentTileCount() const { return mResidentCount; }
+		void SetMaxResidentTiles(size_t count) { mMaxResidentTiles = count; }
+
+	private:
+		struct Tile
+		{
+			unique<sf::Texture> texture;
+			std::future<std::optional<sf::Image>> image;
+			bool pending = false;
+			bool failed = false;
+			std::uint64_t lastDrawn = 0;
+		};
+
+		struct DrawnTile
+		{
+			const sf::Texture* texture;
+			sf::Vector2f position;
+			float scale;
+		};
+
+		struct Pyramid
+		{
+			std::string directory;
+			sf::Vector2u size;
+			unsigned int levelCount = 0;
+		};
+
+		static std::uint64_t TileKey(unsigned int level, unsigned int x, unsigned int y);
+		static std::string TilePath(const std::string& directory, unsigned int level, unsigned int x, unsigned int y);
+		sf::Vector2u GetTileCount(unsigned int level) const;
+		// Requests the tile if it is not loaded; returns it when it can be drawn.
+		Tile* Request(unsigned int level, unsigned int x, unsigned int y);
+		void AddDrawnTile(Tile& tile, unsigned int level, unsigned int x, unsigned int y, List<DrawnTile>& drawn);
+		void Evict();
+		void Build(std::string imagePath);
+
+		void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+		std::string mDirectory;
+		sf::Vector2u mSize;
+		unsigned int mLevelCount;
+		Dictionary<std::uint64_t, Tile> mTiles;
+		size_t mResidentCount;
+		size_t mPendingCount;
+		size_t mMaxResidentTiles;
+		std::uint64_t mFrame;
+		List<DrawnTile> mFallbackTiles;
+		List<DrawnTile> mDrawnTiles;
+		bool mDirty;
+		bool mOpened;
+		unique<ThreadPool> mDecodePool;
+
+		std::thread mBuildThread;
+		std::atomic<bool> mBuildFinished;
+		std::atomic<bool> mCancelled;
+		std::mutex mBuildMutex;
+		std::optional<Pyramid> mBuilt;
+	};
+}